@@ -0,0 +1,217 @@
+#include "concurrent_search_server.h"
+#include "search_server.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+using Clock = chrono::steady_clock;
+
+string GenerateWord(mt19937& generator, int max_length) {
+    const int length = uniform_int_distribution(1, max_length)(generator);
+    string word;
+    word.reserve(length);
+    for (int i = 0; i < length; ++i) {
+        word.push_back(uniform_int_distribution('a', 'z')(generator));
+    }
+    return word;
+}
+
+vector<string> GenerateDictionary(mt19937& generator, int word_count, int max_length) {
+    vector<string> words;
+    words.reserve(word_count);
+    for (int i = 0; i < word_count; ++i) {
+        words.push_back(GenerateWord(generator, max_length));
+    }
+    return words;
+}
+
+string GenerateQuery(mt19937& generator, const vector<string>& dictionary, int word_count) {
+    string query;
+    for (int i = 0; i < word_count; ++i) {
+        if (!query.empty()) {
+            query.push_back(' ');
+        }
+        query += dictionary[uniform_int_distribution<size_t>(0, dictionary.size() - 1)(generator)];
+    }
+    return query;
+}
+
+vector<string> GenerateQueries(mt19937& generator, const vector<string>& dictionary, int query_count, int max_word_count) {
+    vector<string> queries;
+    queries.reserve(query_count);
+    for (int i = 0; i < query_count; ++i) {
+        queries.push_back(GenerateQuery(generator, dictionary, max_word_count));
+    }
+    return queries;
+}
+
+// The baseline: one server behind a global reader-writer lock
+class LockedSearchServer {
+public:
+    explicit LockedSearchServer(const string& stop_words)
+        : server_(stop_words) {}
+
+    void AddDocument(int document_id, string_view document, DocumentStatus status, const vector<int>& ratings) {
+        unique_lock lock(mutex_);
+        server_.AddDocument(document_id, document, status, ratings);
+    }
+
+    vector<Document> FindTopDocuments(string_view raw_query) const {
+        shared_lock lock(mutex_);
+        return server_.FindTopDocuments(raw_query);
+    }
+
+    tuple<vector<string>, DocumentStatus> MatchDocument(string_view raw_query, int document_id) const {
+        shared_lock lock(mutex_);
+        return server_.MatchDocument(raw_query, document_id);
+    }
+
+    int GetDocumentCount() const {
+        shared_lock lock(mutex_);
+        return server_.GetDocumentCount();
+    }
+
+private:
+    SearchServer server_;
+    mutable shared_mutex mutex_;
+};
+
+bool AreSame(const vector<Document>& lhs, const vector<Document>& rhs) {
+    return equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](const Document& lhs, const Document& rhs) {
+        return lhs.id == rhs.id && lhs.relevance == rhs.relevance && lhs.rating == rhs.rating;
+    });
+}
+
+struct RunResult {
+    vector<double> latencies_us;
+    double write_duration_ms = 0.0;
+};
+
+double GetPercentile(const vector<double>& sorted_values, double percentile) {
+    if (sorted_values.empty()) {
+        return 0.0;
+    }
+    const size_t index = static_cast<size_t>(percentile / 100.0 * static_cast<double>(sorted_values.size() - 1));
+    return sorted_values[index];
+}
+
+// Readers query the server until the writer has added all documents. Every reader
+// checks that the document count it sees never goes down and that the documents
+// it finds are counted
+template <typename Server>
+RunResult Run(Server& server, int reader_count, const vector<string>& documents, int initial_document_count,
+              const vector<string>& queries) {
+    atomic<bool> is_writing{true};
+    vector<vector<double>> reader_latencies(reader_count);
+    vector<thread> readers;
+    for (int reader = 0; reader < reader_count; ++reader) {
+        readers.emplace_back([&, reader] {
+            int last_document_count = 0;
+            for (size_t i = reader; is_writing.load(); i += reader_count) {
+                const string& query = queries[i % queries.size()];
+                const auto start = Clock::now();
+                const auto found_documents = server.FindTopDocuments(query);
+                const auto status = get<1>(server.MatchDocument(query, 0));
+                const int document_count = server.GetDocumentCount();
+                const auto finish = Clock::now();
+                reader_latencies[reader].push_back(chrono::duration<double, micro>(finish - start).count());
+
+                if (document_count < last_document_count) {
+                    throw logic_error("Reader saw the index go back"s);
+                }
+                if (status != DocumentStatus::ACTUAL) {
+                    throw logic_error("Reader lost the first document"s);
+                }
+                last_document_count = document_count;
+                for (const Document& document : found_documents) {
+                    if (document.id >= document_count) {
+                        throw logic_error("Reader saw a document that is not counted"s);
+                    }
+                }
+            }
+        });
+    }
+
+    const auto write_start = Clock::now();
+    for (int id = initial_document_count; id < static_cast<int>(documents.size()); ++id) {
+        server.AddDocument(id, documents[id], DocumentStatus::ACTUAL, {1, 2, 3});
+        // Paces the writer, so that both servers face the same write rate
+        this_thread::sleep_until(write_start + chrono::microseconds(200) * (id - initial_document_count + 1));
+    }
+    const auto write_finish = Clock::now();
+    is_writing.store(false);
+    for (thread& reader : readers) {
+        reader.join();
+    }
+
+    RunResult result;
+    result.write_duration_ms = chrono::duration<double, milli>(write_finish - write_start).count();
+    for (const auto& latencies : reader_latencies) {
+        result.latencies_us.insert(result.latencies_us.end(), latencies.begin(), latencies.end());
+    }
+    sort(result.latencies_us.begin(), result.latencies_us.end());
+    return result;
+}
+
+void PrintResult(const string& name, int reader_count, const RunResult& result) {
+    cout << name << ", "s << reader_count << " readers: "s
+         << result.latencies_us.size() << " queries, "s
+         << "p50 "s << GetPercentile(result.latencies_us, 50.0) << " us, "s
+         << "p99 "s << GetPercentile(result.latencies_us, 99.0) << " us, "s
+         << "max "s << (result.latencies_us.empty() ? 0.0 : result.latencies_us.back()) << " us, "s
+         << "writes took "s << result.write_duration_ms << " ms"s << endl;
+}
+
+}  // namespace
+
+int main() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 2'000, 25);
+    const auto documents = GenerateQueries(generator, dictionary, 25'000, 10);
+    const auto queries = GenerateQueries(generator, dictionary, 2'000, 7);
+    const int initial_document_count = 20'000;
+
+    const int max_reader_count = static_cast<int>(max(2u, thread::hardware_concurrency()) - 1);
+    for (int reader_count = 1; reader_count <= max_reader_count; reader_count *= 2) {
+        {
+            LockedSearchServer server(dictionary[0]);
+            for (int id = 0; id < initial_document_count; ++id) {
+                server.AddDocument(id, documents[id], DocumentStatus::ACTUAL, {1, 2, 3});
+            }
+            PrintResult("shared_mutex"s, reader_count, Run(server, reader_count, documents, initial_document_count, queries));
+        }
+        {
+            ConcurrentSearchServer server(dictionary[0]);
+            for (int id = 0; id < initial_document_count; ++id) {
+                server.AddDocument(id, documents[id], DocumentStatus::ACTUAL, {1, 2, 3});
+            }
+            PrintResult("ConcurrentSearchServer"s, reader_count, Run(server, reader_count, documents, initial_document_count, queries));
+
+            // Both copies of the index must have ended up the same
+            SearchServer reference(dictionary[0]);
+            for (int id = 0; id < static_cast<int>(documents.size()); ++id) {
+                reference.AddDocument(id, documents[id], DocumentStatus::ACTUAL, {1, 2, 3});
+            }
+            for (int i = 0; i < 2; ++i) {
+                for (const string& query : queries) {
+                    if (!AreSame(server.FindTopDocuments(query), reference.FindTopDocuments(query))) {
+                        throw logic_error("Copies of the index differ"s);
+                    }
+                }
+                server.RemoveDocument(static_cast<int>(documents.size()) - 1 - i);
+                reference.RemoveDocument(static_cast<int>(documents.size()) - 1 - i);
+            }
+        }
+    }
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "document.h"
+
+enum class LengthDistribution {
+    UNIFORM,  // between the minimum and the maximum length
+    POISSON,  // around the mean length, clamped to the minimum and the maximum
+};
+
+struct CorpusOptions {
+    size_t vocabulary_size = 50'000;
+    // Word of rank r is drawn with probability proportional to 1 / r^zipf_exponent
+    double zipf_exponent = 1.0;
+    LengthDistribution length_distribution = LengthDistribution::POISSON;
+    int min_document_length = 1;
+    int max_document_length = 100;
+    double mean_document_length = 20.0;
+    // Relative weights of ACTUAL, IRRELEVANT, BANNED and REMOVED documents
+    std::array<double, 4> status_weights{85.0, 5.0, 5.0, 5.0};
+    // The most frequent words become stop words
+    size_t stop_word_count = 10;
+    uint32_t seed = 42;
+};
+
+// Generates documents and queries from a random vocabulary whose word
+// frequencies follow Zipf's law. The same options give the same corpus
+class CorpusGenerator {
+public:
+    explicit CorpusGenerator(const CorpusOptions& options);
+
+    // Ordered from the most to the least frequent word
+    const std::vector<std::string>& GetVocabulary() const;
+    std::vector<std::string> GetStopWords() const;
+
+    std::string GenerateDocument();
+    DocumentStatus GenerateStatus();
+    std::vector<int> GenerateRatings();
+    // Plus and minus words are drawn with the frequencies of the corpus
+    std::string GenerateQuery(int plus_word_count, int minus_word_count);
+
+private:
+    CorpusOptions options_;
+    std::mt19937 generator_;
+    std::vector<std::string> vocabulary_;
+    std::discrete_distribution<size_t> word_distribution_;
+    std::discrete_distribution<int> status_distribution_;
+
+    const std::string& DrawWord();
+    int DrawDocumentLength();
+};
+
+inline CorpusGenerator::CorpusGenerator(const CorpusOptions& options)
+    : options_(options),
+      generator_(options.seed),
+      status_distribution_(options.status_weights.begin(), options.status_weights.end()) {
+    using namespace std::literals;
+    if (options.vocabulary_size == 0 || options.stop_word_count >= options.vocabulary_size) {
+        throw std::invalid_argument("Vocabulary must have words besides stop words"s);
+    }
+    if (options.min_document_length < 0 || options.min_document_length > options.max_document_length) {
+        throw std::invalid_argument("Invalid document length range"s);
+    }
+
+    std::unordered_set<std::string> words;
+    std::uniform_int_distribution<int> length_distribution(2, 12);
+    std::uniform_int_distribution<int> letter_distribution('a', 'z');
+    vocabulary_.reserve(options.vocabulary_size);
+    while (vocabulary_.size() < options.vocabulary_size) {
+        std::string word(length_distribution(generator_), ' ');
+        for (char& c : word) {
+            c = static_cast<char>(letter_distribution(generator_));
+        }
+        if (words.insert(word).second) {
+            vocabulary_.push_back(std::move(word));
+        }
+    }
+
+    std::vector<double> weights(options.vocabulary_size);
+    for (size_t rank = 0; rank < weights.size(); ++rank) {
+        weights[rank] = 1.0 / std::pow(static_cast<double>(rank + 1), options.zipf_exponent);
+    }
+    word_distribution_ = std::discrete_distribution<size_t>(weights.begin(), weights.end());
+}
+
+inline const std::vector<std::string>& CorpusGenerator::GetVocabulary() const {
+    return vocabulary_;
+}
+
+inline std::vector<std::string> CorpusGenerator::GetStopWords() const {
+    return {vocabulary_.begin(), vocabulary_.begin() + options_.stop_word_count};
+}
+
+inline std::string CorpusGenerator::GenerateDocument() {
+    std::string document;
+    const int length = DrawDocumentLength();
+    for (int i = 0; i < length; ++i) {
+        if (i > 0) {
+            document.push_back(' ');
+        }
+        document += DrawWord();
+    }
+    return document;
+}
+
+inline DocumentStatus CorpusGenerator::GenerateStatus() {
+    return static_cast<DocumentStatus>(status_distribution_(generator_));
+}
+
+inline std::vector<int> CorpusGenerator::GenerateRatings() {
+    std::uniform_int_distribution<int> count_distribution(0, 5);
+    std::uniform_int_distribution<int> rating_distribution(-10, 10);
+    std::vector<int> ratings(count_distribution(generator_));
+    for (int& rating : ratings) {
+        rating = rating_distribution(generator_);
+    }
+    return ratings;
+}
+
+inline std::string CorpusGenerator::GenerateQuery(int plus_word_count, int minus_word_count) {
+    std::string query;
+    for (int i = 0; i < plus_word_count + minus_word_count; ++i) {
+        if (i > 0) {
+            query.push_back(' ');
+        }
+        if (i >= plus_word_count) {
+            query.push_back('-');
+        }
+        query += DrawWord();
+    }
+    return query;
+}
+
+inline const std::string& CorpusGenerator::DrawWord() {
+    return vocabulary_[word_distribution_(generator_)];
+}
+
+inline int CorpusGenerator::DrawDocumentLength() {
+    if (options_.length_distribution == LengthDistribution::UNIFORM) {
+        return std::uniform_int_distribution<int>(options_.min_document_length, options_.max_document_length)(generator_);
+    }
+    const int length = std::poisson_distribution<int>(options_.mean_document_length)(generator_);
+    return std::clamp(length, options_.min_document_length, options_.max_document_length);
+}
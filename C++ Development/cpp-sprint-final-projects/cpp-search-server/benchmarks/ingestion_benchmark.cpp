@@ -0,0 +1,72 @@
+#include "corpus_generator.h"
+#include "search_server.h"
+#include <tbb/global_control.h>
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const int DOCUMENT_COUNT = 1'000'000;
+
+struct Corpus {
+    vector<string> texts;
+    vector<DocumentInput> documents;
+    size_t byte_count = 0;
+};
+
+Corpus GenerateCorpus(CorpusGenerator& generator) {
+    Corpus corpus;
+    corpus.texts.reserve(DOCUMENT_COUNT);
+    for (int i = 0; i < DOCUMENT_COUNT; ++i) {
+        corpus.texts.push_back(generator.GenerateDocument());
+        corpus.byte_count += corpus.texts.back().size();
+    }
+    // The texts are not moved any more, so the documents may refer to them
+    for (int i = 0; i < DOCUMENT_COUNT; ++i) {
+        corpus.documents.push_back({i, corpus.texts[i], generator.GenerateStatus(), generator.GenerateRatings()});
+    }
+    return corpus;
+}
+
+template <typename AddDocuments>
+void MeasureIngestion(const string& name, const Corpus& corpus, const vector<string>& stop_words, AddDocuments add_documents) {
+    SearchServer search_server(stop_words);
+    const auto start = chrono::steady_clock::now();
+    add_documents(search_server);
+    const chrono::duration<double> seconds = chrono::steady_clock::now() - start;
+    cout << setw(24) << name << setw(12) << fixed << setprecision(2) << seconds.count()
+         << setw(14) << setprecision(0) << DOCUMENT_COUNT / seconds.count()
+         << setw(12) << setprecision(1) << corpus.byte_count / seconds.count() / (1 << 20) << endl;
+}
+
+}  // namespace
+
+int main() {
+    CorpusGenerator generator(CorpusOptions{});
+    const Corpus corpus = GenerateCorpus(generator);
+    const vector<string> stop_words = generator.GetStopWords();
+
+    cout << setw(24) << "ingestion"s << setw(12) << "seconds"s << setw(14) << "documents/s"s << setw(12) << "MiB/s"s << endl;
+    MeasureIngestion("AddDocument"s, corpus, stop_words, [&corpus](SearchServer& search_server) {
+        for (const DocumentInput& document : corpus.documents) {
+            search_server.AddDocument(document.id, document.text, document.status, document.ratings);
+        }
+    });
+    const size_t max_thread_count = max(1u, thread::hardware_concurrency());
+    for (size_t thread_count = 1;; thread_count = min(thread_count * 2, max_thread_count)) {
+        tbb::global_control thread_limit(tbb::global_control::max_allowed_parallelism, thread_count);
+        MeasureIngestion("AddDocuments ("s + to_string(thread_count) + " threads)"s, corpus, stop_words, [&corpus](SearchServer& search_server) {
+            search_server.AddDocuments(corpus.documents);
+        });
+        if (thread_count == max_thread_count) {
+            break;
+        }
+    }
+}
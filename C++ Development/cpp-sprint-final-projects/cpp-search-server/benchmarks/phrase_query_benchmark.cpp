@@ -0,0 +1,119 @@
+#include "corpus_generator.h"
+#include "log_duration.h"
+#include "search_server.h"
+#include "string_processing.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const int DOCUMENT_COUNT = 100'000;
+const int QUERY_COUNT = 1000;
+
+// Nearest-rank percentile of sorted samples
+double GetPercentile(const vector<double>& samples, double percentile) {
+    if (samples.empty()) {
+        return 0.0;
+    }
+    const size_t rank = static_cast<size_t>(ceil(percentile / 100.0 * static_cast<double>(samples.size())));
+    return samples[max<size_t>(rank, 1) - 1];
+}
+
+// Takes word_count consecutive words of random documents, so that every phrase is found at least once
+vector<vector<string>> DrawPhrases(const vector<string>& documents, int word_count, mt19937& generator) {
+    vector<vector<string>> phrases;
+    uniform_int_distribution<size_t> document_distribution(0, documents.size() - 1);
+    while (phrases.size() < static_cast<size_t>(QUERY_COUNT)) {
+        const auto words = SplitIntoWords(documents[document_distribution(generator)]);
+        if (words.size() < static_cast<size_t>(word_count)) {
+            continue;
+        }
+        const size_t begin = uniform_int_distribution<size_t>(0, words.size() - word_count)(generator);
+        phrases.emplace_back(words.begin() + begin, words.begin() + begin + word_count);
+    }
+    return phrases;
+}
+
+string JoinWords(const vector<string>& words) {
+    string text;
+    for (const string& word : words) {
+        if (!text.empty()) {
+            text += ' ';
+        }
+        text += word;
+    }
+    return text;
+}
+
+void MeasureQueries(const SearchServer& search_server, const string& name, const vector<string>& queries) {
+    vector<double> samples;
+    size_t result_count = 0;
+    for (const string& query : queries) {
+        RECORD_DURATION(samples);
+        result_count += search_server.FindTopDocuments(query).size();
+    }
+    sort(samples.begin(), samples.end());
+    cout << setw(24) << name << setw(12) << fixed << setprecision(1)
+         << accumulate(samples.begin(), samples.end(), 0.0) / samples.size()
+         << setw(12) << GetPercentile(samples, 50.0) << setw(12) << GetPercentile(samples, 99.0)
+         << setw(12) << setprecision(2) << result_count * 1.0 / queries.size() << endl;
+}
+
+}  // namespace
+
+int main() {
+    CorpusGenerator generator(CorpusOptions{});
+    vector<string> documents;
+    vector<DocumentStatus> statuses;
+    vector<vector<int>> ratings;
+    for (int i = 0; i < DOCUMENT_COUNT; ++i) {
+        documents.push_back(generator.GenerateDocument());
+        statuses.push_back(generator.GenerateStatus());
+        ratings.push_back(generator.GenerateRatings());
+    }
+
+    SearchServer plain_server(generator.GetStopWords());
+    SearchServer positional_server(generator.GetStopWords());
+    positional_server.EnablePositions();
+    for (SearchServer* search_server : {&plain_server, &positional_server}) {
+        LOG_DURATION(search_server == &plain_server ? "AddDocument without positions"s : "AddDocument with positions"s);
+        for (int i = 0; i < DOCUMENT_COUNT; ++i) {
+            search_server->AddDocument(i, documents[i], statuses[i], ratings[i]);
+        }
+    }
+
+    size_t word_count = 0;
+    for (const string& document : documents) {
+        word_count += SplitIntoWords(document).size();
+    }
+    const size_t position_memory = positional_server.GetPositionMemoryUsage();
+    cout << "Positions of "s << DOCUMENT_COUNT << " documents: "s << position_memory / 1024 << " KiB, "s
+         << fixed << setprecision(2) << position_memory * 1.0 / word_count << " bytes per word"s << endl << endl;
+
+    cout << setw(24) << "query"s << setw(12) << "mean us"s << setw(12) << "p50 us"s << setw(12) << "p99 us"s
+         << setw(12) << "results"s << endl;
+    mt19937 phrase_generator(42);
+    for (const int phrase_length : {2, 3}) {
+        vector<string> bag_queries;
+        vector<string> exact_queries;
+        vector<string> proximity_queries;
+        for (const auto& phrase : DrawPhrases(documents, phrase_length, phrase_generator)) {
+            const string words = JoinWords(phrase);
+            bag_queries.push_back(words);
+            exact_queries.push_back('"' + words + '"');
+            proximity_queries.push_back('"' + words + "\"~3"s);
+        }
+        const string suffix = " ("s + to_string(phrase_length) + " words)"s;
+        MeasureQueries(positional_server, "words"s + suffix, bag_queries);
+        MeasureQueries(positional_server, "phrase"s + suffix, exact_queries);
+        MeasureQueries(positional_server, "phrase~3"s + suffix, proximity_queries);
+    }
+}
@@ -0,0 +1,64 @@
+#include "posting_list.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+const size_t POSTING_COUNT = 1 << 20;
+const int DECODE_REPEAT_COUNT = 40;
+
+template <typename List>
+List BuildList(uint32_t average_gap) {
+    mt19937 generator(average_gap);
+    uniform_int_distribution<uint32_t> gap_distribution(1, 2 * average_gap - 1);
+    uniform_int_distribution<int> word_count_distribution(1, 100);
+    List list;
+    uint32_t ordinal = 0;
+    for (size_t i = 0; i < POSTING_COUNT; ++i) {
+        ordinal += gap_distribution(generator);
+        list.PushBack({ordinal, 1.0 / word_count_distribution(generator)});
+    }
+    return list;
+}
+
+// Returns decoded postings per second
+template <typename List>
+double MeasureDecoding(const List& list) {
+    using Clock = chrono::steady_clock;
+    double checksum = 0.0;
+    const auto start_time = Clock::now();
+    for (int i = 0; i < DECODE_REPEAT_COUNT; ++i) {
+        list.ForEach([&checksum](const Posting& posting) {
+            checksum += posting.document_ordinal * posting.term_freq;
+        });
+    }
+    const chrono::duration<double> duration = Clock::now() - start_time;
+    if (checksum < 0) {
+        cerr << checksum << endl;
+    }
+    return list.GetSize() * DECODE_REPEAT_COUNT / duration.count();
+}
+
+template <typename List>
+void Report(const string& name, uint32_t average_gap) {
+    const List list = BuildList<List>(average_gap);
+    cout << setw(12) << name << setw(12) << average_gap
+         << setw(18) << fixed << setprecision(2) << list.GetMemoryUsage() * 1.0 / list.GetSize()
+         << setw(22) << setprecision(1) << MeasureDecoding(list) / 1e6 << endl;
+}
+
+}  // namespace
+
+int main() {
+    cout << setw(12) << "list"s << setw(12) << "avg gap"s << setw(18) << "bytes/posting"s
+         << setw(22) << "M postings/s"s << endl;
+    for (const uint32_t average_gap : {1u, 8u, 64u, 1024u}) {
+        Report<PlainPostingList>("plain"s, average_gap);
+        Report<CompressedPostingList>("compressed"s, average_gap);
+    }
+}
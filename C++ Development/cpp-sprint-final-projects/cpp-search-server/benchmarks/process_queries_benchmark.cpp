@@ -0,0 +1,87 @@
+#include "log_duration.h"
+#include "process_queries.h"
+#include "search_server.h"
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+string GenerateWord(mt19937& generator, int max_length) {
+    const int length = uniform_int_distribution(1, max_length)(generator);
+    string word;
+    word.reserve(length);
+    for (int i = 0; i < length; ++i) {
+        word.push_back(uniform_int_distribution('a', 'z')(generator));
+    }
+    return word;
+}
+
+vector<string> GenerateDictionary(mt19937& generator, int word_count, int max_length) {
+    vector<string> words;
+    words.reserve(word_count);
+    for (int i = 0; i < word_count; ++i) {
+        words.push_back(GenerateWord(generator, max_length));
+    }
+    return words;
+}
+
+string GenerateQuery(mt19937& generator, const vector<string>& dictionary, int word_count) {
+    string query;
+    for (int i = 0; i < word_count; ++i) {
+        if (!query.empty()) {
+            query.push_back(' ');
+        }
+        query += dictionary[uniform_int_distribution<size_t>(0, dictionary.size() - 1)(generator)];
+    }
+    return query;
+}
+
+vector<string> GenerateQueries(mt19937& generator, const vector<string>& dictionary, int query_count, int max_word_count) {
+    vector<string> queries;
+    queries.reserve(query_count);
+    for (int i = 0; i < query_count; ++i) {
+        queries.push_back(GenerateQuery(generator, dictionary, max_word_count));
+    }
+    return queries;
+}
+
+}  // namespace
+
+int main() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 2'000, 25);
+    const auto documents = GenerateQueries(generator, dictionary, 20'000, 10);
+
+    SearchServer search_server(dictionary[0]);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(static_cast<int>(i), documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+
+    const auto queries = GenerateQueries(generator, dictionary, 2'000, 7);
+    size_t serial_count = 0;
+    {
+        LOG_DURATION("serial loop"s);
+        for (const string& query : queries) {
+            serial_count += search_server.FindTopDocuments(query).size();
+        }
+    }
+    size_t parallel_count = 0;
+    {
+        LOG_DURATION("ProcessQueries"s);
+        for (const auto& query_documents : ProcessQueries(search_server, queries)) {
+            parallel_count += query_documents.size();
+        }
+    }
+    size_t joined_count = 0;
+    {
+        LOG_DURATION("ProcessQueriesJoined"s);
+        for ([[maybe_unused]] const Document& document : ProcessQueriesJoined(search_server, queries)) {
+            ++joined_count;
+        }
+    }
+    cout << serial_count << ' ' << parallel_count << ' ' << joined_count << endl;
+}
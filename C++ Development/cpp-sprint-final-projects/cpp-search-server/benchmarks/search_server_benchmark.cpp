@@ -0,0 +1,351 @@
+#include "corpus_generator.h"
+#include "log_duration.h"
+#include "search_server.h"
+#include <algorithm>
+#include <cmath>
+#include <execution>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const string USAGE = R"(Usage: search_server_benchmark [--option=value]...
+  --documents=LIST       document counts to benchmark, comma separated (10000,100000,1000000)
+  --vocabulary=N         number of distinct words (50000)
+  --zipf=S               Zipf exponent of word frequencies (1.0)
+  --length=DIST          document length distribution: poisson or uniform (poisson)
+  --min-length=N         shortest document, in words (1)
+  --max-length=N         longest document, in words (100)
+  --mean-length=X        mean length of the poisson distribution (20)
+  --statuses=LIST        weights of ACTUAL,IRRELEVANT,BANNED,REMOVED (85,5,5,5)
+  --stop-words=N         number of most frequent words made stop words (10)
+  --seed=N               random seed (42)
+  --queries=N            number of queries per search benchmark (1000)
+  --plus-words=N         plus words per query (3)
+  --minus-words=N        minus words per query (1)
+  --prefix-length=N      letters of the prefix in prefix queries (3)
+  --fuzzy-distance=N     edit distance of fuzzy queries, 1 or 2 (1)
+  --removals=N           number of removed documents, half of them with par (1000)
+  --format=FORMAT        csv or json (csv)
+Results go to stdout, progress to stderr.)";
+
+struct BenchmarkOptions {
+    CorpusOptions corpus;
+    vector<int> document_counts{10'000, 100'000, 1'000'000};
+    int query_count = 1000;
+    int plus_word_count = 3;
+    int minus_word_count = 1;
+    int prefix_length = 3;
+    int fuzzy_distance = 1;
+    int removal_count = 1000;
+    string format = "csv"s;
+};
+
+struct Measurement {
+    int document_count;
+    string operation;
+    // Microseconds per call
+    vector<double> samples;
+};
+
+vector<string_view> SplitList(string_view list) {
+    vector<string_view> items;
+    while (!list.empty()) {
+        const size_t comma = list.find(',');
+        items.push_back(list.substr(0, comma));
+        list.remove_prefix(comma == string_view::npos ? list.size() : comma + 1);
+    }
+    return items;
+}
+
+template <typename Number>
+Number ParseNumber(string_view text) {
+    istringstream input{string(text)};
+    Number number;
+    if (!(input >> number) || !input.eof()) {
+        throw invalid_argument("Invalid number: "s + string(text));
+    }
+    return number;
+}
+
+BenchmarkOptions ParseOptions(int argc, char* argv[]) {
+    BenchmarkOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const string_view argument = argv[i];
+        const size_t equals = argument.find('=');
+        if (argument.substr(0, 2) != "--"sv || equals == string_view::npos) {
+            throw invalid_argument("Invalid argument: "s + string(argument));
+        }
+        const string_view name = argument.substr(2, equals - 2);
+        const string_view value = argument.substr(equals + 1);
+        if (name == "documents"sv) {
+            options.document_counts.clear();
+            for (const string_view count : SplitList(value)) {
+                options.document_counts.push_back(ParseNumber<int>(count));
+            }
+        } else if (name == "vocabulary"sv) {
+            options.corpus.vocabulary_size = ParseNumber<size_t>(value);
+        } else if (name == "zipf"sv) {
+            options.corpus.zipf_exponent = ParseNumber<double>(value);
+        } else if (name == "length"sv) {
+            if (value == "poisson"sv) {
+                options.corpus.length_distribution = LengthDistribution::POISSON;
+            } else if (value == "uniform"sv) {
+                options.corpus.length_distribution = LengthDistribution::UNIFORM;
+            } else {
+                throw invalid_argument("Unknown length distribution: "s + string(value));
+            }
+        } else if (name == "min-length"sv) {
+            options.corpus.min_document_length = ParseNumber<int>(value);
+        } else if (name == "max-length"sv) {
+            options.corpus.max_document_length = ParseNumber<int>(value);
+        } else if (name == "mean-length"sv) {
+            options.corpus.mean_document_length = ParseNumber<double>(value);
+        } else if (name == "statuses"sv) {
+            const auto weights = SplitList(value);
+            if (weights.size() != options.corpus.status_weights.size()) {
+                throw invalid_argument("Expected four status weights"s);
+            }
+            for (size_t status = 0; status < weights.size(); ++status) {
+                options.corpus.status_weights[status] = ParseNumber<double>(weights[status]);
+            }
+        } else if (name == "stop-words"sv) {
+            options.corpus.stop_word_count = ParseNumber<size_t>(value);
+        } else if (name == "seed"sv) {
+            options.corpus.seed = ParseNumber<uint32_t>(value);
+        } else if (name == "queries"sv) {
+            options.query_count = ParseNumber<int>(value);
+        } else if (name == "plus-words"sv) {
+            options.plus_word_count = ParseNumber<int>(value);
+        } else if (name == "minus-words"sv) {
+            options.minus_word_count = ParseNumber<int>(value);
+        } else if (name == "prefix-length"sv) {
+            options.prefix_length = ParseNumber<int>(value);
+        } else if (name == "fuzzy-distance"sv) {
+            options.fuzzy_distance = ParseNumber<int>(value);
+        } else if (name == "removals"sv) {
+            options.removal_count = ParseNumber<int>(value);
+        } else if (name == "format"sv && (value == "csv"sv || value == "json"sv)) {
+            options.format = string(value);
+        } else {
+            throw invalid_argument("Invalid argument: "s + string(argument));
+        }
+    }
+    if (any_of(options.document_counts.begin(), options.document_counts.end(), [](int count) { return count <= 0; })
+        || options.query_count < 0 || options.plus_word_count < 0 || options.minus_word_count < 0 || options.removal_count < 0
+        || options.prefix_length <= 0) {
+        throw invalid_argument("Counts must not be negative, document counts and prefix length must be positive"s);
+    }
+    if (options.fuzzy_distance < 1 || options.fuzzy_distance > MAX_FUZZY_DISTANCE) {
+        throw invalid_argument("Fuzzy distance must be between 1 and "s + to_string(MAX_FUZZY_DISTANCE));
+    }
+    return options;
+}
+
+// Nearest-rank percentile of sorted samples
+double GetPercentile(const vector<double>& samples, double percentile) {
+    if (samples.empty()) {
+        return 0.0;
+    }
+    const size_t rank = static_cast<size_t>(ceil(percentile / 100.0 * static_cast<double>(samples.size())));
+    return samples[max<size_t>(rank, 1) - 1];
+}
+
+vector<Measurement> RunBenchmarks(const BenchmarkOptions& options, int document_count) {
+    CorpusGenerator generator(options.corpus);
+    SearchServer search_server(generator.GetStopWords());
+
+    vector<double> add_samples;
+    add_samples.reserve(document_count);
+    {
+        LOG_DURATION("AddDocument x"s + to_string(document_count));
+        for (int document_id = 0; document_id < document_count; ++document_id) {
+            const string document = generator.GenerateDocument();
+            const DocumentStatus status = generator.GenerateStatus();
+            const vector<int> ratings = generator.GenerateRatings();
+            RECORD_DURATION(add_samples);
+            search_server.AddDocument(document_id, document, status, ratings);
+        }
+    }
+
+    vector<string> queries;
+    for (int i = 0; i < options.query_count; ++i) {
+        queries.push_back(generator.GenerateQuery(options.plus_word_count, options.minus_word_count));
+    }
+    // Words are drawn by frequency, so frequent prefixes are tried most
+    vector<string> prefix_queries;
+    for (int i = 0; i < options.query_count; ++i) {
+        prefix_queries.push_back(generator.GenerateQuery(1, 0).substr(0, options.prefix_length) + '*');
+    }
+    // A typo: one letter of a drawn word replaced with a random one
+    mt19937 typo_generator(options.corpus.seed);
+    vector<string> fuzzy_queries;
+    for (int i = 0; i < options.query_count; ++i) {
+        string word = generator.GenerateQuery(1, 0);
+        word[uniform_int_distribution<size_t>(0, word.size() - 1)(typo_generator)]
+            = static_cast<char>('a' + uniform_int_distribution<int>(0, 25)(typo_generator));
+        fuzzy_queries.push_back(word + '~' + to_string(options.fuzzy_distance));
+    }
+
+    // Keeps the optimizer from dropping the searches
+    size_t result_count = 0;
+    vector<double> seq_samples;
+    {
+        LOG_DURATION("FindTopDocuments(seq) x"s + to_string(queries.size()));
+        for (const string& query : queries) {
+            RECORD_DURATION(seq_samples);
+            result_count += search_server.FindTopDocuments(execution::seq, query).size();
+        }
+    }
+    vector<double> par_samples;
+    {
+        LOG_DURATION("FindTopDocuments(par) x"s + to_string(queries.size()));
+        for (const string& query : queries) {
+            RECORD_DURATION(par_samples);
+            result_count += search_server.FindTopDocuments(execution::par, query).size();
+        }
+    }
+
+    vector<double> prefix_samples;
+    {
+        LOG_DURATION("FindTopDocuments(prefix) x"s + to_string(prefix_queries.size()));
+        for (const string& query : prefix_queries) {
+            RECORD_DURATION(prefix_samples);
+            result_count += search_server.FindTopDocuments(execution::seq, query).size();
+        }
+    }
+    vector<double> fuzzy_samples;
+    {
+        LOG_DURATION("FindTopDocuments(fuzzy) x"s + to_string(fuzzy_queries.size()));
+        for (const string& query : fuzzy_queries) {
+            RECORD_DURATION(fuzzy_samples);
+            result_count += search_server.FindTopDocuments(execution::seq, query).size();
+        }
+    }
+
+    mt19937 id_generator(options.corpus.seed);
+    uniform_int_distribution<int> id_distribution(0, document_count - 1);
+    vector<double> match_samples;
+    {
+        LOG_DURATION("MatchDocument x"s + to_string(queries.size()));
+        for (const string& query : queries) {
+            const int document_id = id_distribution(id_generator);
+            RECORD_DURATION(match_samples);
+            result_count += get<0>(search_server.MatchDocument(query, document_id)).size();
+        }
+    }
+    vector<double> par_match_samples;
+    {
+        LOG_DURATION("MatchDocument(par) x"s + to_string(queries.size()));
+        for (const string& query : queries) {
+            const int document_id = id_distribution(id_generator);
+            RECORD_DURATION(par_match_samples);
+            result_count += get<0>(search_server.MatchDocument(execution::par, query, document_id)).size();
+        }
+    }
+
+    vector<int> removed_ids(document_count);
+    iota(removed_ids.begin(), removed_ids.end(), 0);
+    shuffle(removed_ids.begin(), removed_ids.end(), id_generator);
+    removed_ids.resize(min(options.removal_count, document_count));
+    const auto removed_middle = removed_ids.begin() + removed_ids.size() / 2;
+    vector<double> remove_samples;
+    {
+        LOG_DURATION("RemoveDocument(seq) x"s + to_string(removed_middle - removed_ids.begin()));
+        for (auto it = removed_ids.begin(); it != removed_middle; ++it) {
+            RECORD_DURATION(remove_samples);
+            search_server.RemoveDocument(execution::seq, *it);
+        }
+    }
+    vector<double> par_remove_samples;
+    {
+        LOG_DURATION("RemoveDocument(par) x"s + to_string(removed_ids.end() - removed_middle));
+        for (auto it = removed_middle; it != removed_ids.end(); ++it) {
+            RECORD_DURATION(par_remove_samples);
+            search_server.RemoveDocument(execution::par, *it);
+        }
+    }
+
+    cerr << "Documents left: "s << search_server.GetDocumentCount() << ", results found: "s << result_count << endl;
+    vector<Measurement> measurements{
+        {document_count, "AddDocument"s, move(add_samples)},
+        {document_count, "FindTopDocuments(seq)"s, move(seq_samples)},
+        {document_count, "FindTopDocuments(par)"s, move(par_samples)},
+        {document_count, "FindTopDocuments(prefix)"s, move(prefix_samples)},
+        {document_count, "FindTopDocuments(fuzzy)"s, move(fuzzy_samples)},
+        {document_count, "MatchDocument"s, move(match_samples)},
+        {document_count, "MatchDocument(par)"s, move(par_match_samples)},
+        {document_count, "RemoveDocument(seq)"s, move(remove_samples)},
+        {document_count, "RemoveDocument(par)"s, move(par_remove_samples)},
+    };
+    for (Measurement& measurement : measurements) {
+        sort(measurement.samples.begin(), measurement.samples.end());
+    }
+    return measurements;
+}
+
+void PrintCsv(const vector<Measurement>& measurements) {
+    cout << "documents,operation,count,total_ms,mean_us,p50_us,p90_us,p99_us,p999_us,max_us"s << endl;
+    for (const Measurement& measurement : measurements) {
+        const auto& samples = measurement.samples;
+        const double total = accumulate(samples.begin(), samples.end(), 0.0);
+        cout << measurement.document_count << ',' << measurement.operation << ',' << samples.size() << ','
+             << total / 1000.0 << ',' << (samples.empty() ? 0.0 : total / samples.size()) << ','
+             << GetPercentile(samples, 50.0) << ',' << GetPercentile(samples, 90.0) << ','
+             << GetPercentile(samples, 99.0) << ',' << GetPercentile(samples, 99.9) << ','
+             << GetPercentile(samples, 100.0) << endl;
+    }
+}
+
+void PrintJson(const vector<Measurement>& measurements) {
+    cout << '[' << endl;
+    for (size_t i = 0; i < measurements.size(); ++i) {
+        const auto& samples = measurements[i].samples;
+        const double total = accumulate(samples.begin(), samples.end(), 0.0);
+        cout << "  {\"documents\": "s << measurements[i].document_count
+             << ", \"operation\": \""s << measurements[i].operation << '"'
+             << ", \"count\": "s << samples.size()
+             << ", \"total_ms\": "s << total / 1000.0
+             << ", \"mean_us\": "s << (samples.empty() ? 0.0 : total / samples.size())
+             << ", \"p50_us\": "s << GetPercentile(samples, 50.0)
+             << ", \"p90_us\": "s << GetPercentile(samples, 90.0)
+             << ", \"p99_us\": "s << GetPercentile(samples, 99.0)
+             << ", \"p999_us\": "s << GetPercentile(samples, 99.9)
+             << ", \"max_us\": "s << GetPercentile(samples, 100.0) << '}'
+             << (i + 1 < measurements.size() ? ","s : ""s) << endl;
+    }
+    cout << ']' << endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    BenchmarkOptions options;
+    try {
+        options = ParseOptions(argc, argv);
+    } catch (const invalid_argument& error) {
+        cerr << error.what() << endl << USAGE << endl;
+        return 1;
+    }
+
+    vector<Measurement> measurements;
+    for (const int document_count : options.document_counts) {
+        cerr << "Benchmarking "s << document_count << " documents"s << endl;
+        for (Measurement& measurement : RunBenchmarks(options, document_count)) {
+            measurements.push_back(move(measurement));
+        }
+    }
+    if (options.format == "json"s) {
+        PrintJson(measurements);
+    } else {
+        PrintCsv(measurements);
+    }
+}
@@ -0,0 +1,128 @@
+#include "corpus_generator.h"
+#include "log_duration.h"
+#include "search_server.h"
+#include "shard_process.h"
+#include "sharded_search_server.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+using Clock = chrono::steady_clock;
+
+const int DOCUMENT_COUNT = 200'000;
+const int QUERY_COUNT = 500;
+const size_t MAX_SHARD_COUNT = 32;
+
+struct Corpus {
+    vector<string> stop_words;
+    vector<string> documents;
+    vector<DocumentStatus> statuses;
+    vector<vector<int>> ratings;
+    vector<string> queries;
+};
+
+Corpus GenerateCorpus() {
+    CorpusGenerator generator(CorpusOptions{});
+    Corpus corpus;
+    corpus.stop_words = generator.GetStopWords();
+    for (int i = 0; i < DOCUMENT_COUNT; ++i) {
+        corpus.documents.push_back(generator.GenerateDocument());
+        corpus.statuses.push_back(generator.GenerateStatus());
+        corpus.ratings.push_back(generator.GenerateRatings());
+    }
+    for (int i = 0; i < QUERY_COUNT; ++i) {
+        corpus.queries.push_back(generator.GenerateQuery(3, i % 2));
+    }
+    return corpus;
+}
+
+// Nearest-rank percentile of sorted samples
+double GetPercentile(const vector<double>& samples, double percentile) {
+    if (samples.empty()) {
+        return 0.0;
+    }
+    const size_t rank = static_cast<size_t>(ceil(percentile / 100.0 * static_cast<double>(samples.size())));
+    return samples[max<size_t>(rank, 1) - 1];
+}
+
+bool AreSame(const vector<Document>& lhs, const vector<Document>& rhs) {
+    return equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](const Document& lhs, const Document& rhs) {
+        return lhs.id == rhs.id && lhs.relevance == rhs.relevance && lhs.rating == rhs.rating;
+    });
+}
+
+// Adds the corpus, then runs every query and checks it against a single server
+void Measure(const Corpus& corpus, const vector<vector<Document>>& expected, ShardedSearchServer& server, ShardMode mode) {
+    const auto add_start = Clock::now();
+    for (int id = 0; id < DOCUMENT_COUNT; ++id) {
+        server.AddDocument(id, corpus.documents[id], corpus.statuses[id], corpus.ratings[id]);
+    }
+    const double add_seconds = chrono::duration<double>(Clock::now() - add_start).count();
+
+    vector<double> samples;
+    for (size_t i = 0; i < corpus.queries.size(); ++i) {
+        vector<Document> documents;
+        {
+            RECORD_DURATION(samples);
+            documents = server.FindTopDocuments(corpus.queries[i]);
+        }
+        if (!AreSame(documents, expected[i])) {
+            throw logic_error("Shards found other documents than a single server: "s + corpus.queries[i]);
+        }
+    }
+    sort(samples.begin(), samples.end());
+    const double total_us = accumulate(samples.begin(), samples.end(), 0.0);
+
+    cout << setw(10) << (mode == ShardMode::THREADS ? "threads"s : "processes"s) << setw(8) << server.GetShardCount()
+         << setw(14) << fixed << setprecision(0) << DOCUMENT_COUNT / add_seconds
+         << setw(12) << setprecision(1) << total_us / samples.size()
+         << setw(12) << GetPercentile(samples, 50.0) << setw(12) << GetPercentile(samples, 99.0)
+         << setw(12) << setprecision(0) << samples.size() / total_us * 1e6 << endl;
+}
+
+}  // namespace
+
+int main() {
+    const Corpus corpus = GenerateCorpus();
+    // Workers are forked before any parallel search has started threads
+    vector<vector<unique_ptr<ShardProcess>>> shard_processes;
+    for (size_t shard_count = 1; shard_count <= MAX_SHARD_COUNT; shard_count *= 2) {
+        auto& processes = shard_processes.emplace_back();
+        for (size_t shard = 0; shard < shard_count; ++shard) {
+            processes.push_back(make_unique<ShardProcess>(corpus.stop_words));
+        }
+    }
+
+    vector<vector<Document>> expected;
+    {
+        SearchServer server(corpus.stop_words);
+        for (int id = 0; id < DOCUMENT_COUNT; ++id) {
+            server.AddDocument(id, corpus.documents[id], corpus.statuses[id], corpus.ratings[id]);
+        }
+        for (const string& query : corpus.queries) {
+            expected.push_back(server.FindTopDocuments(query));
+        }
+    }
+
+    cout << setw(10) << "mode"s << setw(8) << "shards"s << setw(14) << "adds/s"s << setw(12) << "mean us"s
+         << setw(12) << "p50 us"s << setw(12) << "p99 us"s << setw(12) << "queries/s"s << endl;
+    for (size_t shard_count = 1; shard_count <= MAX_SHARD_COUNT; shard_count *= 2) {
+        ShardedSearchServer server(corpus.stop_words, shard_count);
+        Measure(corpus, expected, server, ShardMode::THREADS);
+    }
+    for (auto& processes : shard_processes) {
+        ShardedSearchServer server(move(processes));
+        Measure(corpus, expected, server, ShardMode::PROCESSES);
+    }
+}
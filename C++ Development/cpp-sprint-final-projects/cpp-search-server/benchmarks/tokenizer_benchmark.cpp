@@ -0,0 +1,83 @@
+#include "corpus_generator.h"
+#include "string_processing.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const int DOCUMENT_COUNT = 200'000;
+const int REPEAT_COUNT = 5;
+
+// The tokenizer before the vector versions: one pass for the words and one for control characters
+size_t TokenizeTwoPasses(string_view text, vector<string_view>& words) {
+    size_t word_begin = text.find_first_not_of(' ');
+    while (word_begin != string_view::npos) {
+        const size_t word_end = text.find(' ', word_begin);
+        words.push_back(text.substr(word_begin, word_end - word_begin));
+        word_begin = text.find_first_not_of(' ', word_end);
+    }
+    for (const string_view word : words) {
+        for (size_t i = 0; i < word.size(); ++i) {
+            if (word[i] >= '\0' && word[i] < ' ') {
+                return word.data() + i - text.data();
+            }
+        }
+    }
+    return string_view::npos;
+}
+
+// Best of REPEAT_COUNT runs over all documents, reusing one buffer of words
+template <typename Tokenize>
+void MeasureTokenizer(const string& name, const vector<string>& documents, size_t byte_count, Tokenize tokenize) {
+    vector<string_view> words;
+    double best_seconds = 0.0;
+    size_t word_count = 0;
+    for (int repeat = 0; repeat < REPEAT_COUNT; ++repeat) {
+        word_count = 0;
+        const auto start = chrono::steady_clock::now();
+        for (const string& document : documents) {
+            words.clear();
+            tokenize(document, words);
+            word_count += words.size();
+        }
+        const chrono::duration<double> seconds = chrono::steady_clock::now() - start;
+        best_seconds = repeat == 0 ? seconds.count() : min(best_seconds, seconds.count());
+    }
+    cout << setw(12) << name << setw(12) << fixed << setprecision(2) << byte_count / best_seconds / 1e9
+         << setw(14) << word_count << endl;
+}
+
+}  // namespace
+
+int main() {
+    CorpusOptions options;
+    options.mean_document_length = 200.0;
+    options.max_document_length = 1000;
+    CorpusGenerator generator(options);
+    vector<string> documents;
+    size_t byte_count = 0;
+    for (int i = 0; i < DOCUMENT_COUNT; ++i) {
+        documents.push_back(generator.GenerateDocument());
+        byte_count += documents.back().size();
+    }
+
+    cout << setw(12) << "tokenizer"s << setw(12) << "GB/s"s << setw(14) << "words"s << endl;
+    MeasureTokenizer("two passes"s, documents, byte_count, TokenizeTwoPasses);
+    const pair<TokenizerIsa, string> isas[] = {{TokenizerIsa::SCALAR, "scalar"s}, {TokenizerIsa::SSE2, "sse2"s}, {TokenizerIsa::AVX2, "avx2"s}};
+    for (const auto& [isa, name] : isas) {
+        if (!IsTokenizerIsaSupported(isa)) {
+            cout << setw(12) << name << setw(12) << "-"s << endl;
+            continue;
+        }
+        MeasureTokenizer(name, documents, byte_count, [isa = isa](string_view text, vector<string_view>& words) {
+            TokenizeWords(text, words, isa);
+        });
+    }
+}
@@ -0,0 +1,52 @@
+#include "concurrent_search_server.h"
+
+ConcurrentSearchServer::ConcurrentSearchServer(const std::string& stop_words_text)
+    : ConcurrentSearchServer(std::string_view(stop_words_text)) {}
+
+ConcurrentSearchServer::ConcurrentSearchServer(std::string_view stop_words_text)
+    : ConcurrentSearchServer(SplitIntoWords(stop_words_text)) {}
+
+void ConcurrentSearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings) {
+    Write([document_id, document = std::string(document), status, ratings](SearchServer& server) {
+        server.AddDocument(document_id, document, status, ratings);
+    });
+}
+
+void ConcurrentSearchServer::RemoveDocument(int document_id) {
+    Write([document_id](SearchServer& server) {
+        server.RemoveDocument(document_id);
+    });
+}
+
+std::vector<Document> ConcurrentSearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status) const {
+    return FindTopDocuments(std::execution::seq, raw_query, status);
+}
+
+std::vector<Document> ConcurrentSearchServer::FindTopDocuments(std::string_view raw_query) const {
+    return FindTopDocuments(std::execution::seq, raw_query);
+}
+
+std::tuple<std::vector<std::string>, DocumentStatus> ConcurrentSearchServer::MatchDocument(std::string_view raw_query, int document_id) const {
+    return Read([&](const SearchServer& server) {
+        return server.MatchDocument(raw_query, document_id);
+    });
+}
+
+int ConcurrentSearchServer::GetDocumentCount() const {
+    return Read([](const SearchServer& server) {
+        return server.GetDocumentCount();
+    });
+}
+
+void ConcurrentSearchServer::Write(std::function<void(SearchServer&)> operation) {
+    std::lock_guard guard(write_mutex_);
+    SearchServer* const writable = readable_.load() == &first_ ? &second_ : &first_;
+    if (pending_operation_) {
+        epochs_.Synchronize();
+        pending_operation_(*writable);
+        pending_operation_ = nullptr;
+    }
+    operation(*writable);
+    readable_.store(writable);
+    pending_operation_ = std::move(operation);
+}
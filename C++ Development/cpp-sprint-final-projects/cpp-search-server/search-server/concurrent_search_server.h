@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <execution>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+#include "document.h"
+#include "read_epochs.h"
+#include "search_server.h"
+
+// Search server that answers queries while documents are added and removed,
+// each query seeing the index either before or after a change, never in between.
+// Two copies of the index are kept. Queries read the published one without
+// locking; a change is made to the other copy, which is then published with an
+// atomic pointer swap. The old copy becomes the one to change next: before the
+// next change, the writer waits until its readers have left (see ReadEpochs)
+// and repeats the previous change on it. Changes are serialized; readers never wait
+class ConcurrentSearchServer {
+public:
+    template <typename StringContainer>
+    explicit ConcurrentSearchServer(const StringContainer& stop_words);
+
+    explicit ConcurrentSearchServer(const std::string& stop_words_text);
+    explicit ConcurrentSearchServer(std::string_view stop_words_text);
+
+    ConcurrentSearchServer(const ConcurrentSearchServer&) = delete;
+    ConcurrentSearchServer& operator=(const ConcurrentSearchServer&) = delete;
+
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+    // Does nothing if there is no document with such id
+    void RemoveDocument(int document_id);
+
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const;
+
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
+
+    template <typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate) const;
+
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentStatus status) const;
+
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query) const;
+
+    std::tuple<std::vector<std::string>, DocumentStatus> MatchDocument(std::string_view raw_query, int document_id) const;
+
+    int GetDocumentCount() const;
+
+private:
+    SearchServer first_;
+    SearchServer second_;
+    std::atomic<SearchServer*> readable_;
+    mutable ReadEpochs epochs_;
+
+    std::mutex write_mutex_;
+    // The last change, made to the published copy only
+    std::function<void(SearchServer&)> pending_operation_;
+
+    template <typename Operation>
+    auto Read(Operation operation) const;
+
+    // The operation must leave the server unchanged if it throws
+    void Write(std::function<void(SearchServer&)> operation);
+};
+
+// Template method implementations
+
+template <typename StringContainer>
+ConcurrentSearchServer::ConcurrentSearchServer(const StringContainer& stop_words)
+    : first_(stop_words),
+      second_(stop_words),
+      readable_(&first_) {}
+
+template <typename DocumentPredicate>
+std::vector<Document> ConcurrentSearchServer::FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const {
+    return FindTopDocuments(std::execution::seq, raw_query, document_predicate);
+}
+
+template <typename ExecutionPolicy, typename DocumentPredicate>
+std::vector<Document> ConcurrentSearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate) const {
+    return Read([&](const SearchServer& server) {
+        return server.FindTopDocuments(policy, raw_query, document_predicate);
+    });
+}
+
+template <typename ExecutionPolicy>
+std::vector<Document> ConcurrentSearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentStatus status) const {
+    return Read([&](const SearchServer& server) {
+        return server.FindTopDocuments(policy, raw_query, status);
+    });
+}
+
+template <typename ExecutionPolicy>
+std::vector<Document> ConcurrentSearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query) const {
+    return FindTopDocuments(policy, raw_query, DocumentStatus::ACTUAL);
+}
+
+template <typename Operation>
+auto ConcurrentSearchServer::Read(Operation operation) const {
+    const auto guard = epochs_.Enter();
+    return operation(static_cast<const SearchServer&>(*readable_.load()));
+}
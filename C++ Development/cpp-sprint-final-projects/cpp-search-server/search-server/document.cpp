@@ -1,4 +1,5 @@
 #include "document.h"
+#include <cmath>
 #include <string>
 
 using namespace std::literals;
@@ -10,4 +11,14 @@ std::ostream& operator<<(std::ostream& os, const Document& document) {
     os << "{ document_id = "s << document.id << ", relevance = "s << document.relevance
        << ", rating = "s << document.rating << " }"s;
     return os;
+}
+
+bool IsRankedHigher(const Document& lhs, const Document& rhs) {
+    if (std::abs(lhs.relevance - rhs.relevance) >= RELEVANCE_EPSILON) {
+        return lhs.relevance > rhs.relevance;
+    }
+    if (lhs.rating != rhs.rating) {
+        return lhs.rating > rhs.rating;
+    }
+    return lhs.id < rhs.id;
 }
\ No newline at end of file
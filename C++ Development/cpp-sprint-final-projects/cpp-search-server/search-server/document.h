@@ -15,6 +15,12 @@ struct Document {
 
 std::ostream& operator<<(std::ostream& os, const Document& document);
 
+// Relevances closer than this are considered equal when ranking documents
+const double RELEVANCE_EPSILON = 1e-6;
+
+// Search results are ranked by relevance, then by rating, then by ascending id
+bool IsRankedHigher(const Document& lhs, const Document& rhs);
+
 enum class DocumentStatus {
     ACTUAL,
     IRRELEVANT,
@@ -0,0 +1,157 @@
+#include "document_bitmap.h"
+#include "posting_list.h"
+#include <algorithm>
+
+void DocumentBitmap::Add(uint32_t ordinal) {
+    const size_t key = ordinal >> 16;
+    const auto value = static_cast<uint16_t>(ordinal);
+    if (key >= containers_.size()) {
+        containers_.resize(key + 1);
+    }
+    Container& container = containers_[key];
+    if (container.IsBitset()) {
+        uint64_t& word = container.words[value / 64];
+        const uint64_t bit = uint64_t{1} << (value % 64);
+        if ((word & bit) != 0) {
+            return;
+        }
+        word |= bit;
+    } else if (container.values.empty() || container.values.back() < value) {
+        // Ordinals are mostly added in increasing order
+        container.values.push_back(value);
+    } else {
+        const auto it = std::lower_bound(container.values.begin(), container.values.end(), value);
+        if (*it == value) {
+            return;
+        }
+        container.values.insert(it, value);
+    }
+    ++container.size;
+    ++size_;
+    container.Normalize();
+}
+
+void DocumentBitmap::Remove(uint32_t ordinal) {
+    const size_t key = ordinal >> 16;
+    const auto value = static_cast<uint16_t>(ordinal);
+    if (key >= containers_.size() || !containers_[key].Contains(value)) {
+        return;
+    }
+    Container& container = containers_[key];
+    if (container.IsBitset()) {
+        container.words[value / 64] &= ~(uint64_t{1} << (value % 64));
+    } else {
+        container.values.erase(std::lower_bound(container.values.begin(), container.values.end(), value));
+    }
+    --container.size;
+    --size_;
+    container.Normalize();
+}
+
+bool DocumentBitmap::Contains(uint32_t ordinal) const {
+    const size_t key = ordinal >> 16;
+    return key < containers_.size() && containers_[key].Contains(static_cast<uint16_t>(ordinal));
+}
+
+uint32_t DocumentBitmap::FindNext(uint32_t ordinal) const {
+    for (size_t key = ordinal >> 16; key < containers_.size(); ++key) {
+        const Container& container = containers_[key];
+        const size_t low = key == ordinal >> 16 ? (ordinal & 0xFFFF) : 0;
+        const auto key_bits = static_cast<uint32_t>(key << 16);
+        if (container.IsBitset()) {
+            size_t word_index = low / 64;
+            uint64_t word = container.words[word_index] & (~uint64_t{0} << (low % 64));
+            while (word == 0 && ++word_index < BITSET_WORD_COUNT) {
+                word = container.words[word_index];
+            }
+            if (word != 0) {
+                return key_bits | static_cast<uint32_t>(word_index * 64 + __builtin_ctzll(word));
+            }
+        } else {
+            const auto it = std::lower_bound(container.values.begin(), container.values.end(), low);
+            if (it != container.values.end()) {
+                return key_bits | *it;
+            }
+        }
+    }
+    return END_DOCUMENT_ORDINAL;
+}
+
+void DocumentBitmap::AndNot(const DocumentBitmap& other) {
+    size_ = 0;
+    for (size_t key = 0; key < containers_.size(); ++key) {
+        Container& container = containers_[key];
+        if (key < other.containers_.size() && other.containers_[key].size > 0) {
+            const Container& other_container = other.containers_[key];
+            if (!container.IsBitset()) {
+                const auto removed = std::remove_if(container.values.begin(), container.values.end(),
+                    [&other_container](uint16_t value) {
+                        return other_container.Contains(value);
+                    });
+                container.values.erase(removed, container.values.end());
+                container.size = static_cast<uint32_t>(container.values.size());
+            } else if (other_container.IsBitset()) {
+                container.size = 0;
+                for (size_t i = 0; i < BITSET_WORD_COUNT; ++i) {
+                    container.words[i] &= ~other_container.words[i];
+                    container.size += __builtin_popcountll(container.words[i]);
+                }
+            } else {
+                for (const uint16_t value : other_container.values) {
+                    uint64_t& word = container.words[value / 64];
+                    const uint64_t bit = uint64_t{1} << (value % 64);
+                    container.size -= (word & bit) != 0 ? 1 : 0;
+                    word &= ~bit;
+                }
+            }
+            container.Normalize();
+        }
+        size_ += container.size;
+    }
+}
+
+size_t DocumentBitmap::GetSize() const {
+    return size_;
+}
+
+size_t DocumentBitmap::GetMemoryUsage() const {
+    size_t memory_usage = containers_.capacity() * sizeof(Container);
+    for (const Container& container : containers_) {
+        memory_usage += container.values.capacity() * sizeof(uint16_t) + container.words.capacity() * sizeof(uint64_t);
+    }
+    return memory_usage;
+}
+
+bool DocumentBitmap::Container::IsBitset() const {
+    return !words.empty();
+}
+
+bool DocumentBitmap::Container::Contains(uint16_t value) const {
+    if (IsBitset()) {
+        return (words[value / 64] >> (value % 64) & 1) != 0;
+    }
+    return std::binary_search(values.begin(), values.end(), value);
+}
+
+void DocumentBitmap::Container::Normalize() {
+    // Bitsets turn back into arrays only at half the limit, so that adding and
+    // removing an ordinal at the limit does not convert the container every time
+    if (IsBitset() && size <= MAX_ARRAY_SIZE / 2) {
+        values.clear();
+        values.reserve(size);
+        for (size_t i = 0; i < BITSET_WORD_COUNT; ++i) {
+            for (uint64_t word = words[i]; word != 0; word &= word - 1) {
+                values.push_back(static_cast<uint16_t>(i * 64 + __builtin_ctzll(word)));
+            }
+        }
+        words.clear();
+        words.shrink_to_fit();
+    } else if (!IsBitset() && size > MAX_ARRAY_SIZE) {
+        words.assign(BITSET_WORD_COUNT, 0);
+        for (const uint16_t value : values) {
+            words[value / 64] |= uint64_t{1} << (value % 64);
+        }
+        values.clear();
+        values.shrink_to_fit();
+    }
+}
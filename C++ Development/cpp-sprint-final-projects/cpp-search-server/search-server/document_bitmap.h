@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// A set of document ordinals split into containers of 2^16 ordinals by their
+// high bits, in the manner of Roaring bitmaps. A container keeps its ordinals
+// as a sorted array while they are few, and as a bitset of 8 KiB once there are
+// more than MAX_ARRAY_SIZE of them. Ordinals are dense, so containers are
+// indexed directly by their high bits
+class DocumentBitmap {
+public:
+    void Add(uint32_t ordinal);
+    void Remove(uint32_t ordinal);
+    bool Contains(uint32_t ordinal) const;
+    // The smallest ordinal of the set not less than the given one,
+    // or END_DOCUMENT_ORDINAL if there is none
+    uint32_t FindNext(uint32_t ordinal) const;
+    // Removes the ordinals found in other
+    void AndNot(const DocumentBitmap& other);
+
+    size_t GetSize() const;
+    // Bytes taken by the containers
+    size_t GetMemoryUsage() const;
+
+private:
+    static constexpr size_t MAX_ARRAY_SIZE = 4096;
+    static constexpr size_t BITSET_WORD_COUNT = (1 << 16) / 64;
+
+    struct Container {
+        // Sorted low bits of the ordinals, while the bitset is empty
+        std::vector<uint16_t> values;
+        std::vector<uint64_t> words;
+        uint32_t size = 0;
+
+        bool IsBitset() const;
+        bool Contains(uint16_t value) const;
+        // Turns a bitset that got too sparse back into an array and the other way round
+        void Normalize();
+    };
+
+    std::vector<Container> containers_;
+    size_t size_ = 0;
+};
@@ -0,0 +1,132 @@
+#include "front_coded_terms.h"
+#include <algorithm>
+
+FrontCodedTerms::FrontCodedTerms(const std::vector<std::pair<std::string_view, TermId>>& sorted_terms) {
+    term_ids_.reserve(sorted_terms.size());
+    block_offsets_.reserve((sorted_terms.size() + BLOCK_SIZE - 1) / BLOCK_SIZE);
+    std::string_view previous_term;
+    for (size_t index = 0; index < sorted_terms.size(); ++index) {
+        const auto& [term, term_id] = sorted_terms[index];
+        size_t shared_length = 0;
+        if (index % BLOCK_SIZE == 0) {
+            block_offsets_.push_back(static_cast<uint32_t>(bytes_.size()));
+        } else {
+            while (shared_length < term.size() && shared_length < previous_term.size()
+                   && term[shared_length] == previous_term[shared_length]) {
+                ++shared_length;
+            }
+            WriteLength(shared_length);
+        }
+        WriteLength(term.size() - shared_length);
+        bytes_.insert(bytes_.end(), term.begin() + shared_length, term.end());
+        term_ids_.push_back(term_id);
+        previous_term = term;
+    }
+    bytes_.shrink_to_fit();
+}
+
+FrontCodedTerms::Cursor::Cursor(const FrontCodedTerms& terms)
+    : terms_(&terms) {
+    if (IsValid()) {
+        MoveToBlock(0);
+    }
+}
+
+bool FrontCodedTerms::Cursor::IsValid() const {
+    return index_ < terms_->term_ids_.size();
+}
+
+std::string_view FrontCodedTerms::Cursor::GetTerm() const {
+    return term_;
+}
+
+FrontCodedTerms::TermId FrontCodedTerms::Cursor::GetTermId() const {
+    return terms_->term_ids_[index_];
+}
+
+void FrontCodedTerms::Cursor::Next() {
+    if (++index_ < terms_->term_ids_.size()) {
+        Decode();
+    }
+}
+
+void FrontCodedTerms::Cursor::SkipTo(std::string_view target) {
+    if (!IsValid() || term_ >= target) {
+        return;
+    }
+    // The last block starting with a term not greater than the target. Targets
+    // are usually close, so the search gallops ahead of the current block first
+    const size_t block_count = terms_->block_offsets_.size();
+    size_t low = index_ / BLOCK_SIZE + 1;
+    size_t high = low;
+    for (size_t step = 1; high < block_count && terms_->GetFirstTerm(high) <= target; step *= 2) {
+        low = high + 1;
+        high = std::min(high + step, block_count);
+    }
+    while (low < high) {
+        const size_t middle = (low + high) / 2;
+        if (terms_->GetFirstTerm(middle) <= target) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    if (low - 1 > index_ / BLOCK_SIZE) {
+        MoveToBlock(low - 1);
+    }
+    while (IsValid() && term_ < target) {
+        Next();
+    }
+}
+
+void FrontCodedTerms::Cursor::MoveToBlock(size_t block) {
+    index_ = block * BLOCK_SIZE;
+    offset_ = terms_->block_offsets_[block];
+    Decode();
+}
+
+void FrontCodedTerms::Cursor::Decode() {
+    const size_t shared_length = index_ % BLOCK_SIZE == 0 ? 0 : terms_->ReadLength(offset_);
+    const size_t suffix_length = terms_->ReadLength(offset_);
+    term_.resize(shared_length);
+    term_.append(terms_->bytes_.data() + offset_, suffix_length);
+    offset_ += suffix_length;
+}
+
+FrontCodedTerms::Cursor FrontCodedTerms::GetCursor() const {
+    return Cursor(*this);
+}
+
+size_t FrontCodedTerms::GetSize() const {
+    return term_ids_.size();
+}
+
+size_t FrontCodedTerms::GetMemoryUsage() const {
+    return bytes_.capacity() + block_offsets_.capacity() * sizeof(uint32_t) + term_ids_.capacity() * sizeof(TermId);
+}
+
+std::string_view FrontCodedTerms::GetFirstTerm(size_t block) const {
+    size_t offset = block_offsets_[block];
+    const size_t length = ReadLength(offset);
+    return {bytes_.data() + offset, length};
+}
+
+// Seven bits per byte, the high bit set on all but the last byte
+void FrontCodedTerms::WriteLength(size_t length) {
+    while (length >= 0x80) {
+        bytes_.push_back(static_cast<char>(length | 0x80));
+        length >>= 7;
+    }
+    bytes_.push_back(static_cast<char>(length));
+}
+
+size_t FrontCodedTerms::ReadLength(size_t& offset) const {
+    size_t length = 0;
+    for (int shift = 0;; shift += 7) {
+        const auto byte = static_cast<uint8_t>(bytes_[offset++]);
+        length |= static_cast<size_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return length;
+        }
+    }
+}
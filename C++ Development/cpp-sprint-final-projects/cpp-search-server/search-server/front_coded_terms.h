@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Sorted terms with their ids, front-coded in blocks of BLOCK_SIZE: the first
+// term of a block is stored whole, every other one as the length of the prefix
+// it shares with the previous term plus the rest of it. A block is found by
+// binary search over the first terms and then decoded in order. Immutable
+class FrontCodedTerms {
+public:
+    using TermId = uint32_t;
+
+    // Walks the terms in order and can skip ahead to a given term
+    class Cursor {
+    public:
+        explicit Cursor(const FrontCodedTerms& terms);
+
+        bool IsValid() const;
+        // Valid until the cursor moves
+        std::string_view GetTerm() const;
+        TermId GetTermId() const;
+        void Next();
+        // Moves forward to the first term not less than the target, skipping whole blocks by their first terms
+        void SkipTo(std::string_view target);
+
+    private:
+        const FrontCodedTerms* terms_;
+        size_t index_ = 0;
+        // Where the bytes of the term after the current one start
+        size_t offset_ = 0;
+        std::string term_;
+
+        void MoveToBlock(size_t block);
+        void Decode();
+    };
+
+    FrontCodedTerms() = default;
+    // Terms must be sorted and unique
+    explicit FrontCodedTerms(const std::vector<std::pair<std::string_view, TermId>>& sorted_terms);
+
+    // Calls function(term, term_id) for every term in order
+    template <typename Function>
+    void ForEach(Function function) const;
+
+    Cursor GetCursor() const;
+    size_t GetSize() const;
+    // Bytes taken by the encoded terms, their ids and the block index
+    size_t GetMemoryUsage() const;
+
+private:
+    static constexpr size_t BLOCK_SIZE = 16;
+
+    std::vector<char> bytes_;
+    std::vector<uint32_t> block_offsets_;
+    std::vector<TermId> term_ids_;
+
+    std::string_view GetFirstTerm(size_t block) const;
+
+    void WriteLength(size_t length);
+    size_t ReadLength(size_t& offset) const;
+};
+
+template <typename Function>
+void FrontCodedTerms::ForEach(Function function) const {
+    for (Cursor cursor = GetCursor(); cursor.IsValid(); cursor.Next()) {
+        function(cursor.GetTerm(), cursor.GetTermId());
+    }
+}
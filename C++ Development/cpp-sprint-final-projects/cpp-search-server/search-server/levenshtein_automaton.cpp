@@ -0,0 +1,86 @@
+#include "levenshtein_automaton.h"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std::literals;
+
+LevenshteinAutomaton::LevenshteinAutomaton(std::string_view pattern, int max_distance)
+    : pattern_(pattern) {
+    if (max_distance < 0 || max_distance > 254) {
+        throw std::invalid_argument("Edit distance "s + std::to_string(max_distance) + " is out of range"s);
+    }
+    max_distance_ = static_cast<uint8_t>(max_distance);
+}
+
+LevenshteinAutomaton::State LevenshteinAutomaton::Start() const {
+    State state(pattern_.size() + 1);
+    for (size_t i = 0; i < state.size(); ++i) {
+        state[i] = static_cast<uint8_t>(std::min<size_t>(i, max_distance_ + 1));
+    }
+    return state;
+}
+
+void LevenshteinAutomaton::Step(const State& state, char c, State& next_state) const {
+    const uint8_t cap = max_distance_ + 1;
+    next_state.resize(state.size());
+    next_state[0] = std::min<uint8_t>(state[0] + 1, cap);
+    for (size_t i = 1; i < state.size(); ++i) {
+        const int substitution = state[i - 1] + (pattern_[i - 1] == c ? 0 : 1);
+        const int deletion = state[i] + 1;
+        const int insertion = next_state[i - 1] + 1;
+        next_state[i] = static_cast<uint8_t>(std::min({substitution, deletion, insertion, static_cast<int>(cap)}));
+    }
+}
+
+bool LevenshteinAutomaton::IsMatch(const State& state) const {
+    return state.back() <= max_distance_;
+}
+
+bool LevenshteinAutomaton::CanMatch(const State& state) const {
+    return *std::min_element(state.begin(), state.end()) <= max_distance_;
+}
+
+std::optional<char> LevenshteinAutomaton::FindNextChar(const State& state, char c) const {
+    const int byte = static_cast<unsigned char>(c);
+    if (byte == 0xFF) {
+        return std::nullopt;
+    }
+    // Without matching a character of the pattern every distance grows by at
+    // least one, so any character does if some distance is below the maximum
+    if (*std::min_element(state.begin(), state.end()) < max_distance_) {
+        return static_cast<char>(byte + 1);
+    }
+    // Otherwise only a pattern character matched right after a prefix within the maximum does
+    int next_byte = 0x100;
+    for (size_t i = 0; i < pattern_.size(); ++i) {
+        const int pattern_byte = static_cast<unsigned char>(pattern_[i]);
+        if (state[i] <= max_distance_ && pattern_byte > byte) {
+            next_byte = std::min(next_byte, pattern_byte);
+        }
+    }
+    if (next_byte == 0x100) {
+        return std::nullopt;
+    }
+    return static_cast<char>(next_byte);
+}
+
+int LevenshteinAutomaton::GetDistance(const State& state) const {
+    return state.back();
+}
+
+int LevenshteinAutomaton::GetDistance(std::string_view word) const {
+    State state = Start();
+    State next_state;
+    for (const char c : word) {
+        Step(state, c, next_state);
+        state.swap(next_state);
+        if (!CanMatch(state)) {
+            return max_distance_ + 1;
+        }
+    }
+    return GetDistance(state);
+}
+
+int LevenshteinAutomaton::GetMaxDistance() const {
+    return max_distance_;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Accepts the words within a given edit distance of a pattern: insertions,
+// deletions and substitutions of single characters each cost one. Words are
+// read one character at a time, so the words of a sorted dictionary that share
+// a prefix share the states for it, and a prefix whose state cannot lead to a
+// match rules out every word starting with it. A state is a row of the edit
+// distance table: the distances from the characters read to every prefix of the
+// pattern, capped at the maximal distance plus one. Characters are bytes, so a
+// non-ASCII UTF-8 character counts as several edits
+class LevenshteinAutomaton {
+public:
+    using State = std::vector<uint8_t>;
+
+    // Throws std::invalid_argument if max_distance is not between 0 and 254
+    LevenshteinAutomaton(std::string_view pattern, int max_distance);
+
+    State Start() const;
+    // Writes the state after reading c in state to next_state
+    void Step(const State& state, char c, State& next_state) const;
+    bool IsMatch(const State& state) const;
+    // False if no word starting with the characters read so far can match
+    bool CanMatch(const State& state) const;
+    // The smallest character greater than c after which a word can still match. Only
+    // characters of the pattern can be such, unless every character is, which lets
+    // a sorted dictionary skip over all words going through the other characters
+    std::optional<char> FindNextChar(const State& state, char c) const;
+    // Edit distance of the characters read, if it is a match
+    int GetDistance(const State& state) const;
+
+    // Edit distance of the word, or max_distance + 1 if it is larger
+    int GetDistance(std::string_view word) const;
+    int GetMaxDistance() const;
+
+private:
+    std::string pattern_;
+    uint8_t max_distance_;
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#define PROFILE_CONCAT_INTERNAL(X, Y) X##Y
+#define PROFILE_CONCAT(X, Y) PROFILE_CONCAT_INTERNAL(X, Y)
+#define UNIQUE_VAR_NAME_PROFILE PROFILE_CONCAT(profileGuard, __LINE__)
+#define LOG_DURATION(x) LogDuration UNIQUE_VAR_NAME_PROFILE(x)
+#define RECORD_DURATION(samples) RecordDuration UNIQUE_VAR_NAME_PROFILE(samples)
+
+class LogDuration {
+public:
+    // заменим имя типа std::chrono::steady_clock
+    // с помощью using для удобства
+    using Clock = std::chrono::steady_clock;
+
+    LogDuration(const std::string& id) : id_(id) {
+    }
+
+    ~LogDuration() {
+        using namespace std::chrono;
+        using namespace std::literals;
+
+        const auto end_time = Clock::now();
+        const auto dur = end_time - start_time_;
+        std::cerr << id_ << ": "s << duration_cast<milliseconds>(dur).count() << " ms"s << std::endl;
+    }
+
+private:
+    const std::string id_;
+    const Clock::time_point start_time_ = Clock::now();
+};
+
+// Как LogDuration, но не печатает длительность, а добавляет её
+// в микросекундах к вектору замеров
+class RecordDuration {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit RecordDuration(std::vector<double>& samples) : samples_(samples) {
+    }
+
+    ~RecordDuration() {
+        const std::chrono::duration<double, std::micro> dur = Clock::now() - start_time_;
+        samples_.push_back(dur.count());
+    }
+
+private:
+    std::vector<double>& samples_;
+    const Clock::time_point start_time_ = Clock::now();
+};
@@ -4,11 +4,14 @@
 #include "request_queue.h"
 #include "search_server.h"
 #include "string_processing.h"
+#include "test_search_server.h"
 #include <iostream>
 
 using namespace std;
 
 int main() {
+    TestSearchServer();
+
     SearchServer search_server("and with"s);
     search_server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, {7, 2, 7});
     search_server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, {1, 2, 3});
@@ -0,0 +1,45 @@
+#include "mapped_file.h"
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std::literals;
+
+MappedFile::MappedFile(const std::string& path) {
+    const int file = open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+        throw std::invalid_argument("Cannot open file "s + path);
+    }
+    struct stat file_stat;
+    if (fstat(file, &file_stat) != 0) {
+        close(file);
+        throw std::invalid_argument("Cannot read file "s + path);
+    }
+    size_ = static_cast<size_t>(file_stat.st_size);
+    if (size_ > 0) {
+        void* data = mmap(nullptr, size_, PROT_READ, MAP_SHARED, file, 0);
+        if (data == MAP_FAILED) {
+            close(file);
+            throw std::invalid_argument("Cannot map file "s + path);
+        }
+        data_ = static_cast<const char*>(data);
+    }
+    // The mapping stays valid after the descriptor is closed
+    close(file);
+}
+
+MappedFile::~MappedFile() {
+    if (data_ != nullptr) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+}
+
+const char* MappedFile::GetData() const {
+    return data_;
+}
+
+size_t MappedFile::GetSize() const {
+    return size_;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of a whole file. Pages are read by the OS on first
+// access and are shared with other processes mapping the same file
+class MappedFile {
+public:
+    // Throws std::invalid_argument if the file cannot be opened or mapped
+    explicit MappedFile(const std::string& path);
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    const char* GetData() const;
+    size_t GetSize() const;
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Vector that may refer to elements it does not own, such as an array inside
+// a mapped snapshot file. Reading works the same either way; the referred
+// elements are copied into own storage on the first call to Mutable
+template <typename T>
+class MappedVector {
+public:
+    MappedVector() = default;
+
+    explicit MappedVector(std::vector<T> elements)
+        : elements_(std::move(elements)) {}
+
+    // The referred elements must stay valid until the vector is modified or destroyed
+    static MappedVector View(const T* data, size_t size) {
+        MappedVector result;
+        result.view_data_ = data;
+        result.view_size_ = size;
+        result.is_view_ = true;
+        return result;
+    }
+
+    bool IsView() const {
+        return is_view_;
+    }
+
+    std::vector<T>& Mutable() {
+        if (is_view_) {
+            elements_.assign(view_data_, view_data_ + view_size_);
+            is_view_ = false;
+        }
+        return elements_;
+    }
+
+    const T* data() const {
+        return is_view_ ? view_data_ : elements_.data();
+    }
+
+    size_t size() const {
+        return is_view_ ? view_size_ : elements_.size();
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    const T* begin() const {
+        return data();
+    }
+
+    const T* end() const {
+        return data() + size();
+    }
+
+    const T& operator[](size_t index) const {
+        return data()[index];
+    }
+
+    const T& back() const {
+        return data()[size() - 1];
+    }
+
+private:
+    std::vector<T> elements_;
+    const T* view_data_ = nullptr;
+    size_t view_size_ = 0;
+    bool is_view_ = false;
+};
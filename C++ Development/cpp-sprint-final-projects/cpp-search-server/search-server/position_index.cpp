@@ -0,0 +1,132 @@
+#include "position_index.h"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std::literals;
+
+void PositionIndex::AddDocument(uint32_t document_ordinal, const std::vector<std::pair<TermId, uint32_t>>& term_positions) {
+    if (documents_.size() <= document_ordinal) {
+        documents_.resize(document_ordinal + 1);
+    }
+    DocumentPositions& document = documents_[document_ordinal];
+    uint32_t previous_position = 0;
+    for (const auto& [term_id, position] : term_positions) {
+        if (document.terms.empty() || document.terms.back().term_id != term_id) {
+            document.terms.push_back({term_id, static_cast<uint32_t>(document.gaps.size())});
+            previous_position = 0;
+        }
+        // Seven bits per byte, the high bit set on all but the last byte
+        uint32_t gap = position - previous_position;
+        while (gap >= 0x80) {
+            document.gaps.push_back(static_cast<uint8_t>(gap | 0x80));
+            gap >>= 7;
+        }
+        document.gaps.push_back(static_cast<uint8_t>(gap));
+        previous_position = position;
+    }
+    document.terms.shrink_to_fit();
+    document.gaps.shrink_to_fit();
+}
+
+void PositionIndex::RemoveDocument(uint32_t document_ordinal) {
+    if (document_ordinal < documents_.size()) {
+        documents_[document_ordinal] = DocumentPositions();
+    }
+}
+
+bool PositionIndex::GetPositions(uint32_t document_ordinal, TermId term_id, std::vector<uint32_t>& positions) const {
+    positions.clear();
+    if (document_ordinal >= documents_.size()) {
+        return false;
+    }
+    const DocumentPositions& document = documents_[document_ordinal];
+    const auto term = std::lower_bound(document.terms.begin(), document.terms.end(), term_id,
+        [](const TermEntry& entry, TermId term_id) {
+            return entry.term_id < term_id;
+        });
+    if (term == document.terms.end() || term->term_id != term_id) {
+        return false;
+    }
+    const uint32_t end = std::next(term) != document.terms.end() ? std::next(term)->offset : static_cast<uint32_t>(document.gaps.size());
+    DecodePositions(document.gaps.data() + term->offset, document.gaps.data() + end, positions);
+    return true;
+}
+
+size_t PositionIndex::GetMemoryUsage() const {
+    size_t memory_usage = documents_.capacity() * sizeof(DocumentPositions);
+    for (const DocumentPositions& document : documents_) {
+        memory_usage += document.terms.capacity() * sizeof(TermEntry) + document.gaps.capacity();
+    }
+    return memory_usage;
+}
+
+void PositionIndex::Save(SnapshotWriter& writer) const {
+    // Flattened: the term and byte counts of every document, then all terms and all gaps
+    std::vector<uint32_t> term_counts;
+    std::vector<uint32_t> gap_sizes;
+    std::vector<TermEntry> terms;
+    std::vector<uint8_t> gaps;
+    for (const DocumentPositions& document : documents_) {
+        term_counts.push_back(static_cast<uint32_t>(document.terms.size()));
+        gap_sizes.push_back(static_cast<uint32_t>(document.gaps.size()));
+        terms.insert(terms.end(), document.terms.begin(), document.terms.end());
+        gaps.insert(gaps.end(), document.gaps.begin(), document.gaps.end());
+    }
+    writer.WriteArray(term_counts);
+    writer.WriteArray(gap_sizes);
+    writer.WriteArray(terms);
+    writer.WriteArray(gaps);
+}
+
+PositionIndex PositionIndex::Load(SnapshotReader& reader) {
+    const auto term_counts = reader.ReadArray<uint32_t>();
+    const auto gap_sizes = reader.ReadArray<uint32_t>();
+    const auto terms = reader.ReadArray<TermEntry>();
+    const auto gaps = reader.ReadArray<uint8_t>();
+    if (term_counts.size() != gap_sizes.size()) {
+        throw std::invalid_argument("Position index is corrupted"s);
+    }
+
+    PositionIndex index;
+    index.documents_.resize(term_counts.size());
+    size_t term_offset = 0;
+    size_t gap_offset = 0;
+    for (size_t ordinal = 0; ordinal < term_counts.size(); ++ordinal) {
+        if (term_counts[ordinal] > terms.size() - term_offset || gap_sizes[ordinal] > gaps.size() - gap_offset) {
+            throw std::invalid_argument("Position index is corrupted"s);
+        }
+        DocumentPositions& document = index.documents_[ordinal];
+        document.terms.assign(terms.begin() + term_offset, terms.begin() + term_offset + term_counts[ordinal]);
+        document.gaps.assign(gaps.begin() + gap_offset, gaps.begin() + gap_offset + gap_sizes[ordinal]);
+        const bool are_offsets_valid = std::is_sorted(document.terms.begin(), document.terms.end(),
+            [](const TermEntry& lhs, const TermEntry& rhs) {
+                return lhs.offset < rhs.offset;
+            });
+        if (!are_offsets_valid || (!document.terms.empty() && document.terms.back().offset > document.gaps.size())) {
+            throw std::invalid_argument("Position index is corrupted"s);
+        }
+        term_offset += term_counts[ordinal];
+        gap_offset += gap_sizes[ordinal];
+    }
+    return index;
+}
+
+void PositionIndex::DecodePositions(const uint8_t* begin, const uint8_t* end, std::vector<uint32_t>& positions) {
+    positions.clear();
+    uint32_t position = 0;
+    while (begin != end) {
+        uint32_t gap = 0;
+        // Bounded, so that corrupted bytes of a loaded snapshot cannot overrun the gaps
+        for (int shift = 0; begin != end; shift += 7) {
+            const uint8_t byte = *begin++;
+            if (shift < 32) {
+                gap |= static_cast<uint32_t>(byte & 0x7F) << shift;
+            }
+            if ((byte & 0x80) == 0) {
+                break;
+            }
+        }
+        position += gap;
+        positions.push_back(position);
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "snapshot_io.h"
+#include "term_dictionary.h"
+
+// Positions of the words in each document, for phrase queries. A position is
+// the index of the word in the document text, stop words included. Every
+// document keeps its terms sorted by id and the positions of each term as
+// gaps from the previous one, in variable-length bytes: a position usually
+// takes one byte, plus eight bytes per distinct term of the document
+class PositionIndex {
+public:
+    using TermId = TermDictionary::TermId;
+
+    // Pairs must be sorted by term id, then by position. Ordinals must be new
+    void AddDocument(uint32_t document_ordinal, const std::vector<std::pair<TermId, uint32_t>>& term_positions);
+    void RemoveDocument(uint32_t document_ordinal);
+
+    // Replaces the contents of positions with the ascending positions of the term
+    // in the document; returns false if the term is not in the document
+    bool GetPositions(uint32_t document_ordinal, TermId term_id, std::vector<uint32_t>& positions) const;
+    // Calls function(term_id, positions) for every term of the document, in term id order
+    template <typename Function>
+    void ForEachTerm(uint32_t document_ordinal, Function function) const;
+
+    // Bytes taken by the positions and their headers
+    size_t GetMemoryUsage() const;
+
+    void Save(SnapshotWriter& writer) const;
+    // Copies the positions into memory
+    static PositionIndex Load(SnapshotReader& reader);
+
+private:
+    struct TermEntry {
+        TermId term_id;
+        // Where the term's positions start in the document's gaps
+        uint32_t offset;
+    };
+
+    struct DocumentPositions {
+        std::vector<TermEntry> terms;
+        std::vector<uint8_t> gaps;
+    };
+
+    // Indexed by document ordinal; removed documents are left empty
+    std::vector<DocumentPositions> documents_;
+
+    static void DecodePositions(const uint8_t* begin, const uint8_t* end, std::vector<uint32_t>& positions);
+};
+
+template <typename Function>
+void PositionIndex::ForEachTerm(uint32_t document_ordinal, Function function) const {
+    if (document_ordinal >= documents_.size()) {
+        return;
+    }
+    const DocumentPositions& document = documents_[document_ordinal];
+    std::vector<uint32_t> positions;
+    for (size_t i = 0; i < document.terms.size(); ++i) {
+        const uint32_t end = i + 1 < document.terms.size() ? document.terms[i + 1].offset : static_cast<uint32_t>(document.gaps.size());
+        DecodePositions(document.gaps.data() + document.terms[i].offset, document.gaps.data() + end, positions);
+        function(document.terms[i].term_id, positions);
+    }
+}
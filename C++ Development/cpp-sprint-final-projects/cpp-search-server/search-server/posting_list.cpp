@@ -0,0 +1,498 @@
+#include "posting_list.h"
+#include <algorithm>
+
+#include <stdexcept>
+#include <utility>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SEARCH_SERVER_X86_POSTINGS
+#include <immintrin.h>
+#endif
+
+using namespace std::literals;
+
+namespace {
+
+bool IsBeforeOrdinal(const Posting& posting, uint32_t document_ordinal) {
+    return posting.document_ordinal < document_ordinal;
+}
+
+// Postings are padded after the ordinal; the copy for a snapshot has the padding zeroed
+std::vector<Posting> CopyPostings(const MappedVector<Posting>& postings) {
+    auto copy = MakeZeroedArray<Posting>(postings.size());
+    for (size_t i = 0; i < copy.size(); ++i) {
+        copy[i].document_ordinal = postings[i].document_ordinal;
+        copy[i].term_freq = postings[i].term_freq;
+    }
+    return copy;
+}
+
+uint8_t GetBitWidth(uint32_t value) {
+    uint8_t width = 0;
+    while (width < 32 && (value >> width) != 0) {
+        ++width;
+    }
+    return width;
+}
+
+constexpr size_t LANE_COUNT = 4;
+constexpr size_t VALUES_PER_LANE = CompressedPostingList::BLOCK_SIZE / LANE_COUNT;
+
+void PackGaps(const uint32_t* gaps, uint8_t bit_width, uint32_t* packed) {
+    if (bit_width == 0) {
+        return;
+    }
+    for (size_t i = 0; i < CompressedPostingList::BLOCK_SIZE; ++i) {
+        const size_t lane = i % LANE_COUNT;
+        const size_t bit = i / LANE_COUNT * bit_width;
+        const size_t word = bit / 32;
+        const size_t shift = bit % 32;
+        packed[word * LANE_COUNT + lane] |= gaps[i] << shift;
+        if (shift + bit_width > 32) {
+            packed[(word + 1) * LANE_COUNT + lane] |= gaps[i] >> (32 - shift);
+        }
+    }
+}
+
+void UnpackOrdinalsScalar(const uint32_t* packed, uint8_t bit_width, uint32_t first_ordinal, uint32_t* ordinals) {
+    const uint32_t mask = bit_width == 32 ? ~0u : (1u << bit_width) - 1;
+    uint32_t running = first_ordinal;
+    for (size_t i = 0; i < CompressedPostingList::BLOCK_SIZE; ++i) {
+        const size_t lane = i % LANE_COUNT;
+        const size_t bit = i / LANE_COUNT * bit_width;
+        const size_t word = bit / 32;
+        const size_t shift = bit % 32;
+        uint32_t gap = packed[word * LANE_COUNT + lane] >> shift;
+        if (shift + bit_width > 32) {
+            gap |= packed[(word + 1) * LANE_COUNT + lane] << (32 - shift);
+        }
+        running += gap & mask;
+        ordinals[i] = running;
+    }
+}
+
+#ifdef SEARCH_SERVER_X86_POSTINGS
+
+// Unpacks four gaps at a time and turns them into ordinals with a vector prefix sum
+__attribute__((target("sse2")))
+void UnpackOrdinalsSse2(const uint32_t* packed, uint8_t bit_width, uint32_t first_ordinal, uint32_t* ordinals) {
+    const __m128i mask = _mm_set1_epi32(bit_width == 32 ? -1 : static_cast<int>((1u << bit_width) - 1));
+    const auto* words = reinterpret_cast<const __m128i*>(packed);
+    __m128i running = _mm_set1_epi32(static_cast<int>(first_ordinal));
+    for (size_t j = 0; j < VALUES_PER_LANE; ++j) {
+        const size_t bit = j * bit_width;
+        const size_t word = bit / 32;
+        const size_t shift = bit % 32;
+        __m128i gaps = _mm_srl_epi32(_mm_loadu_si128(words + word), _mm_cvtsi32_si128(static_cast<int>(shift)));
+        if (shift + bit_width > 32) {
+            gaps = _mm_or_si128(gaps, _mm_sll_epi32(_mm_loadu_si128(words + word + 1), _mm_cvtsi32_si128(static_cast<int>(32 - shift))));
+        }
+        gaps = _mm_and_si128(gaps, mask);
+        gaps = _mm_add_epi32(gaps, _mm_slli_si128(gaps, 4));
+        gaps = _mm_add_epi32(gaps, _mm_slli_si128(gaps, 8));
+        running = _mm_add_epi32(gaps, running);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(ordinals + j * LANE_COUNT), running);
+        running = _mm_shuffle_epi32(running, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+}
+
+// Unpacks two rows of four gaps at a time, shifting each row by its own count
+__attribute__((target("avx2")))
+void UnpackOrdinalsAvx2(const uint32_t* packed, uint8_t bit_width, uint32_t first_ordinal, uint32_t* ordinals) {
+    const __m256i mask = _mm256_set1_epi32(bit_width == 32 ? -1 : static_cast<int>((1u << bit_width) - 1));
+    const auto* words = reinterpret_cast<const __m128i*>(packed);
+    // The words of a row, shifted into place; the next words only where a gap spans them,
+    // so that the last row does not read past the block
+    const auto load_row = [words, bit_width](size_t j, int& shift) {
+        const size_t bit = j * bit_width;
+        shift = static_cast<int>(bit % 32);
+        const __m128i next_words = shift + bit_width > 32 ? _mm_loadu_si128(words + bit / 32 + 1) : _mm_setzero_si128();
+        return std::pair{_mm_loadu_si128(words + bit / 32), next_words};
+    };
+    __m256i running = _mm256_set1_epi32(static_cast<int>(first_ordinal));
+    for (size_t j = 0; j < VALUES_PER_LANE; j += 2) {
+        int low_shift = 0;
+        int high_shift = 0;
+        const auto [low_words, low_next_words] = load_row(j, low_shift);
+        const auto [high_words, high_next_words] = load_row(j + 1, high_shift);
+        const __m256i shifts = _mm256_setr_epi32(low_shift, low_shift, low_shift, low_shift, high_shift, high_shift, high_shift, high_shift);
+        // Shifts by 32 give zero, which is what a row that does not span words needs
+        const __m256i next_shifts = _mm256_sub_epi32(_mm256_set1_epi32(32), shifts);
+        __m256i gaps = _mm256_srlv_epi32(_mm256_inserti128_si256(_mm256_castsi128_si256(low_words), high_words, 1), shifts);
+        gaps = _mm256_or_si256(gaps, _mm256_sllv_epi32(_mm256_inserti128_si256(_mm256_castsi128_si256(low_next_words), high_next_words, 1), next_shifts));
+        gaps = _mm256_and_si256(gaps, mask);
+        // Prefix sums within each row, then the sum of the first row carried into the second
+        gaps = _mm256_add_epi32(gaps, _mm256_slli_si256(gaps, 4));
+        gaps = _mm256_add_epi32(gaps, _mm256_slli_si256(gaps, 8));
+        gaps = _mm256_add_epi32(gaps, _mm256_shuffle_epi32(_mm256_permute2x128_si256(gaps, gaps, 0x08), _MM_SHUFFLE(3, 3, 3, 3)));
+        running = _mm256_add_epi32(gaps, running);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(ordinals + j * LANE_COUNT), running);
+        running = _mm256_permutevar8x32_epi32(running, _mm256_set1_epi32(7));
+    }
+}
+
+#endif
+
+using UnpackFunction = void (*)(const uint32_t*, uint8_t, uint32_t, uint32_t*);
+
+UnpackFunction GetUnpackFunction(TokenizerIsa isa) {
+    if (!IsTokenizerIsaSupported(isa)) {
+        throw std::invalid_argument("The CPU does not support this instruction set"s);
+    }
+    switch (isa) {
+#ifdef SEARCH_SERVER_X86_POSTINGS
+    case TokenizerIsa::AVX2:
+        return UnpackOrdinalsAvx2;
+    case TokenizerIsa::SSE2:
+        return UnpackOrdinalsSse2;
+#endif
+    default:
+        return UnpackOrdinalsScalar;
+    }
+}
+
+}  // namespace
+
+PlainPostingList::Cursor::Cursor(const PlainPostingList& postings)
+    : postings_(postings.postings_.data()), size_(postings.postings_.size()) {}
+
+uint32_t PlainPostingList::Cursor::GetDocumentOrdinal() const {
+    return index_ < size_ ? postings_[index_].document_ordinal : END_DOCUMENT_ORDINAL;
+}
+
+double PlainPostingList::Cursor::GetTermFreq() const {
+    return postings_[index_].term_freq;
+}
+
+void PlainPostingList::Cursor::Next() {
+    ++index_;
+}
+
+void PlainPostingList::Cursor::SkipTo(uint32_t document_ordinal) {
+    if (GetDocumentOrdinal() >= document_ordinal) {
+        return;
+    }
+    // Gallop first: the target is usually close to the current position
+    size_t step = 1;
+    while (index_ + step < size_ && postings_[index_ + step].document_ordinal < document_ordinal) {
+        step *= 2;
+    }
+    const Posting* range_begin = postings_ + index_ + step / 2;
+    const Posting* range_end = postings_ + std::min(index_ + step, size_);
+    index_ = std::lower_bound(range_begin, range_end, document_ordinal, IsBeforeOrdinal) - postings_;
+}
+
+void PlainPostingList::PushBack(Posting posting) {
+    postings_.Mutable().push_back(posting);
+    max_term_freq_ = std::max(max_term_freq_, posting.term_freq);
+}
+
+bool PlainPostingList::Erase(uint32_t document_ordinal) {
+    auto& postings = postings_.Mutable();
+    const auto it = std::lower_bound(postings.begin(), postings.end(), document_ordinal, IsBeforeOrdinal);
+    if (it == postings.end() || it->document_ordinal != document_ordinal) {
+        return false;
+    }
+    postings.erase(it);
+    return true;
+}
+
+bool PlainPostingList::Contains(uint32_t document_ordinal) const {
+    const auto it = std::lower_bound(postings_.begin(), postings_.end(), document_ordinal, IsBeforeOrdinal);
+    return it != postings_.end() && it->document_ordinal == document_ordinal;
+}
+
+size_t PlainPostingList::GetSize() const {
+    return postings_.size();
+}
+
+double PlainPostingList::GetMaxTermFreq() const {
+    return max_term_freq_;
+}
+
+size_t PlainPostingList::GetOrdinalEnd() const {
+    return postings_.empty() ? 0 : static_cast<size_t>(postings_.back().document_ordinal) + 1;
+}
+
+size_t PlainPostingList::GetMemoryUsage() const {
+    return postings_.size() * sizeof(Posting);
+}
+
+PlainPostingList::Cursor PlainPostingList::GetCursor() const {
+    return Cursor(*this);
+}
+
+void PlainPostingList::Save(SnapshotWriter& writer) const {
+    writer.Write(max_term_freq_);
+    writer.WriteArray(CopyPostings(postings_));
+}
+
+PlainPostingList PlainPostingList::Load(SnapshotReader& reader) {
+    PlainPostingList postings;
+    postings.max_term_freq_ = reader.Read<double>();
+    postings.postings_ = reader.ReadArray<Posting>();
+    return postings;
+}
+
+CompressedPostingList::Cursor::Cursor(const CompressedPostingList& postings)
+    : postings_(&postings) {
+    LoadBlock(0);
+}
+
+uint32_t CompressedPostingList::Cursor::GetDocumentOrdinal() const {
+    return index_ < block_size_ ? ordinals_[index_] : END_DOCUMENT_ORDINAL;
+}
+
+double CompressedPostingList::Cursor::GetTermFreq() const {
+    if (block_index_ == postings_->blocks_.size()) {
+        return postings_->tail_[index_].term_freq;
+    }
+    return postings_->term_freqs_[postings_->blocks_[block_index_].term_freq_offset + index_];
+}
+
+void CompressedPostingList::Cursor::Next() {
+    ++index_;
+    if (index_ == block_size_ && block_index_ < postings_->blocks_.size()) {
+        LoadBlock(block_index_ + 1);
+    }
+}
+
+void CompressedPostingList::Cursor::SkipTo(uint32_t document_ordinal) {
+    if (GetDocumentOrdinal() >= document_ordinal) {
+        return;
+    }
+    const auto& blocks = postings_->blocks_;
+    if (block_index_ < blocks.size() && blocks[block_index_].last_ordinal < document_ordinal) {
+        // Skip whole blocks by their headers without decoding them
+        const auto block = std::partition_point(blocks.begin() + block_index_ + 1, blocks.end(),
+            [document_ordinal](const Block& block) {
+                return block.last_ordinal < document_ordinal;
+            });
+        LoadBlock(block - blocks.begin());
+    }
+    index_ = std::lower_bound(ordinals_ + index_, ordinals_ + block_size_, document_ordinal) - ordinals_;
+}
+
+void CompressedPostingList::Cursor::LoadBlock(size_t block_index) {
+    block_index_ = block_index;
+    index_ = 0;
+    if (block_index < postings_->blocks_.size()) {
+        const Block& block = postings_->blocks_[block_index];
+        postings_->DecodeBlock(block, ordinals_);
+        block_size_ = block.size;
+    } else {
+        const auto& tail = postings_->tail_;
+        for (size_t i = 0; i < tail.size(); ++i) {
+            ordinals_[i] = tail[i].document_ordinal;
+        }
+        block_size_ = tail.size();
+    }
+}
+
+void CompressedPostingList::PushBack(Posting posting) {
+    posting.term_freq = static_cast<float>(posting.term_freq);
+    tail_.Mutable().push_back(posting);
+    max_term_freq_ = std::max(max_term_freq_, posting.term_freq);
+    ++size_;
+    if (tail_.size() == BLOCK_SIZE) {
+        PackTail();
+    }
+}
+
+bool CompressedPostingList::Erase(uint32_t document_ordinal) {
+    const auto block = FindBlock(document_ordinal);
+    if (block == blocks_.Mutable().end()) {
+        auto& tail = tail_.Mutable();
+        const auto it = std::lower_bound(tail.begin(), tail.end(), document_ordinal, IsBeforeOrdinal);
+        if (it == tail.end() || it->document_ordinal != document_ordinal) {
+            return false;
+        }
+        tail.erase(it);
+        --size_;
+        return true;
+    }
+    if (block->first_ordinal > document_ordinal) {
+        return false;
+    }
+
+    uint32_t ordinals[BLOCK_SIZE];
+    DecodeBlock(*block, ordinals);
+    const size_t block_size = block->size;
+    const auto position = std::lower_bound(ordinals, ordinals + block_size, document_ordinal);
+    if (position == ordinals + block_size || *position != document_ordinal) {
+        return false;
+    }
+    const size_t index = position - ordinals;
+    std::copy(position + 1, ordinals + block_size, position);
+    float* term_freqs = &term_freqs_.Mutable()[block->term_freq_offset];
+    std::copy(term_freqs + index + 1, term_freqs + block_size, term_freqs + index);
+    --size_;
+
+    // Removing an ordinal may widen the merged gap, so the block is packed anew
+    // at the end of the buffer; the space left behind is reclaimed by Compact
+    packed_garbage_ += block->bit_width * LANE_COUNT;
+    ++term_freq_garbage_;
+    if (block_size == 1) {
+        blocks_.Mutable().erase(block);
+    } else {
+        *block = PackBlock(ordinals, block_size - 1, block->term_freq_offset);
+    }
+    if (packed_garbage_ * 2 > packed_gaps_.size() || term_freq_garbage_ * 2 > term_freqs_.size()) {
+        Compact();
+    }
+    return true;
+}
+
+bool CompressedPostingList::Contains(uint32_t document_ordinal) const {
+    const auto block = FindBlock(document_ordinal);
+    if (block != blocks_.end()) {
+        if (block->first_ordinal > document_ordinal) {
+            return false;
+        }
+        uint32_t ordinals[BLOCK_SIZE];
+        DecodeBlock(*block, ordinals);
+        return std::binary_search(ordinals, ordinals + block->size, document_ordinal);
+    }
+    const auto it = std::lower_bound(tail_.begin(), tail_.end(), document_ordinal, IsBeforeOrdinal);
+    return it != tail_.end() && it->document_ordinal == document_ordinal;
+}
+
+size_t CompressedPostingList::GetSize() const {
+    return size_;
+}
+
+double CompressedPostingList::GetMaxTermFreq() const {
+    return max_term_freq_;
+}
+
+size_t CompressedPostingList::GetOrdinalEnd() const {
+    if (!tail_.empty()) {
+        return static_cast<size_t>(tail_.back().document_ordinal) + 1;
+    }
+    return blocks_.empty() ? 0 : static_cast<size_t>(blocks_.back().last_ordinal) + 1;
+}
+
+CompressedPostingList::Cursor CompressedPostingList::GetCursor() const {
+    return Cursor(*this);
+}
+
+void CompressedPostingList::Save(SnapshotWriter& writer) const {
+    writer.Write(static_cast<uint64_t>(size_));
+    writer.Write(max_term_freq_);
+    writer.Write(static_cast<uint64_t>(packed_garbage_));
+    writer.Write(static_cast<uint64_t>(term_freq_garbage_));
+    // Blocks are padded after bit_width
+    auto blocks = MakeZeroedArray<Block>(blocks_.size());
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        blocks[i].first_ordinal = blocks_[i].first_ordinal;
+        blocks[i].last_ordinal = blocks_[i].last_ordinal;
+        blocks[i].packed_offset = blocks_[i].packed_offset;
+        blocks[i].term_freq_offset = blocks_[i].term_freq_offset;
+        blocks[i].size = blocks_[i].size;
+        blocks[i].bit_width = blocks_[i].bit_width;
+    }
+    writer.WriteArray(blocks);
+    writer.WriteArray(packed_gaps_);
+    writer.WriteArray(term_freqs_);
+    writer.WriteArray(CopyPostings(tail_));
+}
+
+CompressedPostingList CompressedPostingList::Load(SnapshotReader& reader) {
+    CompressedPostingList postings;
+    postings.size_ = reader.Read<uint64_t>();
+    postings.max_term_freq_ = reader.Read<double>();
+    postings.packed_garbage_ = reader.Read<uint64_t>();
+    postings.term_freq_garbage_ = reader.Read<uint64_t>();
+    postings.blocks_ = reader.ReadArray<Block>();
+    postings.packed_gaps_ = reader.ReadArray<uint32_t>();
+    postings.term_freqs_ = reader.ReadArray<float>();
+    postings.tail_ = reader.ReadArray<Posting>();
+    return postings;
+}
+
+size_t CompressedPostingList::GetMemoryUsage() const {
+    return blocks_.size() * sizeof(Block) + packed_gaps_.size() * sizeof(uint32_t)
+        + term_freqs_.size() * sizeof(float) + tail_.size() * sizeof(Posting);
+}
+
+std::vector<CompressedPostingList::Block>::iterator CompressedPostingList::FindBlock(uint32_t document_ordinal) {
+    auto& blocks = blocks_.Mutable();
+    return std::partition_point(blocks.begin(), blocks.end(), [document_ordinal](const Block& block) {
+        return block.last_ordinal < document_ordinal;
+    });
+}
+
+const CompressedPostingList::Block* CompressedPostingList::FindBlock(uint32_t document_ordinal) const {
+    return std::partition_point(blocks_.begin(), blocks_.end(), [document_ordinal](const Block& block) {
+        return block.last_ordinal < document_ordinal;
+    });
+}
+
+void CompressedPostingList::PackTail() {
+    uint32_t ordinals[BLOCK_SIZE];
+    for (size_t i = 0; i < tail_.size(); ++i) {
+        ordinals[i] = tail_[i].document_ordinal;
+    }
+    const Block block = PackBlock(ordinals, tail_.size(), static_cast<uint32_t>(term_freqs_.size()));
+    blocks_.Mutable().push_back(block);
+    auto& term_freqs = term_freqs_.Mutable();
+    for (const Posting& posting : tail_) {
+        term_freqs.push_back(static_cast<float>(posting.term_freq));
+    }
+    tail_.Mutable().clear();
+}
+
+CompressedPostingList::Block CompressedPostingList::PackBlock(const uint32_t* ordinals, size_t size, uint32_t term_freq_offset) {
+    uint32_t gaps[BLOCK_SIZE] = {};
+    uint32_t max_gap = 0;
+    for (size_t i = 1; i < size; ++i) {
+        gaps[i] = ordinals[i] - ordinals[i - 1];
+        max_gap = std::max(max_gap, gaps[i]);
+    }
+
+    Block block;
+    block.first_ordinal = ordinals[0];
+    block.last_ordinal = ordinals[size - 1];
+    block.packed_offset = static_cast<uint32_t>(packed_gaps_.size());
+    block.term_freq_offset = term_freq_offset;
+    block.size = static_cast<uint16_t>(size);
+    block.bit_width = GetBitWidth(max_gap);
+
+    auto& packed_gaps = packed_gaps_.Mutable();
+    packed_gaps.resize(packed_gaps.size() + block.bit_width * LANE_COUNT);
+    PackGaps(gaps, block.bit_width, packed_gaps.data() + block.packed_offset);
+    return block;
+}
+
+void CompressedPostingList::Compact() {
+    std::vector<uint32_t> packed_gaps;
+    std::vector<float> term_freqs;
+    packed_gaps.reserve(packed_gaps_.size() - packed_garbage_);
+    term_freqs.reserve(term_freqs_.size() - term_freq_garbage_);
+    for (Block& block : blocks_.Mutable()) {
+        const auto packed_begin = packed_gaps_.begin() + block.packed_offset;
+        const auto term_freqs_begin = term_freqs_.begin() + block.term_freq_offset;
+        block.packed_offset = static_cast<uint32_t>(packed_gaps.size());
+        block.term_freq_offset = static_cast<uint32_t>(term_freqs.size());
+        packed_gaps.insert(packed_gaps.end(), packed_begin, packed_begin + block.bit_width * LANE_COUNT);
+        term_freqs.insert(term_freqs.end(), term_freqs_begin, term_freqs_begin + block.size);
+    }
+    packed_gaps_ = MappedVector<uint32_t>(std::move(packed_gaps));
+    term_freqs_ = MappedVector<float>(std::move(term_freqs));
+    packed_garbage_ = 0;
+    term_freq_garbage_ = 0;
+}
+
+void CompressedPostingList::DecodeBlock(const Block& block, uint32_t* ordinals) const {
+    if (block.bit_width == 0) {
+        std::fill(ordinals, ordinals + BLOCK_SIZE, block.first_ordinal);
+        return;
+    }
+    // The widest instruction set, chosen once as for the tokenizer
+    static const UnpackFunction unpack = GetUnpackFunction(GetTokenizerIsa());
+    unpack(packed_gaps_.data() + block.packed_offset, block.bit_width, block.first_ordinal, ordinals);
+}
+
+void UnpackOrdinals(const uint32_t* packed, uint8_t bit_width, uint32_t first_ordinal, uint32_t* ordinals, TokenizerIsa isa) {
+    GetUnpackFunction(isa)(packed, bit_width, first_ordinal, ordinals);
+}
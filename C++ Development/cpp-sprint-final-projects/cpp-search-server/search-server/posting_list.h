@@ -0,0 +1,182 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "mapped_vector.h"
+#include "snapshot_io.h"
+#include "string_processing.h"
+
+struct Posting {
+    uint32_t document_ordinal;
+    double term_freq;
+};
+
+// Reported by cursors moved past the last posting; never used as a real ordinal
+constexpr uint32_t END_DOCUMENT_ORDINAL = std::numeric_limits<uint32_t>::max();
+
+// Postings of one term sorted by document ordinal, stored as is
+class PlainPostingList {
+public:
+    // Walks the postings in order and can skip ahead to a given ordinal
+    class Cursor {
+    public:
+        explicit Cursor(const PlainPostingList& postings);
+
+        // END_DOCUMENT_ORDINAL once the postings are exhausted
+        uint32_t GetDocumentOrdinal() const;
+        double GetTermFreq() const;
+        void Next();
+        // Moves to the first posting whose ordinal is not less than the given one
+        void SkipTo(uint32_t document_ordinal);
+
+    private:
+        const Posting* postings_;
+        size_t size_;
+        size_t index_ = 0;
+    };
+
+    // Ordinals must be pushed in increasing order
+    void PushBack(Posting posting);
+    // Returns false if there is no posting for the document
+    bool Erase(uint32_t document_ordinal);
+    bool Contains(uint32_t document_ordinal) const;
+    size_t GetSize() const;
+    // Upper bound of the term frequencies; it is not lowered when postings are erased
+    double GetMaxTermFreq() const;
+    // One past the ordinal of the last posting, 0 if there are none
+    size_t GetOrdinalEnd() const;
+    // Bytes taken by the stored postings
+    size_t GetMemoryUsage() const;
+    Cursor GetCursor() const;
+
+    // Stored in snapshots, so that lists are loaded only by the type that saved them
+    static constexpr uint32_t SNAPSHOT_FORMAT = 1;
+    void Save(SnapshotWriter& writer) const;
+    // The postings are used in place and copied only when the list is modified
+    static PlainPostingList Load(SnapshotReader& reader);
+
+    template <typename Function>
+    void ForEach(Function function) const {
+        for (const Posting& posting : postings_) {
+            function(posting);
+        }
+    }
+
+private:
+    MappedVector<Posting> postings_;
+    double max_term_freq_ = 0.0;
+};
+
+// Postings of one term sorted by document ordinal, stored in blocks of BLOCK_SIZE.
+// Within a block the gaps between ordinals are bit-packed with the smallest width
+// that fits all of them, and term frequencies are quantized to float.
+// The newest postings stay unpacked until a whole block is collected
+class CompressedPostingList {
+public:
+    static constexpr size_t BLOCK_SIZE = 128;
+
+    // Walks the postings in order and can skip ahead to a given ordinal,
+    // decoding only the blocks it stops in
+    class Cursor {
+    public:
+        explicit Cursor(const CompressedPostingList& postings);
+
+        // END_DOCUMENT_ORDINAL once the postings are exhausted
+        uint32_t GetDocumentOrdinal() const;
+        double GetTermFreq() const;
+        void Next();
+        // Moves to the first posting whose ordinal is not less than the given one
+        void SkipTo(uint32_t document_ordinal);
+
+    private:
+        const CompressedPostingList* postings_;
+        // Equals the number of blocks while walking the unpacked tail
+        size_t block_index_ = 0;
+        size_t index_ = 0;
+        size_t block_size_ = 0;
+        uint32_t ordinals_[BLOCK_SIZE];
+
+        void LoadBlock(size_t block_index);
+    };
+
+    // Ordinals must be pushed in increasing order
+    void PushBack(Posting posting);
+    // Returns false if there is no posting for the document
+    bool Erase(uint32_t document_ordinal);
+    bool Contains(uint32_t document_ordinal) const;
+    size_t GetSize() const;
+    // Upper bound of the term frequencies; it is not lowered when postings are erased
+    double GetMaxTermFreq() const;
+    // One past the last ordinal of the last block or of the tail, 0 if there are none
+    size_t GetOrdinalEnd() const;
+    // Bytes taken by the packed blocks, their headers and the unpacked tail
+    size_t GetMemoryUsage() const;
+    Cursor GetCursor() const;
+
+    static constexpr uint32_t SNAPSHOT_FORMAT = 2;
+    void Save(SnapshotWriter& writer) const;
+    // The blocks are used in place and copied only when the list is modified
+    static CompressedPostingList Load(SnapshotReader& reader);
+
+    template <typename Function>
+    void ForEach(Function function) const {
+        uint32_t ordinals[BLOCK_SIZE];
+        for (const Block& block : blocks_) {
+            DecodeBlock(block, ordinals);
+            const float* term_freqs = &term_freqs_[block.term_freq_offset];
+            for (size_t i = 0; i < block.size; ++i) {
+                function(Posting{ordinals[i], term_freqs[i]});
+            }
+        }
+        for (const Posting& posting : tail_) {
+            function(posting);
+        }
+    }
+
+private:
+    struct Block {
+        uint32_t first_ordinal;
+        uint32_t last_ordinal;
+        uint32_t packed_offset;
+        uint32_t term_freq_offset;
+        uint16_t size;
+        uint8_t bit_width;
+    };
+
+    MappedVector<Block> blocks_;
+    // Gaps of each block take bit_width * 4 words. Gap i is stored in lane i % 4,
+    // so that four consecutive gaps are unpacked with one vector instruction
+    MappedVector<uint32_t> packed_gaps_;
+    MappedVector<float> term_freqs_;
+    MappedVector<Posting> tail_;
+    size_t size_ = 0;
+    double max_term_freq_ = 0.0;
+    // Space in packed_gaps_ and term_freqs_ no longer referenced by any block
+    size_t packed_garbage_ = 0;
+    size_t term_freq_garbage_ = 0;
+
+    std::vector<Block>::iterator FindBlock(uint32_t document_ordinal);
+    const Block* FindBlock(uint32_t document_ordinal) const;
+    void PackTail();
+    // Appends the gaps of the ordinals to packed_gaps_ and returns the block describing them
+    Block PackBlock(const uint32_t* ordinals, size_t size, uint32_t term_freq_offset);
+    void Compact();
+    // Writes BLOCK_SIZE ordinals; only the first block.size of them are meaningful
+    void DecodeBlock(const Block& block, uint32_t* ordinals) const;
+};
+
+// Build with -DSEARCH_SERVER_COMPRESSED_POSTINGS to trade a little term frequency
+// precision and decoding time for several times smaller posting lists
+// Decodes the BLOCK_SIZE ordinals of a block of CompressedPostingList: gaps of bit_width bits,
+// packed in four interleaved lanes, added up from first_ordinal. Blocks are decoded with
+// the widest instruction set of GetTokenizerIsa; this picks one, so that the decoders
+// can be compared. Throws std::invalid_argument if the CPU does not support it
+void UnpackOrdinals(const uint32_t* packed, uint8_t bit_width, uint32_t first_ordinal, uint32_t* ordinals, TokenizerIsa isa);
+
+#ifdef SEARCH_SERVER_COMPRESSED_POSTINGS
+using PostingList = CompressedPostingList;
+#else
+using PostingList = PlainPostingList;
+#endif
@@ -0,0 +1,49 @@
+#include "process_queries.h"
+#include <algorithm>
+#include <exception>
+#include <execution>
+
+JoinedDocuments::JoinedDocuments(std::vector<std::vector<Document>> documents)
+    : documents_(std::move(documents)) {
+    for (const auto& query_documents : documents_) {
+        size_ += query_documents.size();
+    }
+}
+
+JoinedDocuments::Iterator JoinedDocuments::begin() const {
+    return {documents_.begin(), documents_.end()};
+}
+
+JoinedDocuments::Iterator JoinedDocuments::end() const {
+    return {documents_.end(), documents_.end()};
+}
+
+size_t JoinedDocuments::size() const {
+    return size_;
+}
+
+std::vector<std::vector<Document>> ProcessQueries(const SearchServer& search_server, const std::vector<std::string>& queries) {
+    std::vector<std::vector<Document>> documents_lists(queries.size());
+    // An exception must not leave a parallel algorithm, so each query keeps its own
+    // and the first one in query order is rethrown
+    std::vector<std::exception_ptr> errors(queries.size());
+    std::transform(std::execution::par, queries.begin(), queries.end(), errors.begin(), documents_lists.begin(),
+        [&search_server](const std::string& query, std::exception_ptr& error) {
+            try {
+                return search_server.FindTopDocuments(query);
+            } catch (...) {
+                error = std::current_exception();
+                return std::vector<Document>{};
+            }
+        });
+    for (const std::exception_ptr& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+    return documents_lists;
+}
+
+JoinedDocuments ProcessQueriesJoined(const SearchServer& search_server, const std::vector<std::string>& queries) {
+    return JoinedDocuments(ProcessQueries(search_server, queries));
+}
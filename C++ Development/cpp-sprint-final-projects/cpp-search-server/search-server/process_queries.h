@@ -0,0 +1,88 @@
+#pragma once
+
+#include <iterator>
+#include <string>
+#include <vector>
+#include "document.h"
+#include "search_server.h"
+
+// Results of several queries read as one sequence of documents, in query order.
+// Iterates over the per-query vectors in place instead of copying them together
+class JoinedDocuments {
+public:
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Document;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Document*;
+        using reference = const Document&;
+
+        Iterator() = default;
+
+        reference operator*() const {
+            return (*query_)[index_];
+        }
+
+        pointer operator->() const {
+            return &**this;
+        }
+
+        Iterator& operator++() {
+            ++index_;
+            SkipExhaustedQueries();
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        bool operator==(const Iterator& other) const {
+            return query_ == other.query_ && index_ == other.index_;
+        }
+
+        bool operator!=(const Iterator& other) const {
+            return !(*this == other);
+        }
+
+    private:
+        friend class JoinedDocuments;
+
+        using QueryIterator = std::vector<std::vector<Document>>::const_iterator;
+
+        Iterator(QueryIterator query, QueryIterator queries_end)
+            : query_(query), queries_end_(queries_end) {
+            SkipExhaustedQueries();
+        }
+
+        void SkipExhaustedQueries() {
+            while (query_ != queries_end_ && index_ == query_->size()) {
+                ++query_;
+                index_ = 0;
+            }
+        }
+
+        QueryIterator query_;
+        QueryIterator queries_end_;
+        size_t index_ = 0;
+    };
+
+    explicit JoinedDocuments(std::vector<std::vector<Document>> documents);
+
+    Iterator begin() const;
+    Iterator end() const;
+    size_t size() const;
+
+private:
+    std::vector<std::vector<Document>> documents_;
+    size_t size_ = 0;
+};
+
+// Runs the queries in parallel and returns the results of each of them in query order.
+// If queries are invalid, throws the exception of the first of them
+std::vector<std::vector<Document>> ProcessQueries(const SearchServer& search_server, const std::vector<std::string>& queries);
+
+JoinedDocuments ProcessQueriesJoined(const SearchServer& search_server, const std::vector<std::string>& queries);
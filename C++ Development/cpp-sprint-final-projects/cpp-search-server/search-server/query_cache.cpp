@@ -0,0 +1,71 @@
+#include "query_cache.h"
+#include <functional>
+
+QueryCache::QueryCache(size_t capacity)
+    : shard_capacity_((capacity + SHARD_COUNT - 1) / SHARD_COUNT), shards_(SHARD_COUNT) {}
+
+uint64_t QueryCache::GetGeneration() const {
+    return generation_.load();
+}
+
+void QueryCache::Invalidate() {
+    ++generation_;
+}
+
+std::optional<std::vector<Document>> QueryCache::Find(const std::string& key) {
+    Shard& shard = GetShard(key);
+    std::lock_guard guard(shard.mutex);
+    const auto it = shard.key_to_entry.find(key);
+    if (it == shard.key_to_entry.end()) {
+        ++shard.miss_count;
+        return std::nullopt;
+    }
+    const auto entry = it->second;
+    if (entry->generation != generation_.load()) {
+        shard.key_to_entry.erase(it);
+        shard.entries.erase(entry);
+        ++shard.miss_count;
+        return std::nullopt;
+    }
+    shard.entries.splice(shard.entries.begin(), shard.entries, entry);
+    ++shard.hit_count;
+    return entry->documents;
+}
+
+void QueryCache::Insert(const std::string& key, uint64_t generation, const std::vector<Document>& documents) {
+    if (shard_capacity_ == 0 || generation != generation_.load()) {
+        return;
+    }
+    Shard& shard = GetShard(key);
+    std::lock_guard guard(shard.mutex);
+    if (const auto it = shard.key_to_entry.find(key); it != shard.key_to_entry.end()) {
+        // Another thread has searched for the same query meanwhile
+        it->second->generation = generation;
+        it->second->documents = documents;
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+        return;
+    }
+    if (shard.entries.size() == shard_capacity_) {
+        shard.key_to_entry.erase(shard.entries.back().key);
+        shard.entries.pop_back();
+        ++shard.eviction_count;
+    }
+    shard.entries.push_front({key, generation, documents});
+    shard.key_to_entry.emplace(shard.entries.front().key, shard.entries.begin());
+}
+
+QueryCacheStats QueryCache::GetStats() const {
+    QueryCacheStats stats;
+    for (const Shard& shard : shards_) {
+        std::lock_guard guard(shard.mutex);
+        stats.hit_count += shard.hit_count;
+        stats.miss_count += shard.miss_count;
+        stats.eviction_count += shard.eviction_count;
+        stats.size += shard.entries.size();
+    }
+    return stats;
+}
+
+QueryCache::Shard& QueryCache::GetShard(const std::string& key) {
+    return shards_[std::hash<std::string>{}(key) % shards_.size()];
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "document.h"
+
+struct QueryCacheStats {
+    uint64_t hit_count = 0;
+    uint64_t miss_count = 0;
+    uint64_t eviction_count = 0;
+    size_t size = 0;
+};
+
+// Least recently used search results, split into shards by key, each guarded
+// by its own mutex. Results are stamped with the generation they were computed
+// at; Invalidate starts a new generation, which turns all earlier results stale
+class QueryCache {
+public:
+    // Capacity is the total number of kept results, split evenly between the shards
+    explicit QueryCache(size_t capacity);
+
+    uint64_t GetGeneration() const;
+    void Invalidate();
+
+    // Stale results are dropped and reported as misses
+    std::optional<std::vector<Document>> Find(const std::string& key);
+    // Generation must be taken before the documents were searched for
+    void Insert(const std::string& key, uint64_t generation, const std::vector<Document>& documents);
+
+    QueryCacheStats GetStats() const;
+
+private:
+    struct Entry {
+        std::string key;
+        uint64_t generation;
+        std::vector<Document> documents;
+    };
+
+    // Entries are ordered from the most to the least recently used
+    struct Shard {
+        mutable std::mutex mutex;
+        std::list<Entry> entries;
+        std::unordered_map<std::string_view, std::list<Entry>::iterator> key_to_entry;
+        uint64_t hit_count = 0;
+        uint64_t miss_count = 0;
+        uint64_t eviction_count = 0;
+    };
+
+    static constexpr size_t SHARD_COUNT = 16;
+
+    size_t shard_capacity_;
+    std::atomic<uint64_t> generation_{0};
+    std::vector<Shard> shards_;
+
+    Shard& GetShard(const std::string& key);
+};
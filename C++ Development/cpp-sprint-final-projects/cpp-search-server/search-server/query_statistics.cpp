@@ -0,0 +1,10 @@
+#include "query_statistics.h"
+
+QueryStatistics& QueryStatistics::operator+=(const QueryStatistics& other) {
+    document_count += other.document_count;
+    document_length_sum += other.document_length_sum;
+    for (const auto& [word, document_freq] : other.document_freqs) {
+        document_freqs[word] += document_freq;
+    }
+    return *this;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+// Number and total length of documents and document frequencies of the plus words of a query.
+// Statistics of disjoint parts of a collection add up to the statistics of the whole,
+// so that servers holding the parts can rank documents exactly as a single server would
+struct QueryStatistics {
+    int document_count = 0;
+    // In words, as counted for DocumentLength; BM25 divides it by document_count
+    uint64_t document_length_sum = 0;
+    std::map<std::string, int, std::less<>> document_freqs;
+
+    QueryStatistics& operator+=(const QueryStatistics& other);
+};
@@ -0,0 +1,42 @@
+#include "read_epochs.h"
+#include <chrono>
+#include <functional>
+#include <thread>
+
+ReadEpochs::ReadGuard::ReadGuard(std::atomic<int64_t>& counter)
+    : counter_(counter) {
+    counter_.fetch_add(1);
+}
+
+ReadEpochs::ReadGuard::~ReadGuard() {
+    counter_.fetch_sub(1);
+}
+
+ReadEpochs::ReadGuard ReadEpochs::Enter() {
+    const size_t slot = std::hash<std::thread::id>{}(std::this_thread::get_id()) % SLOT_COUNT;
+    return ReadGuard(counters_[epoch_.load()][slot].value);
+}
+
+void ReadEpochs::Synchronize() {
+    const size_t previous_epoch = epoch_.load();
+    const size_t next_epoch = previous_epoch ^ 1;
+    // Readers that loaded the epoch before the previous advance may still be
+    // registering in the next one, so it has to drain before it is reused
+    WaitForReaders(next_epoch);
+    epoch_.store(next_epoch);
+    WaitForReaders(previous_epoch);
+}
+
+void ReadEpochs::WaitForReaders(size_t epoch) const {
+    for (const Counter& counter : counters_[epoch]) {
+        // Queries are short, so the writer spins at first; a long one is
+        // waited out in sleeps not to take the core from the reader
+        for (int attempt = 0; counter.value.load() != 0; ++attempt) {
+            if (attempt < SPIN_COUNT) {
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        }
+    }
+}
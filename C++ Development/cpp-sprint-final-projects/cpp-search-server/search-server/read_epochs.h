@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Counts readers by the epoch they entered in. The epoch alternates between
+// two values; a writer advances it and waits until the readers of the previous
+// epoch are gone, after which no reader that started earlier is still running.
+// Readers never wait. Counters are spread over cache lines by thread,
+// so that readers on different cores rarely touch the same line
+class ReadEpochs {
+public:
+    // Keeps the reader counted while alive
+    class ReadGuard {
+    public:
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+        ~ReadGuard();
+
+    private:
+        friend class ReadEpochs;
+
+        explicit ReadGuard(std::atomic<int64_t>& counter);
+
+        std::atomic<int64_t>& counter_;
+    };
+
+    ReadGuard Enter();
+    // Returns once every reader that entered before the call has left.
+    // Must not be called by several threads at once
+    void Synchronize();
+
+private:
+    struct alignas(64) Counter {
+        std::atomic<int64_t> value{0};
+    };
+
+    static constexpr size_t SLOT_COUNT = 64;
+    static constexpr int SPIN_COUNT = 100;
+
+    std::atomic<size_t> epoch_{0};
+    Counter counters_[2][SLOT_COUNT];
+
+    void WaitForReaders(size_t epoch) const;
+};
@@ -0,0 +1,13 @@
+#include "relevance_accumulator.h"
+
+void RelevanceAccumulator::Reset(uint32_t begin, uint32_t size) {
+    for (const uint32_t index : touched_indices_) {
+        is_touched_[index] = 0;
+    }
+    touched_indices_.clear();
+    if (relevances_.size() < size) {
+        relevances_.resize(size);
+        is_touched_.resize(size, 0);
+    }
+    begin_ = begin;
+}
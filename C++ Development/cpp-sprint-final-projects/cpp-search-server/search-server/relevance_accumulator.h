@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Relevances of a range of document ordinals, summed one term at a time into a
+// flat array. The ordinals touched are listed, so that reading the relevances
+// and clearing them for the next range take time proportional to the documents
+// found rather than to the length of the range. Meant to be reused
+class RelevanceAccumulator {
+public:
+    // Starts over with the ordinals from begin to begin + size
+    void Reset(uint32_t begin, uint32_t size);
+    // The ordinal must be in the range
+    void Add(uint32_t ordinal, double relevance);
+
+    // Calls function(ordinal, relevance) for every ordinal touched since Reset,
+    // in the order they were first touched
+    template <typename Function>
+    void ForEachTouched(Function function) const;
+
+private:
+    uint32_t begin_ = 0;
+    std::vector<double> relevances_;
+    // A relevance can be zero, so touched ordinals are told apart by a flag
+    std::vector<uint8_t> is_touched_;
+    std::vector<uint32_t> touched_indices_;
+};
+
+inline void RelevanceAccumulator::Add(uint32_t ordinal, double relevance) {
+    const uint32_t index = ordinal - begin_;
+    if (is_touched_[index] == 0) {
+        is_touched_[index] = 1;
+        touched_indices_.push_back(index);
+        relevances_[index] = relevance;
+    } else {
+        relevances_[index] += relevance;
+    }
+}
+
+template <typename Function>
+void RelevanceAccumulator::ForEachTouched(Function function) const {
+    for (const uint32_t index : touched_indices_) {
+        function(begin_ + index, relevances_[index]);
+    }
+}
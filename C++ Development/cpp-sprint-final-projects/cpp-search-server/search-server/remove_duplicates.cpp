@@ -0,0 +1,51 @@
+#include "remove_duplicates.h"
+#include <iostream>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+using namespace std::literals;
+
+namespace {
+
+struct WordSetHasher {
+    size_t operator()(const std::vector<std::string_view>& words) const {
+        size_t hash = words.size();
+        for (const std::string_view word : words) {
+            hash = hash * 37 + hasher(word);
+        }
+        return hash;
+    }
+
+    std::hash<std::string_view> hasher;
+};
+
+}  // namespace
+
+void RemoveDuplicates(SearchServer& search_server, const std::function<void(int)>& on_duplicate) {
+    std::unordered_set<std::vector<std::string_view>, WordSetHasher> word_sets;
+    std::vector<int> duplicate_ids;
+    // Ids are visited in ascending order, so the first document of each word set is kept
+    for (const int document_id : search_server) {
+        const auto& word_freqs = search_server.GetWordFrequencies(document_id);
+        std::vector<std::string_view> words;
+        words.reserve(word_freqs.size());
+        for (const auto& [word, _] : word_freqs) {
+            words.push_back(word);
+        }
+        if (!word_sets.insert(std::move(words)).second) {
+            duplicate_ids.push_back(document_id);
+        }
+    }
+
+    for (const int document_id : duplicate_ids) {
+        on_duplicate(document_id);
+        search_server.RemoveDocument(document_id);
+    }
+}
+
+void RemoveDuplicates(SearchServer& search_server) {
+    RemoveDuplicates(search_server, [](int document_id) {
+        std::cout << "Found duplicate document id "s << document_id << std::endl;
+    });
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <functional>
+#include "search_server.h"
+
+// Removes every document whose set of words equals that of a document with a lower id.
+// The id of each removed document is passed to on_duplicate before it is removed
+void RemoveDuplicates(SearchServer& search_server, const std::function<void(int)>& on_duplicate);
+
+// Reports the removed documents to std::cout
+void RemoveDuplicates(SearchServer& search_server);
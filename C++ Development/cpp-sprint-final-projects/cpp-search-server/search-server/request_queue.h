@@ -1,29 +1,77 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <execution>
 #include <vector>
-#include <deque>
+#include <string_view>
 #include "document.h"
+#include "request_statistics.h"
 #include "search_server.h"
 
+// Runs search requests and keeps statistics on them. Requests may come
+// from several threads at once; recording them takes no locks
 class RequestQueue {
 public:
     explicit RequestQueue(const SearchServer& search_server);
 
     template <typename DocumentPredicate>
-    std::vector<Document> AddFindRequest(const std::string& raw_query, DocumentPredicate document_predicate);
+    std::vector<Document> AddFindRequest(std::string_view raw_query, DocumentPredicate document_predicate);
     
-    std::vector<Document> AddFindRequest(const std::string& raw_query, DocumentStatus status);
-    std::vector<Document> AddFindRequest(const std::string& raw_query);
+    std::vector<Document> AddFindRequest(std::string_view raw_query, DocumentStatus status);
+    std::vector<Document> AddFindRequest(std::string_view raw_query);
+
+    template <typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> AddFindRequest(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate);
+
+    template <typename ExecutionPolicy>
+    std::vector<Document> AddFindRequest(ExecutionPolicy&& policy, std::string_view raw_query, DocumentStatus status);
+
+    template <typename ExecutionPolicy>
+    std::vector<Document> AddFindRequest(ExecutionPolicy&& policy, std::string_view raw_query);
+
+    // Among the last min_in_day_ requests
     int GetNoResultRequests() const;
+    // Request counts and latencies over the last minute, hour or day
+    RequestWindowStats GetStats(StatisticsWindow window) const;
 
 private:
-    struct QueryResult {
-        bool is_empty;
-        int time;
-    };
-    std::deque<QueryResult> requests_;
     static const int min_in_day_ = 1440;
-    int no_result_count_;
-    int current_time_;
+    // Whether each of the last min_in_day_ requests found nothing, indexed by request number
+    std::array<std::atomic<bool>, min_in_day_> is_empty_results_{};
+    std::atomic<uint64_t> request_count_{0};
+    std::atomic<int> no_result_count_{0};
+    RequestStatistics statistics_;
     const SearchServer& search_server_;
-};
\ No newline at end of file
+
+    void RecordRequest(RequestStatistics::Clock::time_point start_time, bool is_empty);
+};
+
+// Template method implementations
+
+template <typename DocumentPredicate>
+std::vector<Document> RequestQueue::AddFindRequest(std::string_view raw_query, DocumentPredicate document_predicate) {
+    return AddFindRequest(std::execution::seq, raw_query, document_predicate);
+}
+
+template <typename ExecutionPolicy, typename DocumentPredicate>
+std::vector<Document> RequestQueue::AddFindRequest(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate) {
+    const auto start_time = RequestStatistics::Clock::now();
+    std::vector<Document> results = search_server_.FindTopDocuments(policy, raw_query, document_predicate);
+    RecordRequest(start_time, results.empty());
+    return results;
+}
+
+template <typename ExecutionPolicy>
+std::vector<Document> RequestQueue::AddFindRequest(ExecutionPolicy&& policy, std::string_view raw_query, DocumentStatus status) {
+    // Goes to the server by status, so the request may hit its query cache and status bitmaps
+    const auto start_time = RequestStatistics::Clock::now();
+    std::vector<Document> results = search_server_.FindTopDocuments(policy, raw_query, status);
+    RecordRequest(start_time, results.empty());
+    return results;
+}
+
+template <typename ExecutionPolicy>
+std::vector<Document> RequestQueue::AddFindRequest(ExecutionPolicy&& policy, std::string_view raw_query) {
+    return AddFindRequest(policy, raw_query, DocumentStatus::ACTUAL);
+}
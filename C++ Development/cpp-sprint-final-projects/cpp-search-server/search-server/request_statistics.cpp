@@ -0,0 +1,124 @@
+#include "request_statistics.h"
+#include <unordered_map>
+#include <utility>
+
+namespace {
+
+std::atomic<uint64_t> next_statistics_id{0};
+
+// Adds to a counter that only the calling thread writes. A reader that loads
+// the new value also sees the bucket period stored before it
+void Increment(std::atomic<uint64_t>& counter) {
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+}  // namespace
+
+std::chrono::microseconds RequestWindowStats::GetLatencyPercentile(double percentile) const {
+    if (request_count == 0) {
+        return std::chrono::microseconds(0);
+    }
+    const double rank = percentile / 100.0 * static_cast<double>(request_count);
+    uint64_t counted = 0;
+    for (size_t bucket = 0; bucket + 1 < latency_histogram.size(); ++bucket) {
+        counted += latency_histogram[bucket];
+        if (static_cast<double>(counted) >= rank) {
+            return std::chrono::microseconds(int64_t{1} << bucket);
+        }
+    }
+    return std::chrono::microseconds(int64_t{1} << (latency_histogram.size() - 1));
+}
+
+RequestStatistics::ThreadBuckets::ThreadBuckets() {
+    for (size_t window = 0; window < WINDOW_COUNT; ++window) {
+        windows[window] = std::vector<Bucket>(WINDOW_LAYOUTS[window].bucket_count);
+    }
+}
+
+RequestStatistics::RequestStatistics()
+    : id_(next_statistics_id.fetch_add(1)) {}
+
+RequestStatistics::~RequestStatistics() {
+    ThreadBuckets* buckets = thread_buckets_.load();
+    while (buckets != nullptr) {
+        delete std::exchange(buckets, buckets->next);
+    }
+}
+
+void RequestStatistics::Record(Clock::time_point time, bool is_empty, Clock::duration latency) {
+    ThreadBuckets& thread_buckets = GetThreadBuckets();
+    const size_t latency_bucket = GetLatencyBucket(latency);
+    for (size_t window = 0; window < WINDOW_COUNT; ++window) {
+        const int64_t period = time.time_since_epoch() / WINDOW_LAYOUTS[window].bucket_length;
+        std::vector<Bucket>& buckets = thread_buckets.windows[window];
+        Bucket& bucket = buckets[static_cast<size_t>(period) % buckets.size()];
+        if (bucket.period.load(std::memory_order_relaxed) != period) {
+            // A reader that loads a count of the new period sees the period change
+            // when it checks the period again, and skips the bucket
+            bucket.period.store(EMPTY_PERIOD, std::memory_order_relaxed);
+            bucket.request_count.store(0, std::memory_order_release);
+            bucket.no_result_count.store(0, std::memory_order_release);
+            for (auto& count : bucket.latency_histogram) {
+                count.store(0, std::memory_order_release);
+            }
+            bucket.period.store(period, std::memory_order_release);
+        }
+        Increment(bucket.request_count);
+        if (is_empty) {
+            Increment(bucket.no_result_count);
+        }
+        Increment(bucket.latency_histogram[latency_bucket]);
+    }
+}
+
+RequestWindowStats RequestStatistics::GetStats(StatisticsWindow window, Clock::time_point now) const {
+    const WindowLayout& layout = WINDOW_LAYOUTS[static_cast<size_t>(window)];
+    const int64_t current_period = now.time_since_epoch() / layout.bucket_length;
+    RequestWindowStats stats;
+    for (const ThreadBuckets* thread_buckets = thread_buckets_.load(); thread_buckets != nullptr;
+         thread_buckets = thread_buckets->next) {
+        for (const Bucket& bucket : thread_buckets->windows[static_cast<size_t>(window)]) {
+            const int64_t period = bucket.period.load(std::memory_order_acquire);
+            if (period == EMPTY_PERIOD || period > current_period
+                || period <= current_period - static_cast<int64_t>(layout.bucket_count)) {
+                continue;
+            }
+            RequestWindowStats bucket_stats;
+            bucket_stats.request_count = bucket.request_count.load(std::memory_order_acquire);
+            bucket_stats.no_result_count = bucket.no_result_count.load(std::memory_order_acquire);
+            for (size_t i = 0; i < bucket_stats.latency_histogram.size(); ++i) {
+                bucket_stats.latency_histogram[i] = bucket.latency_histogram[i].load(std::memory_order_acquire);
+            }
+            if (bucket.period.load(std::memory_order_relaxed) != period) {
+                continue;
+            }
+            stats.request_count += bucket_stats.request_count;
+            stats.no_result_count += bucket_stats.no_result_count;
+            for (size_t i = 0; i < stats.latency_histogram.size(); ++i) {
+                stats.latency_histogram[i] += bucket_stats.latency_histogram[i];
+            }
+        }
+    }
+    return stats;
+}
+
+RequestStatistics::ThreadBuckets& RequestStatistics::GetThreadBuckets() {
+    thread_local std::unordered_map<uint64_t, ThreadBuckets*> registered_buckets;
+    ThreadBuckets*& buckets = registered_buckets[id_];
+    if (buckets == nullptr) {
+        buckets = new ThreadBuckets();
+        buckets->next = thread_buckets_.load();
+        while (!thread_buckets_.compare_exchange_weak(buckets->next, buckets)) {
+        }
+    }
+    return *buckets;
+}
+
+size_t RequestStatistics::GetLatencyBucket(Clock::duration latency) {
+    const auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+    size_t bucket = 0;
+    while (bucket + 1 < RequestWindowStats::LATENCY_BUCKET_COUNT && (int64_t{1} << bucket) <= microseconds) {
+        ++bucket;
+    }
+    return bucket;
+}
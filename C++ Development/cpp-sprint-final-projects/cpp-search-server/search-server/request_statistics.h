@@ -0,0 +1,87 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum class StatisticsWindow {
+    MINUTE,
+    HOUR,
+    DAY,
+};
+
+struct RequestWindowStats {
+    // Bucket 0 counts latencies under 1 us, bucket i > 0 counts latencies
+    // from 2^(i - 1) up to 2^i us; the last bucket counts all longer ones
+    static constexpr size_t LATENCY_BUCKET_COUNT = 32;
+
+    uint64_t request_count = 0;
+    uint64_t no_result_count = 0;
+    std::array<uint64_t, LATENCY_BUCKET_COUNT> latency_histogram{};
+
+    // Upper bound of the histogram bucket holding the given percentile of latencies,
+    // zero if there are no requests
+    std::chrono::microseconds GetLatencyPercentile(double percentile) const;
+};
+
+// Counts requests, requests without results and their latencies over the last
+// minute, hour and day. Every thread records into its own ring buffers of time
+// buckets; a window slides by its bucket: a second, a minute or an hour.
+// Recording takes no locks and does not wait for other threads, except for the
+// first record of a thread, which registers its buffers. Reading sums the
+// buckets of all threads and may run at the same time as recording
+class RequestStatistics {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    RequestStatistics();
+    RequestStatistics(const RequestStatistics&) = delete;
+    RequestStatistics& operator=(const RequestStatistics&) = delete;
+    ~RequestStatistics();
+
+    void Record(Clock::time_point time, bool is_empty, Clock::duration latency);
+    RequestWindowStats GetStats(StatisticsWindow window, Clock::time_point now = Clock::now()) const;
+
+private:
+    static constexpr size_t WINDOW_COUNT = 3;
+
+    struct WindowLayout {
+        Clock::duration bucket_length;
+        size_t bucket_count;
+    };
+
+    static constexpr std::array<WindowLayout, WINDOW_COUNT> WINDOW_LAYOUTS{{
+        {std::chrono::seconds(1), 60},
+        {std::chrono::minutes(1), 60},
+        {std::chrono::hours(1), 24},
+    }};
+
+    // Written by one thread only. The period is the bucket's time divided by
+    // the bucket length; it is set to EMPTY_PERIOD while the bucket is reset
+    struct Bucket {
+        std::atomic<int64_t> period{EMPTY_PERIOD};
+        std::atomic<uint64_t> request_count{0};
+        std::atomic<uint64_t> no_result_count{0};
+        std::array<std::atomic<uint64_t>, RequestWindowStats::LATENCY_BUCKET_COUNT> latency_histogram{};
+    };
+
+    struct ThreadBuckets {
+        ThreadBuckets();
+
+        std::array<std::vector<Bucket>, WINDOW_COUNT> windows;
+        ThreadBuckets* next = nullptr;
+    };
+
+    static constexpr int64_t EMPTY_PERIOD = -1;
+
+    // Tells the instances apart in the per-thread registry, unlike addresses,
+    // which may be reused
+    const uint64_t id_;
+    std::atomic<ThreadBuckets*> thread_buckets_{nullptr};
+
+    ThreadBuckets& GetThreadBuckets();
+    static size_t GetLatencyBucket(Clock::duration latency);
+};
@@ -0,0 +1,11 @@
+#include "scoring_policy.h"
+#include <cmath>
+
+TfIdfScoring::WordScorer::WordScorer(const ScoringStatistics& statistics, int document_freq)
+    : inverse_document_freq_(document_freq == 0 ? 0.0 : std::log(statistics.document_count * 1.0 / document_freq)) {}
+
+Bm25Scoring::WordScorer::WordScorer(const ScoringStatistics& statistics, int document_freq)
+    : weight_(document_freq == 0 ? 0.0 : std::log(1.0 + (statistics.document_count - document_freq + 0.5) / (document_freq + 0.5)) * (K1 + 1.0))
+    , length_norm_base_(K1 * (1.0 - B))
+    , length_norm_factor_(statistics.average_document_length > 0.0 ? K1 * B / statistics.average_document_length : 0.0)
+    , document_lengths_(statistics.document_lengths) {}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+
+// Number of words of a document without its stop words. Clamped to the largest
+// value of the type, so that a length takes two bytes per document
+using DocumentLength = uint16_t;
+
+// What a scoring policy may know of the collection when a query starts
+struct ScoringStatistics {
+    int document_count = 0;
+    double average_document_length = 0.0;
+    // Indexed by document ordinal
+    const DocumentLength* document_lengths = nullptr;
+};
+
+// A scoring policy is a type with a nested WordScorer, which BasicSearchServer makes once
+// per query word and calls for every posting of the word. Its constants are computed
+// by the constructor, so that scoring a posting takes a few arithmetic operations:
+//
+//     WordScorer(const ScoringStatistics& statistics, int document_freq);
+//     // term_freq is the share of the words of the document that are this word
+//     double Score(uint32_t document_ordinal, double term_freq) const;
+//     // At least the score of any document whose term_freq is at most max_term_freq
+//     double GetMaxScore(double max_term_freq) const;
+//
+// A word with document_freq zero must score zero. The relevance of a document is the
+// sum of the scores of the query words found in it. USES_DOCUMENT_LENGTHS tells whether
+// Score reads the document lengths
+
+// Term frequency times the logarithm of the inverse document frequency
+struct TfIdfScoring {
+    static constexpr bool USES_DOCUMENT_LENGTHS = false;
+
+    class WordScorer {
+    public:
+        WordScorer(const ScoringStatistics& statistics, int document_freq);
+
+        double Score(uint32_t document_ordinal, double term_freq) const;
+        double GetMaxScore(double max_term_freq) const;
+
+    private:
+        double inverse_document_freq_;
+    };
+};
+
+// Okapi BM25: repeated words add less and less, and documents longer than
+// the average are penalized. Needs the lengths of the documents
+struct Bm25Scoring {
+    static constexpr bool USES_DOCUMENT_LENGTHS = true;
+    // Saturation of term frequency
+    static constexpr double K1 = 1.2;
+    // Strength of document length normalization, from 0 (none) to 1
+    static constexpr double B = 0.75;
+
+    class WordScorer {
+    public:
+        WordScorer(const ScoringStatistics& statistics, int document_freq);
+
+        double Score(uint32_t document_ordinal, double term_freq) const;
+        double GetMaxScore(double max_term_freq) const;
+
+    private:
+        // The inverse document frequency times K1 + 1
+        double weight_;
+        // K1 * (1 - B + B * length / average length) is split into a constant and a factor of the length
+        double length_norm_base_;
+        double length_norm_factor_;
+        const DocumentLength* document_lengths_;
+    };
+};
+
+inline double TfIdfScoring::WordScorer::Score(uint32_t document_ordinal, double term_freq) const {
+    (void)document_ordinal;
+    return term_freq * inverse_document_freq_;
+}
+
+inline double TfIdfScoring::WordScorer::GetMaxScore(double max_term_freq) const {
+    return max_term_freq * inverse_document_freq_;
+}
+
+inline double Bm25Scoring::WordScorer::Score(uint32_t document_ordinal, double term_freq) const {
+    const double length = document_lengths_[document_ordinal];
+    const double word_count = term_freq * length;
+    return weight_ * word_count / (word_count + length_norm_base_ + length_norm_factor_ * length);
+}
+
+inline double Bm25Scoring::WordScorer::GetMaxScore(double max_term_freq) const {
+    // The score of a term frequency grows with the length of the document,
+    // and approaches this value for very long documents
+    return weight_ * max_term_freq / (max_term_freq + length_norm_factor_);
+}
@@ -0,0 +1,97 @@
+#include "search_cursor.h"
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std::literals;
+
+namespace {
+
+const std::string_view END_CURSOR_TEXT = "end"sv;
+
+// Parses the number up to the separator or the end of the text and removes both from it
+template <typename Number>
+Number ReadNumber(std::string_view& text, int base) {
+    const size_t separator = text.find(':');
+    const std::string_view number_text = text.substr(0, separator);
+    Number number{};
+    const auto [end, error] = std::from_chars(number_text.data(), number_text.data() + number_text.size(), number, base);
+    if (number_text.empty() || error != std::errc() || end != number_text.data() + number_text.size()) {
+        throw std::invalid_argument("Invalid search cursor"s);
+    }
+    text.remove_prefix(separator == std::string_view::npos ? text.size() : separator + 1);
+    return number;
+}
+
+}  // namespace
+
+bool SearchCursor::IsEnd() const {
+    return position_ == Position::END;
+}
+
+std::string SearchCursor::ToString() const {
+    switch (position_) {
+    case Position::START:
+        return {};
+    case Position::END:
+        return std::string(END_CURSOR_TEXT);
+    default:
+        break;
+    }
+    // The bits of the relevance, so that it is read back exactly
+    uint64_t relevance_bits;
+    std::memcpy(&relevance_bits, &last_document_.relevance, sizeof(relevance_bits));
+    char relevance_text[16];
+    char* relevance_end = std::to_chars(relevance_text, relevance_text + sizeof(relevance_text), relevance_bits, 16).ptr;
+    return std::string(relevance_text, relevance_end) + ':' + std::to_string(last_document_.rating) + ':'
+        + std::to_string(last_document_.id);
+}
+
+SearchCursor SearchCursor::FromString(std::string_view text) {
+    if (text.empty()) {
+        return {};
+    }
+    if (text == END_CURSOR_TEXT) {
+        return MakeEnd();
+    }
+    const auto relevance_bits = ReadNumber<uint64_t>(text, 16);
+    Document last_document;
+    std::memcpy(&last_document.relevance, &relevance_bits, sizeof(relevance_bits));
+    last_document.rating = ReadNumber<int>(text, 10);
+    if (text.find(':') != std::string_view::npos) {
+        throw std::invalid_argument("Invalid search cursor"s);
+    }
+    last_document.id = ReadNumber<int>(text, 10);
+    return MakeAfter(last_document);
+}
+
+bool SearchCursor::operator==(const SearchCursor& other) const {
+    if (position_ != other.position_) {
+        return false;
+    }
+    return position_ != Position::AFTER_DOCUMENT
+        || (last_document_.id == other.last_document_.id && last_document_.rating == other.last_document_.rating
+            && last_document_.relevance == other.last_document_.relevance);
+}
+
+bool SearchCursor::operator!=(const SearchCursor& other) const {
+    return !(*this == other);
+}
+
+SearchCursor SearchCursor::MakeAfter(const Document& last_document) {
+    SearchCursor cursor;
+    cursor.position_ = Position::AFTER_DOCUMENT;
+    cursor.last_document_ = last_document;
+    return cursor;
+}
+
+SearchCursor SearchCursor::MakeEnd() {
+    SearchCursor cursor;
+    cursor.position_ = Position::END;
+    return cursor;
+}
+
+const Document* SearchCursor::GetLastDocument() const {
+    return position_ == Position::AFTER_DOCUMENT ? &last_document_ : nullptr;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "document.h"
+
+// Marks where a page of search results ended. It holds the relevance, rating and id
+// of the last document of the page: the next page starts with the documents ranked
+// below it (search-after), so it stays correct while documents are added or removed.
+// A default-constructed cursor starts at the first result
+class SearchCursor {
+public:
+    SearchCursor() = default;
+
+    // True after the last page: a page shorter than requested
+    bool IsEnd() const;
+
+    // A string for clients to pass back, which FromString turns into the same cursor
+    std::string ToString() const;
+    // Throws std::invalid_argument if the text was not made by ToString
+    static SearchCursor FromString(std::string_view text);
+
+    bool operator==(const SearchCursor& other) const;
+    bool operator!=(const SearchCursor& other) const;
+
+private:
+    template <typename ScoringPolicy>
+    friend class BasicSearchServer;
+
+    enum class Position {
+        START,
+        AFTER_DOCUMENT,
+        END,
+    };
+
+    Position position_ = Position::START;
+    Document last_document_;
+
+    static SearchCursor MakeAfter(const Document& last_document);
+    static SearchCursor MakeEnd();
+    // nullptr unless the cursor follows a document
+    const Document* GetLastDocument() const;
+};
+
+struct DocumentPage {
+    // Best first
+    std::vector<Document> documents;
+    SearchCursor next_cursor;
+};
@@ -3,95 +3,668 @@
 #include <stdexcept>
 #include <algorithm>
 #include <string>
+#include <numeric>
+#include <unordered_map>
 
 using namespace std::literals;
 
-SearchServer::SearchServer(const std::string& stop_words_text)
-    : SearchServer(SplitIntoWords(stop_words_text)) {}
+template <typename ScoringPolicy>
+BasicSearchServer<ScoringPolicy>::BasicSearchServer(const std::string& stop_words_text)
+    : BasicSearchServer(std::string_view(stop_words_text)) {}
 
-void SearchServer::AddDocument(int document_id, const std::string& document, DocumentStatus status, const std::vector<int>& ratings) {
+template <typename ScoringPolicy>
+BasicSearchServer<ScoringPolicy>::BasicSearchServer(std::string_view stop_words_text)
+    : BasicSearchServer(SplitIntoWords(stop_words_text)) {}
+
+template <typename ScoringPolicy>
+void BasicSearchServer<ScoringPolicy>::AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings) {
     if ((document_id < 0) || (documents_.count(document_id) > 0)) {
         throw std::invalid_argument("Invalid document_id"s);
     }
-    const auto words = SplitIntoWordsNoStop(document);
+    std::vector<std::string_view> words;
+    std::vector<uint32_t> word_positions;
+    SplitIntoWordsNoStop(document, words, positions_ ? &word_positions : nullptr);
 
     const double inv_word_count = 1.0 / words.size();
-    for (const std::string& word : words) {
-        word_to_document_freqs_[word][document_id] += inv_word_count;
+    std::map<TermId, double> term_freqs;
+    std::vector<std::pair<TermId, uint32_t>> term_positions;
+    for (size_t i = 0; i < words.size(); ++i) {
+        const TermId term_id = terms_.Intern(words[i]);
+        term_freqs[term_id] += inv_word_count;
+        if (positions_) {
+            term_positions.emplace_back(term_id, word_positions[i]);
+        }
+    }
+    postings_.resize(terms_.GetSize());
+    const auto document_ordinal = static_cast<uint32_t>(ordinal_to_document_id_.size());
+    if (positions_) {
+        std::sort(term_positions.begin(), term_positions.end());
+        positions_->AddDocument(document_ordinal, term_positions);
+    }
+    auto& word_freqs = document_to_word_freqs_[document_id];
+    for (const auto& [term_id, term_freq] : term_freqs) {
+        postings_[term_id].PushBack({document_ordinal, term_freq});
+        word_freqs.emplace(terms_.GetTerm(term_id), term_freq);
     }
-    documents_.emplace(document_id, DocumentData{ComputeAverageRating(ratings), status});
+    const int rating = ComputeAverageRating(ratings);
+    documents_.emplace(document_id, DocumentData{rating, status, document_ordinal});
+    status_documents_[static_cast<size_t>(status)].Add(document_ordinal);
+    ordinal_ratings_.push_back(rating);
+    ordinal_statuses_.push_back(status);
+    const DocumentLength length = ToDocumentLength(words.size());
+    ordinal_lengths_.push_back(length);
+    document_length_sum_ += length;
     document_ids_.push_back(document_id);
+    MergeDocumentIds(document_ids_.size() - 1);
+    ordinal_to_document_id_.Mutable().push_back(document_id);
+    if (query_cache_) {
+        query_cache_->Invalidate();
+    }
 }
 
-std::vector<Document> SearchServer::FindTopDocuments(const std::string& raw_query, DocumentStatus status) const {
-    return FindTopDocuments(
-        raw_query, [status](int document_id, DocumentStatus document_status, int rating) {
-            (void)document_id;
-            (void)rating;
-            return document_status == status;
+template <typename ScoringPolicy>
+void BasicSearchServer<ScoringPolicy>::AddDocumentBatch(const std::vector<const DocumentInput*>& documents) {
+    std::set<int> new_ids;
+    for (const DocumentInput* document : documents) {
+        if (document->id < 0 || documents_.count(document->id) > 0 || !new_ids.insert(document->id).second) {
+            throw std::invalid_argument("Invalid document_id"s);
+        }
+    }
+
+    std::vector<size_t> group_begins;
+    for (size_t begin = 0; begin < documents.size(); begin += ADD_DOCUMENTS_GROUP_SIZE) {
+        group_begins.push_back(begin);
+    }
+    std::vector<PartialIndex> partial_indexes(group_begins.size());
+    std::transform(std::execution::par, group_begins.begin(), group_begins.end(), partial_indexes.begin(),
+        [&](size_t begin) {
+            return BuildPartialIndex(documents, begin, std::min(begin + ADD_DOCUMENTS_GROUP_SIZE, documents.size()));
         });
+    // Rethrown in document order, so that the first invalid document is reported
+    for (const PartialIndex& partial_index : partial_indexes) {
+        if (partial_index.error) {
+            std::rethrow_exception(partial_index.error);
+        }
+    }
+
+    // The dictionary is not shared between threads: each group interns its distinct words
+    for (PartialIndex& partial_index : partial_indexes) {
+        partial_index.term_ids.reserve(partial_index.words.size());
+        for (const std::string_view word : partial_index.words) {
+            partial_index.term_ids.push_back(terms_.Intern(word));
+        }
+    }
+    postings_.resize(terms_.GetSize());
+
+    const auto first_ordinal = static_cast<uint32_t>(ordinal_to_document_id_.size());
+    const size_t first_new_id = document_ids_.size();
+    std::vector<int>& ordinal_to_document_id = ordinal_to_document_id_.Mutable();
+    std::vector<std::map<std::string_view, double>*> document_word_freqs;
+    document_word_freqs.reserve(documents.size());
+    for (size_t i = 0; i < documents.size(); ++i) {
+        const DocumentInput& document = *documents[i];
+        const auto document_ordinal = static_cast<uint32_t>(first_ordinal + i);
+        const int rating = ComputeAverageRating(document.ratings);
+        documents_.emplace(document.id, DocumentData{rating, document.status, document_ordinal});
+        status_documents_[static_cast<size_t>(document.status)].Add(document_ordinal);
+        ordinal_ratings_.push_back(rating);
+        ordinal_statuses_.push_back(document.status);
+        document_ids_.push_back(document.id);
+        ordinal_to_document_id.push_back(document.id);
+        document_word_freqs.push_back(&document_to_word_freqs_[document.id]);
+    }
+    MergeDocumentIds(first_new_id);
+    for (const PartialIndex& partial_index : partial_indexes) {
+        for (const DocumentLength length : partial_index.document_lengths) {
+            ordinal_lengths_.push_back(length);
+            document_length_sum_ += length;
+        }
+    }
+
+    // Each group fills the forward index of its documents and translates their
+    // positions to term ids; the words are grouped by stripe for the posting lists
+    std::for_each(std::execution::par, partial_indexes.begin(), partial_indexes.end(), [&](PartialIndex& partial_index) {
+        const size_t document_count = partial_index.document_term_ends.size();
+        size_t term_index = 0;
+        size_t position_index = 0;
+        for (size_t i = 0; i < document_count; ++i) {
+            auto& word_freqs = *document_word_freqs[partial_index.first_document + i];
+            for (; term_index < partial_index.document_term_ends[i]; ++term_index) {
+                const auto& [word_id, term_freq] = partial_index.document_terms[term_index];
+                word_freqs.emplace(terms_.GetTerm(partial_index.term_ids[word_id]), term_freq);
+            }
+            const size_t positions_begin = position_index;
+            for (; position_index < partial_index.document_position_ends[i]; ++position_index) {
+                auto& term_position = partial_index.document_positions[position_index];
+                term_position.first = partial_index.term_ids[term_position.first];
+            }
+            std::sort(partial_index.document_positions.begin() + positions_begin, partial_index.document_positions.begin() + position_index);
+        }
+
+        partial_index.stripe_word_begins.assign(POSTING_STRIPE_COUNT + 1, 0);
+        for (const TermId term_id : partial_index.term_ids) {
+            ++partial_index.stripe_word_begins[term_id % POSTING_STRIPE_COUNT + 1];
+        }
+        std::partial_sum(partial_index.stripe_word_begins.begin(), partial_index.stripe_word_begins.end(), partial_index.stripe_word_begins.begin());
+        std::vector<size_t> stripe_ends(partial_index.stripe_word_begins.begin(), partial_index.stripe_word_begins.end() - 1);
+        partial_index.stripe_words.resize(partial_index.words.size());
+        for (uint32_t word_id = 0; word_id < partial_index.words.size(); ++word_id) {
+            partial_index.stripe_words[stripe_ends[partial_index.term_ids[word_id] % POSTING_STRIPE_COUNT]++] = word_id;
+        }
+    });
+
+    // A stripe walks the groups in order, so every posting list is appended in ordinal order
+    std::vector<TermId> stripes(POSTING_STRIPE_COUNT);
+    std::iota(stripes.begin(), stripes.end(), TermId{0});
+    std::for_each(std::execution::par, stripes.begin(), stripes.end(), [&](TermId stripe) {
+        for (const PartialIndex& partial_index : partial_indexes) {
+            const auto group_ordinal = static_cast<uint32_t>(first_ordinal + partial_index.first_document);
+            for (size_t i = partial_index.stripe_word_begins[stripe]; i < partial_index.stripe_word_begins[stripe + 1]; ++i) {
+                const uint32_t word_id = partial_index.stripe_words[i];
+                PostingList& postings = postings_[partial_index.term_ids[word_id]];
+                for (size_t j = partial_index.word_posting_begins[word_id]; j < partial_index.word_posting_begins[word_id + 1]; ++j) {
+                    const auto& [document_index, term_freq] = partial_index.word_postings[j];
+                    postings.PushBack({group_ordinal + document_index, term_freq});
+                }
+            }
+        }
+    });
+
+    if (positions_) {
+        std::vector<std::pair<TermId, uint32_t>> term_positions;
+        for (const PartialIndex& partial_index : partial_indexes) {
+            size_t position_index = 0;
+            for (size_t i = 0; i < partial_index.document_position_ends.size(); ++i) {
+                term_positions.assign(partial_index.document_positions.begin() + position_index,
+                                      partial_index.document_positions.begin() + partial_index.document_position_ends[i]);
+                position_index = partial_index.document_position_ends[i];
+                positions_->AddDocument(static_cast<uint32_t>(first_ordinal + partial_index.first_document + i), term_positions);
+            }
+        }
+    }
+    if (query_cache_) {
+        query_cache_->Invalidate();
+    }
 }
 
-std::vector<Document> SearchServer::FindTopDocuments(const std::string& raw_query) const {
-    return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
+template <typename ScoringPolicy>
+typename BasicSearchServer<ScoringPolicy>::PartialIndex BasicSearchServer<ScoringPolicy>::BuildPartialIndex(
+    const std::vector<const DocumentInput*>& documents, size_t begin, size_t end) const {
+    PartialIndex partial_index;
+    partial_index.first_document = begin;
+    std::unordered_map<std::string_view, uint32_t> word_ids;
+    // Indexed by word id; the frequencies of the current document are summed the way
+    // AddDocument sums them, and reset once it is done
+    std::vector<double> term_freqs;
+    std::vector<uint32_t> document_word_ids;
+    std::vector<std::string_view> words;
+    std::vector<uint32_t> word_positions;
+    try {
+        for (size_t i = begin; i < end; ++i) {
+            SplitIntoWordsNoStop(documents[i]->text, words, positions_ ? &word_positions : nullptr);
+            const double inv_word_count = 1.0 / words.size();
+            for (size_t j = 0; j < words.size(); ++j) {
+                const auto [it, inserted] = word_ids.emplace(words[j], static_cast<uint32_t>(partial_index.words.size()));
+                if (inserted) {
+                    partial_index.words.push_back(words[j]);
+                    term_freqs.push_back(0.0);
+                }
+                const uint32_t word_id = it->second;
+                if (term_freqs[word_id] == 0.0) {
+                    document_word_ids.push_back(word_id);
+                }
+                term_freqs[word_id] += inv_word_count;
+                if (positions_) {
+                    partial_index.document_positions.emplace_back(word_id, word_positions[j]);
+                }
+            }
+            for (const uint32_t word_id : document_word_ids) {
+                partial_index.document_terms.emplace_back(word_id, term_freqs[word_id]);
+                term_freqs[word_id] = 0.0;
+            }
+            document_word_ids.clear();
+            partial_index.document_term_ends.push_back(partial_index.document_terms.size());
+            partial_index.document_position_ends.push_back(partial_index.document_positions.size());
+            partial_index.document_lengths.push_back(ToDocumentLength(words.size()));
+        }
+    } catch (...) {
+        // An exception thrown inside a parallel algorithm terminates the program
+        partial_index.error = std::current_exception();
+        return partial_index;
+    }
+
+    partial_index.word_posting_begins.assign(partial_index.words.size() + 1, 0);
+    for (const auto& [word_id, _] : partial_index.document_terms) {
+        ++partial_index.word_posting_begins[word_id + 1];
+    }
+    std::partial_sum(partial_index.word_posting_begins.begin(), partial_index.word_posting_begins.end(), partial_index.word_posting_begins.begin());
+    std::vector<size_t> word_ends(partial_index.word_posting_begins.begin(), partial_index.word_posting_begins.end() - 1);
+    partial_index.word_postings.resize(partial_index.document_terms.size());
+    size_t term_index = 0;
+    for (uint32_t document_index = 0; document_index < partial_index.document_term_ends.size(); ++document_index) {
+        for (; term_index < partial_index.document_term_ends[document_index]; ++term_index) {
+            const auto& [word_id, term_freq] = partial_index.document_terms[term_index];
+            partial_index.word_postings[word_ends[word_id]++] = {document_index, term_freq};
+        }
+    }
+    return partial_index;
 }
 
-int SearchServer::GetDocumentCount() const {
-    return documents_.size();
+template <typename ScoringPolicy>
+void BasicSearchServer<ScoringPolicy>::EnablePositions() {
+    if (!documents_.empty()) {
+        throw std::logic_error("Positions can only be enabled before documents are added"s);
+    }
+    if (!positions_) {
+        positions_ = std::make_unique<PositionIndex>();
+    }
 }
 
-int SearchServer::GetDocumentId(int index) const {
-    return document_ids_.at(index);
+template <typename ScoringPolicy>
+size_t BasicSearchServer<ScoringPolicy>::GetPositionMemoryUsage() const {
+    return positions_ ? positions_->GetMemoryUsage() : 0;
 }
 
-std::tuple<std::vector<std::string>, DocumentStatus> SearchServer::MatchDocument(const std::string& raw_query, int document_id) const {
-    const auto query = ParseQuery(raw_query);
+template <typename ScoringPolicy>
+void BasicSearchServer<ScoringPolicy>::AddDocumentsFrom(const BasicSearchServer& other, const std::set<int>& excluded_ids) {
+    if (stop_words_ != other.stop_words_) {
+        throw std::invalid_argument("Stop words of the servers differ"s);
+    }
+    if (positions_ && !other.positions_) {
+        throw std::invalid_argument("The other server does not keep positions"s);
+    }
+    for (const auto& [document_id, _] : other.documents_) {
+        if (documents_.count(document_id) > 0 && excluded_ids.count(document_id) == 0) {
+            throw std::invalid_argument("Invalid document_id"s);
+        }
+    }
 
-    std::vector<std::string> matched_words;
-    for (const std::string& word : query.plus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
+    // Documents keep their relative order, so every posting list is appended in order
+    const size_t first_new_id = document_ids_.size();
+    std::vector<uint32_t> new_ordinals(other.ordinal_to_document_id_.size(), END_DOCUMENT_ORDINAL);
+    for (uint32_t other_ordinal = 0; other_ordinal < new_ordinals.size(); ++other_ordinal) {
+        const int document_id = other.ordinal_to_document_id_[other_ordinal];
+        const auto document = other.documents_.find(document_id);
+        if (document == other.documents_.end() || document->second.ordinal != other_ordinal || excluded_ids.count(document_id) > 0) {
             continue;
         }
-        if (word_to_document_freqs_.at(word).count(document_id)) {
-            matched_words.push_back(word);
+        const auto document_ordinal = static_cast<uint32_t>(ordinal_to_document_id_.size());
+        new_ordinals[other_ordinal] = document_ordinal;
+        documents_.emplace(document_id, DocumentData{document->second.rating, document->second.status, document_ordinal});
+        status_documents_[static_cast<size_t>(document->second.status)].Add(document_ordinal);
+        ordinal_ratings_.push_back(document->second.rating);
+        ordinal_statuses_.push_back(document->second.status);
+        ordinal_lengths_.push_back(other.ordinal_lengths_[other_ordinal]);
+        document_length_sum_ += other.ordinal_lengths_[other_ordinal];
+        document_to_word_freqs_.try_emplace(document_id);
+        document_ids_.push_back(document_id);
+        ordinal_to_document_id_.Mutable().push_back(document_id);
+    }
+    MergeDocumentIds(first_new_id);
+    std::vector<TermId> new_term_ids(other.postings_.size());
+    for (TermId other_term_id = 0; other_term_id < other.postings_.size(); ++other_term_id) {
+        const TermId term_id = terms_.Intern(other.terms_.GetTerm(other_term_id));
+        new_term_ids[other_term_id] = term_id;
+        postings_.resize(terms_.GetSize());
+        const std::string_view word = terms_.GetTerm(term_id);
+        PostingList& postings = postings_[term_id];
+        other.postings_[other_term_id].ForEach([&](const Posting& posting) {
+            const uint32_t document_ordinal = new_ordinals[posting.document_ordinal];
+            if (document_ordinal != END_DOCUMENT_ORDINAL) {
+                postings.PushBack({document_ordinal, posting.term_freq});
+                document_to_word_freqs_[ordinal_to_document_id_[document_ordinal]].emplace(word, posting.term_freq);
+            }
+        });
+    }
+    if (positions_) {
+        std::vector<std::pair<TermId, uint32_t>> term_positions;
+        for (uint32_t other_ordinal = 0; other_ordinal < new_ordinals.size(); ++other_ordinal) {
+            if (new_ordinals[other_ordinal] == END_DOCUMENT_ORDINAL) {
+                continue;
+            }
+            term_positions.clear();
+            other.positions_->ForEachTerm(other_ordinal, [&](TermId other_term_id, const std::vector<uint32_t>& positions) {
+                for (const uint32_t position : positions) {
+                    term_positions.emplace_back(new_term_ids[other_term_id], position);
+                }
+            });
+            // Term ids of this server may be ordered differently
+            std::sort(term_positions.begin(), term_positions.end());
+            positions_->AddDocument(new_ordinals[other_ordinal], term_positions);
         }
     }
-    for (const std::string& word : query.minus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
+    if (query_cache_) {
+        query_cache_->Invalidate();
+    }
+}
+
+template <typename ScoringPolicy>
+void BasicSearchServer<ScoringPolicy>::RemoveDocument(int document_id) {
+    RemoveDocument(std::execution::seq, document_id);
+}
+
+template <typename ScoringPolicy>
+std::vector<Document> BasicSearchServer<ScoringPolicy>::FindTopDocuments(std::string_view raw_query, DocumentStatus status) const {
+    return FindTopDocuments(std::execution::seq, raw_query, status);
+}
+
+template <typename ScoringPolicy>
+std::vector<Document> BasicSearchServer<ScoringPolicy>::FindTopDocuments(std::string_view raw_query) const {
+    return FindTopDocuments(std::execution::seq, raw_query);
+}
+
+template <typename ScoringPolicy>
+DocumentPage BasicSearchServer<ScoringPolicy>::FindDocumentsPage(std::string_view raw_query, const SearchCursor& cursor, size_t page_size, DocumentStatus status) const {
+    return FindDocumentsPage(raw_query, cursor, page_size, StatusPredicate{status});
+}
+
+template <typename ScoringPolicy>
+DocumentPage BasicSearchServer<ScoringPolicy>::FindDocumentsPage(std::string_view raw_query, const SearchCursor& cursor, size_t page_size) const {
+    return FindDocumentsPage(raw_query, cursor, page_size, DocumentStatus::ACTUAL);
+}
+
+template <typename ScoringPolicy>
+QueryStatistics BasicSearchServer<ScoringPolicy>::GetQueryStatistics(std::string_view raw_query) const {
+    return GetQueryStatistics(raw_query, {});
+}
+
+template <typename ScoringPolicy>
+QueryStatistics BasicSearchServer<ScoringPolicy>::GetQueryStatistics(std::string_view raw_query, const std::set<int>& excluded_ids) const {
+    auto query = ParseQuery(raw_query);
+    ExpandWords(query);
+    std::vector<uint32_t> excluded_ordinals;
+    for (const int document_id : excluded_ids) {
+        if (const auto document = documents_.find(document_id); document != documents_.end()) {
+            excluded_ordinals.push_back(document->second.ordinal);
+        }
+    }
+
+    QueryStatistics statistics;
+    statistics.document_count = GetDocumentCount() - static_cast<int>(excluded_ordinals.size());
+    statistics.document_length_sum = document_length_sum_;
+    for (const uint32_t document_ordinal : excluded_ordinals) {
+        statistics.document_length_sum -= ordinal_lengths_[document_ordinal];
+    }
+    for (const std::string_view word : query.plus_words) {
+        // The list of an expanded word merges the lists it expands to, so it has every excluded document of them
+        const PostingList* postings = FindPostingList(query, word);
+        if (postings == nullptr) {
+            statistics.document_freqs.emplace(word, 0);
             continue;
         }
-        if (word_to_document_freqs_.at(word).count(document_id)) {
-            matched_words.clear();
-            break;
+        const auto excluded_count = std::count_if(excluded_ordinals.begin(), excluded_ordinals.end(), [postings](uint32_t document_ordinal) {
+            return postings->Contains(document_ordinal);
+        });
+        statistics.document_freqs.emplace(word, static_cast<int>(postings->GetSize() - excluded_count));
+    }
+    return statistics;
+}
+
+template <typename ScoringPolicy>
+int BasicSearchServer<ScoringPolicy>::GetDocumentCount() const {
+    return documents_.size();
+}
+
+template <typename ScoringPolicy>
+int BasicSearchServer<ScoringPolicy>::GetDocumentId(int index) const {
+    if (index < 0 || index >= GetDocumentCount()) {
+        throw std::out_of_range("Document index is out of range"s);
+    }
+    return document_ids_[index];
+}
+
+template <typename ScoringPolicy>
+std::vector<int>::const_iterator BasicSearchServer<ScoringPolicy>::begin() const {
+    return document_ids_.begin();
+}
+
+template <typename ScoringPolicy>
+std::vector<int>::const_iterator BasicSearchServer<ScoringPolicy>::end() const {
+    return document_ids_.end();
+}
+
+template <typename ScoringPolicy>
+void BasicSearchServer<ScoringPolicy>::MergeDocumentIds(size_t first_new) {
+    const auto middle = document_ids_.begin() + first_new;
+    std::sort(middle, document_ids_.end());
+    // Ids usually grow, and then the new ones already follow the old
+    if (middle != document_ids_.begin() && middle != document_ids_.end() && *std::prev(middle) > *middle) {
+        std::inplace_merge(document_ids_.begin(), middle, document_ids_.end());
+    }
+}
+
+template <typename ScoringPolicy>
+const std::map<std::string_view, double>& BasicSearchServer<ScoringPolicy>::GetWordFrequencies(int document_id) const {
+    static const std::map<std::string_view, double> empty_word_freqs;
+    CollectSnapshotWordFrequencies();
+    const auto it = document_to_word_freqs_.find(document_id);
+    return it == document_to_word_freqs_.end() ? empty_word_freqs : it->second;
+}
+
+template <typename ScoringPolicy>
+std::tuple<std::vector<std::string>, DocumentStatus> BasicSearchServer<ScoringPolicy>::MatchDocument(std::string_view raw_query, int document_id) const {
+    const auto [matched_words, status] = MatchDocument(std::execution::seq, raw_query, document_id);
+    return {{matched_words.begin(), matched_words.end()}, status};
+}
+
+template <typename ScoringPolicy>
+void BasicSearchServer<ScoringPolicy>::SetQueryCacheCapacity(size_t capacity) {
+    query_cache_ = capacity > 0 ? std::make_unique<QueryCache>(capacity) : nullptr;
+}
+
+template <typename ScoringPolicy>
+QueryCacheStats BasicSearchServer<ScoringPolicy>::GetQueryCacheStats() const {
+    return query_cache_ ? query_cache_->GetStats() : QueryCacheStats{};
+}
+
+template <typename ScoringPolicy>
+void BasicSearchServer<ScoringPolicy>::SaveSnapshot(const std::string& path) const {
+    SnapshotWriter writer(path);
+    writer.Write(SNAPSHOT_MAGIC);
+    writer.Write(SNAPSHOT_VERSION);
+    writer.Write(PostingList::SNAPSHOT_FORMAT);
+
+    std::string stop_words_text;
+    for (const std::string& word : stop_words_) {
+        if (!stop_words_text.empty()) {
+            stop_words_text += ' ';
+        }
+        stop_words_text += word;
+    }
+    writer.WriteArray(stop_words_text.data(), stop_words_text.size());
+
+    terms_.Save(writer);
+    writer.Write(static_cast<uint64_t>(postings_.size()));
+    for (const PostingList& postings : postings_) {
+        postings.Save(writer);
+    }
+
+    writer.WriteArray(ordinal_to_document_id_);
+    auto documents = MakeZeroedArray<SnapshotDocument>(documents_.size());
+    auto document = documents.begin();
+    for (const auto& [document_id, document_data] : documents_) {
+        document->id = document_id;
+        document->data.rating = document_data.rating;
+        document->data.status = document_data.status;
+        document->data.ordinal = document_data.ordinal;
+        ++document;
+    }
+    writer.WriteArray(documents);
+    writer.Write(static_cast<uint32_t>(positions_ ? 1 : 0));
+    if (positions_) {
+        positions_->Save(writer);
+    }
+    writer.WriteArray(ordinal_lengths_);
+    writer.Finish();
+}
+
+template <typename ScoringPolicy>
+BasicSearchServer<ScoringPolicy> BasicSearchServer<ScoringPolicy>::OpenSnapshot(const std::string& path) {
+    auto snapshot = std::make_shared<MappedSnapshot>(path);
+    SnapshotReader reader(snapshot->file.GetData(), snapshot->file.GetSize());
+    const auto magic = reader.Read<uint32_t>();
+    const auto version = reader.Read<uint32_t>();
+    if (magic != SNAPSHOT_MAGIC || version < 1 || version > SNAPSHOT_VERSION) {
+        throw std::invalid_argument("File "s + path + " is not a search server snapshot"s);
+    }
+    if (reader.Read<uint32_t>() != PostingList::SNAPSHOT_FORMAT) {
+        throw std::invalid_argument("Snapshot "s + path + " was saved with another posting list format"s);
+    }
+
+    const auto stop_words_text = reader.ReadArray<char>();
+    BasicSearchServer search_server(std::string_view(stop_words_text.data(), stop_words_text.size()));
+    search_server.terms_ = TermDictionary::Load(reader);
+    const auto posting_list_count = reader.Read<uint64_t>();
+    if (posting_list_count != search_server.terms_.GetSize()) {
+        throw std::invalid_argument("Snapshot "s + path + " is corrupted"s);
+    }
+    search_server.postings_.reserve(posting_list_count);
+    for (uint64_t i = 0; i < posting_list_count; ++i) {
+        search_server.postings_.push_back(PostingList::Load(reader));
+    }
+
+    // Only the document table is copied; it is read in id order, so every insertion is at the end
+    search_server.ordinal_to_document_id_ = reader.ReadArray<int>();
+    for (const PostingList& postings : search_server.postings_) {
+        if (postings.GetOrdinalEnd() > search_server.ordinal_to_document_id_.size()) {
+            throw std::invalid_argument("Snapshot "s + path + " is corrupted"s);
         }
     }
-    return {matched_words, documents_.at(document_id).status};
+    search_server.ordinal_ratings_.resize(search_server.ordinal_to_document_id_.size());
+    search_server.ordinal_statuses_.resize(search_server.ordinal_to_document_id_.size());
+    for (const auto& [document_id, document_data] : reader.ReadArray<SnapshotDocument>()) {
+        const bool ids_ascend = search_server.document_ids_.empty() || search_server.document_ids_.back() < document_id;
+        const bool status_known = static_cast<size_t>(document_data.status) < DOCUMENT_STATUS_COUNT;
+        if (document_data.ordinal >= search_server.ordinal_to_document_id_.size() || !ids_ascend || !status_known) {
+            throw std::invalid_argument("Snapshot "s + path + " is corrupted"s);
+        }
+        search_server.documents_.emplace_hint(search_server.documents_.end(), document_id, document_data);
+        search_server.document_ids_.push_back(document_id);
+        search_server.status_documents_[static_cast<size_t>(document_data.status)].Add(document_data.ordinal);
+        search_server.ordinal_ratings_[document_data.ordinal] = document_data.rating;
+        search_server.ordinal_statuses_[document_data.ordinal] = document_data.status;
+    }
+    // Positions are copied as well: they are variable-length and only read for phrase queries
+    if (version >= 2 && reader.Read<uint32_t>() != 0) {
+        search_server.positions_ = std::make_unique<PositionIndex>(PositionIndex::Load(reader));
+    }
+    if (version >= 3) {
+        const auto lengths = reader.ReadArray<DocumentLength>();
+        if (lengths.size() != search_server.ordinal_to_document_id_.size()) {
+            throw std::invalid_argument("Snapshot "s + path + " is corrupted"s);
+        }
+        search_server.ordinal_lengths_.assign(lengths.begin(), lengths.end());
+    } else if constexpr (ScoringPolicy::USES_DOCUMENT_LENGTHS) {
+        throw std::invalid_argument("Snapshot "s + path + " has no document lengths"s);
+    } else {
+        search_server.ordinal_lengths_.resize(search_server.ordinal_to_document_id_.size());
+    }
+    for (const auto& [_, document_data] : search_server.documents_) {
+        search_server.document_length_sum_ += search_server.ordinal_lengths_[document_data.ordinal];
+    }
+    search_server.snapshot_ = std::move(snapshot);
+    return search_server;
+}
+
+template <typename ScoringPolicy>
+bool BasicSearchServer<ScoringPolicy>::StatusPredicate::operator()(int document_id, DocumentStatus document_status, int rating) const {
+    (void)document_id;
+    (void)rating;
+    return document_status == status;
 }
 
-bool SearchServer::IsStopWord(const std::string& word) const {
+template <typename ScoringPolicy>
+bool BasicSearchServer<ScoringPolicy>::IsStopWord(std::string_view word) const {
     return stop_words_.count(word) > 0;
 }
 
-bool SearchServer::IsValidWord(const std::string& word) {
+template <typename ScoringPolicy>
+bool BasicSearchServer<ScoringPolicy>::IsValidWord(std::string_view word) {
     return std::none_of(word.begin(), word.end(), [](char c) {
         return c >= '\0' && c < ' ';
     });
 }
 
-std::vector<std::string> SearchServer::SplitIntoWordsNoStop(const std::string& text) const {
-    std::vector<std::string> words;
-    for (const std::string& word : SplitIntoWords(text)) {
-        if (!IsValidWord(word)) {
-            throw std::invalid_argument("Word "s + word + " is invalid"s);
+template <typename ScoringPolicy>
+bool BasicSearchServer<ScoringPolicy>::IsPrefix(std::string_view word) {
+    return word.size() > 1 && word.back() == '*';
+}
+
+template <typename ScoringPolicy>
+int BasicSearchServer<ScoringPolicy>::GetFuzzyDistance(std::string_view word) {
+    const size_t tilde = word.rfind('~');
+    if (tilde == std::string_view::npos || tilde == 0 || tilde + 1 == word.size()) {
+        return 0;
+    }
+    int distance = 0;
+    for (const char c : word.substr(tilde + 1)) {
+        if (c < '0' || c > '9') {
+            return 0;
         }
-        if (!IsStopWord(word)) {
-            words.push_back(word);
+        // Larger distances are rejected anyway, so they need not be exact
+        distance = std::min(distance * 10 + (c - '0'), MAX_FUZZY_DISTANCE + 1);
+    }
+    return distance;
+}
+
+template <typename ScoringPolicy>
+bool BasicSearchServer<ScoringPolicy>::IsExpanded(std::string_view word) {
+    return IsPrefix(word) || GetFuzzyDistance(word) > 0;
+}
+
+template <typename ScoringPolicy>
+std::vector<std::string_view> BasicSearchServer<ScoringPolicy>::FindExpandedWords(std::string_view word, const std::map<std::string_view, double>& word_freqs) {
+    std::vector<std::string_view> expanded_words;
+    if (IsPrefix(word)) {
+        const std::string_view prefix = word.substr(0, word.size() - 1);
+        for (auto it = word_freqs.lower_bound(prefix); it != word_freqs.end() && it->first.substr(0, prefix.size()) == prefix; ++it) {
+            expanded_words.push_back(it->first);
+        }
+        return expanded_words;
+    }
+    const LevenshteinAutomaton automaton(word.substr(0, word.rfind('~')), GetFuzzyDistance(word));
+    for (const auto& [document_word, _] : word_freqs) {
+        if (automaton.GetDistance(document_word) <= automaton.GetMaxDistance()) {
+            expanded_words.push_back(document_word);
         }
     }
-    return words;
+    return expanded_words;
 }
 
-int SearchServer::ComputeAverageRating(const std::vector<int>& ratings) {
+template <typename ScoringPolicy>
+void BasicSearchServer<ScoringPolicy>::SplitIntoWordsNoStop(std::string_view text, std::vector<std::string_view>& words, std::vector<uint32_t>* positions) const {
+    words.clear();
+    if (positions != nullptr) {
+        positions->clear();
+    }
+    const size_t control_offset = TokenizeWords(text, words);
+    if (control_offset != std::string_view::npos) {
+        const auto word = std::find_if(words.begin(), words.end(), [&](std::string_view word) {
+            return ContainsOffset(text, word, control_offset);
+        });
+        throw std::invalid_argument("Word "s + std::string(*word) + " is invalid"s);
+    }
+    // Stop words are dropped in place; positions count them
+    size_t word_count = 0;
+    for (uint32_t position = 0; position < words.size(); ++position) {
+        if (!IsStopWord(words[position])) {
+            words[word_count++] = words[position];
+            if (positions != nullptr) {
+                positions->push_back(position);
+            }
+        }
+    }
+    words.resize(word_count);
+}
+
+template <typename ScoringPolicy>
+bool BasicSearchServer<ScoringPolicy>::ContainsOffset(std::string_view text, std::string_view word, size_t offset) {
+    const auto word_begin = static_cast<size_t>(word.data() - text.data());
+    return offset >= word_begin && offset - word_begin < word.size();
+}
+
+template <typename ScoringPolicy>
+int BasicSearchServer<ScoringPolicy>::ComputeAverageRating(const std::vector<int>& ratings) {
     if (ratings.empty()) {
         return 0;
     }
@@ -102,38 +675,392 @@ int SearchServer::ComputeAverageRating(const std::vector<int>& ratings) {
     return rating_sum / static_cast<int>(ratings.size());
 }
 
-SearchServer::QueryWord SearchServer::ParseQueryWord(const std::string& text) const {
+template <typename ScoringPolicy>
+DocumentLength BasicSearchServer<ScoringPolicy>::ToDocumentLength(size_t word_count) {
+    return static_cast<DocumentLength>(std::min<size_t>(word_count, std::numeric_limits<DocumentLength>::max()));
+}
+
+template <typename ScoringPolicy>
+typename BasicSearchServer<ScoringPolicy>::QueryWord BasicSearchServer<ScoringPolicy>::ParseQueryWord(std::string_view text, bool is_valid) const {
     if (text.empty()) {
         throw std::invalid_argument("Query word is empty"s);
     }
-    std::string word = text;
+    std::string_view word = text;
     bool is_minus = false;
     if (word[0] == '-') {
         is_minus = true;
-        word = word.substr(1);
+        word.remove_prefix(1);
+    }
+    if (word.empty() || word[0] == '-' || !is_valid) {
+        throw std::invalid_argument("Query word "s + std::string(text) + " is invalid"s);
     }
-    if (word.empty() || word[0] == '-' || !IsValidWord(word)) {
-        throw std::invalid_argument("Query word "s + text + " is invalid"s);
+    if (GetFuzzyDistance(word) > MAX_FUZZY_DISTANCE) {
+        throw std::invalid_argument("Edit distance of query word "s + std::string(text) + " is too large"s);
     }
 
-    return {word, is_minus, IsStopWord(word)};
+    return {word, is_minus, !IsExpanded(word) && IsStopWord(word)};
 }
 
-SearchServer::Query SearchServer::ParseQuery(const std::string& text) const {
-    SearchServer::Query result;
-    for (const std::string& word : SplitIntoWords(text)) {
-        const auto query_word = ParseQueryWord(word);
+template <typename ScoringPolicy>
+typename BasicSearchServer<ScoringPolicy>::Query BasicSearchServer<ScoringPolicy>::ParseQuery(std::string_view text) const {
+    Query result;
+    std::vector<std::string_view> words;
+    const size_t control_offset = TokenizeWords(text, words);
+    size_t parsed_end = 0;
+    for (const std::string_view word : words) {
+        const auto word_begin = static_cast<size_t>(word.data() - text.data());
+        // Words of a phrase are parsed with it
+        if (word_begin < parsed_end) {
+            continue;
+        }
+        // Without positions quotes are ordinary characters, as they were before phrases
+        if (positions_ && word[0] == '"') {
+            parsed_end = ParsePhrase(text, word_begin, control_offset, result);
+            continue;
+        }
+        if (positions_ && word.substr(0, 2) == "-\""sv) {
+            throw std::invalid_argument("Phrases cannot be minus words"s);
+        }
+        const auto query_word = ParseQueryWord(word, !ContainsOffset(text, word, control_offset));
         if (!query_word.is_stop) {
             if (query_word.is_minus) {
-                result.minus_words.insert(query_word.data);
+                result.minus_words.push_back(query_word.data);
             } else {
-                result.plus_words.insert(query_word.data);
+                result.plus_words.push_back(query_word.data);
             }
         }
     }
+    for (auto* words : {&result.plus_words, &result.minus_words}) {
+        std::sort(words->begin(), words->end());
+        words->erase(std::unique(words->begin(), words->end()), words->end());
+    }
     return result;
 }
 
-double SearchServer::ComputeWordInverseDocumentFreq(const std::string& word) const {
-    return std::log(GetDocumentCount() * 1.0 / word_to_document_freqs_.at(word).size());
-}
\ No newline at end of file
+template <typename ScoringPolicy>
+size_t BasicSearchServer<ScoringPolicy>::ParsePhrase(std::string_view text, size_t begin, size_t control_offset, Query& query) const {
+    const size_t phrase_end = text.find('"', begin + 1);
+    if (phrase_end == std::string_view::npos) {
+        throw std::invalid_argument("Phrase is not closed"s);
+    }
+    const auto words = SplitIntoWords(text.substr(begin + 1, phrase_end - begin - 1));
+    if (words.empty()) {
+        throw std::invalid_argument("Phrase is empty"s);
+    }
+
+    Phrase phrase;
+    uint32_t first_offset = 0;
+    for (uint32_t offset = 0; offset < words.size(); ++offset) {
+        const std::string_view word = words[offset];
+        if (word[0] == '-' || IsExpanded(word) || ContainsOffset(text, word, control_offset)) {
+            throw std::invalid_argument("Phrase word "s + std::string(word) + " is invalid"s);
+        }
+        if (!IsStopWord(word)) {
+            if (phrase.words.empty()) {
+                first_offset = offset;
+            }
+            phrase.words.emplace_back(word, offset - first_offset);
+        }
+    }
+
+    size_t end = phrase_end + 1;
+    if (end < text.size() && text[end] == '~') {
+        const size_t slop_begin = ++end;
+        uint64_t slop = 0;
+        for (; end < text.size() && text[end] >= '0' && text[end] <= '9'; ++end) {
+            slop = std::min<uint64_t>(slop * 10 + (text[end] - '0'), std::numeric_limits<uint32_t>::max());
+        }
+        if (end == slop_begin) {
+            throw std::invalid_argument("Phrase slop is missing"s);
+        }
+        phrase.slop = static_cast<uint32_t>(slop);
+    }
+    if (end < text.size() && text[end] != ' ') {
+        throw std::invalid_argument("Phrase must be followed by a space"s);
+    }
+
+    // A phrase of stop words alone matches nothing in particular
+    if (!phrase.words.empty()) {
+        for (const auto& [word, _] : phrase.words) {
+            query.plus_words.push_back(word);
+        }
+        query.phrases.push_back(std::move(phrase));
+    }
+    return end;
+}
+
+template <typename ScoringPolicy>
+bool BasicSearchServer<ScoringPolicy>::ContainsPhrase(uint32_t document_ordinal, const Phrase& phrase) const {
+    // Positions of the current phrase word that end a match of the words before it
+    std::vector<uint32_t> match_ends;
+    std::vector<uint32_t> positions;
+    std::vector<uint32_t> next_match_ends;
+    for (size_t i = 0; i < phrase.words.size(); ++i) {
+        const auto term_id = terms_.Find(phrase.words[i].first);
+        if (!term_id || !positions_->GetPositions(document_ordinal, *term_id, positions)) {
+            return false;
+        }
+        if (i == 0) {
+            match_ends.swap(positions);
+            continue;
+        }
+
+        // A position continues a match ending from min_gap to max_gap words before it.
+        // Both lists are ascending, so one pass over them finds all such positions
+        const uint64_t min_gap = phrase.words[i].second - phrase.words[i - 1].second;
+        const uint64_t max_gap = min_gap + phrase.slop;
+        next_match_ends.clear();
+        size_t match = 0;
+        for (const uint32_t position : positions) {
+            while (match < match_ends.size() && match_ends[match] + max_gap < position) {
+                ++match;
+            }
+            if (match == match_ends.size()) {
+                break;
+            }
+            if (match_ends[match] + min_gap <= position) {
+                next_match_ends.push_back(position);
+            }
+        }
+        if (next_match_ends.empty()) {
+            return false;
+        }
+        match_ends.swap(next_match_ends);
+    }
+    return true;
+}
+
+template <typename ScoringPolicy>
+bool BasicSearchServer<ScoringPolicy>::ContainsPhrases(uint32_t document_ordinal, const Query& query) const {
+    return std::all_of(query.phrases.begin(), query.phrases.end(), [this, document_ordinal](const Phrase& phrase) {
+        return ContainsPhrase(document_ordinal, phrase);
+    });
+}
+
+template <typename ScoringPolicy>
+std::vector<uint32_t> BasicSearchServer<ScoringPolicy>::FindPhraseDocuments(const Query& query) const {
+    std::vector<const PostingList*> posting_lists;
+    for (const Phrase& phrase : query.phrases) {
+        for (const auto& [word, _] : phrase.words) {
+            const PostingList* postings = FindPostingList(word);
+            if (postings == nullptr) {
+                return {};
+            }
+            posting_lists.push_back(postings);
+        }
+    }
+    // The shortest list leads, and the others skip to its documents
+    std::sort(posting_lists.begin(), posting_lists.end(), [](const PostingList* lhs, const PostingList* rhs) {
+        return lhs->GetSize() < rhs->GetSize();
+    });
+    posting_lists.erase(std::unique(posting_lists.begin(), posting_lists.end()), posting_lists.end());
+    std::vector<PostingList::Cursor> cursors;
+    cursors.reserve(posting_lists.size());
+    for (const PostingList* postings : posting_lists) {
+        cursors.push_back(postings->GetCursor());
+    }
+
+    std::vector<uint32_t> document_ordinals;
+    uint32_t document_ordinal = cursors.front().GetDocumentOrdinal();
+    while (document_ordinal != END_DOCUMENT_ORDINAL) {
+        bool is_in_all = true;
+        for (size_t i = 1; i < cursors.size(); ++i) {
+            cursors[i].SkipTo(document_ordinal);
+            if (cursors[i].GetDocumentOrdinal() != document_ordinal) {
+                is_in_all = false;
+                document_ordinal = cursors[i].GetDocumentOrdinal();
+                break;
+            }
+        }
+        if (is_in_all) {
+            if (ContainsPhrases(document_ordinal, query)) {
+                document_ordinals.push_back(document_ordinal);
+            }
+            cursors.front().Next();
+        } else if (document_ordinal == END_DOCUMENT_ORDINAL) {
+            break;
+        } else {
+            cursors.front().SkipTo(document_ordinal);
+        }
+        document_ordinal = cursors.front().GetDocumentOrdinal();
+    }
+    return document_ordinals;
+}
+
+template <typename ScoringPolicy>
+void BasicSearchServer<ScoringPolicy>::CollectSnapshotWordFrequencies() const {
+    if (!snapshot_) {
+        return;
+    }
+    std::call_once(snapshot_->word_freqs_collected, [this] {
+        for (const auto& [document_id, _] : documents_) {
+            document_to_word_freqs_.try_emplace(document_id);
+        }
+        for (TermId term_id = 0; term_id < postings_.size(); ++term_id) {
+            const std::string_view word = terms_.GetTerm(term_id);
+            postings_[term_id].ForEach([this, word](const Posting& posting) {
+                const int document_id = ordinal_to_document_id_[posting.document_ordinal];
+                document_to_word_freqs_.at(document_id).emplace(word, posting.term_freq);
+            });
+        }
+    });
+}
+
+template <typename ScoringPolicy>
+std::string BasicSearchServer<ScoringPolicy>::MakeQueryCacheKey(const Query& query, DocumentStatus status) {
+    // Words cannot contain spaces, and only minus words start with '-'
+    std::string key = std::to_string(static_cast<int>(status));
+    for (const std::string_view word : query.plus_words) {
+        key += ' ';
+        key += word;
+    }
+    for (const std::string_view word : query.minus_words) {
+        key += " -"s;
+        key += word;
+    }
+    // Words cannot contain control characters, so '\x01' starts a phrase;
+    // then its offsets and words alternate
+    for (const Phrase& phrase : query.phrases) {
+        key += " \x01"s;
+        key += std::to_string(phrase.slop);
+        for (const auto& [word, offset] : phrase.words) {
+            key += ' ';
+            key += std::to_string(offset);
+            key += ' ';
+            key += word;
+        }
+    }
+    return key;
+}
+
+template <typename ScoringPolicy>
+void BasicSearchServer<ScoringPolicy>::ExpandWords(Query& query) const {
+    for (const auto* words : {&query.plus_words, &query.minus_words}) {
+        for (const std::string_view word : *words) {
+            if (!IsExpanded(word) || query.expanded_postings.count(word) > 0) {
+                continue;
+            }
+            // Terms with their edit distances; prefixes match at distance 0
+            std::vector<std::pair<TermId, int>> terms;
+            if (IsPrefix(word)) {
+                for (const TermId term_id : terms_.FindPrefix(word.substr(0, word.size() - 1))) {
+                    terms.emplace_back(term_id, 0);
+                }
+            } else {
+                terms = terms_.FindNear(LevenshteinAutomaton(word.substr(0, word.rfind('~')), GetFuzzyDistance(word)));
+            }
+            terms.erase(std::remove_if(terms.begin(), terms.end(), [this](const std::pair<TermId, int>& term) {
+                            return postings_[term.first].GetSize() == 0;
+                        }),
+                        terms.end());
+            if (terms.size() > MAX_WORD_EXPANSION_COUNT) {
+                std::nth_element(terms.begin(), terms.begin() + MAX_WORD_EXPANSION_COUNT, terms.end(),
+                    [this](const std::pair<TermId, int>& lhs, const std::pair<TermId, int>& rhs) {
+                        if (lhs.second != rhs.second) {
+                            return lhs.second < rhs.second;
+                        }
+                        return postings_[lhs.first].GetSize() > postings_[rhs.first].GetSize();
+                    });
+                terms.resize(MAX_WORD_EXPANSION_COUNT);
+            }
+
+            std::vector<std::pair<const PostingList*, double>> weighted_lists;
+            weighted_lists.reserve(terms.size());
+            for (const auto& [term_id, distance] : terms) {
+                weighted_lists.emplace_back(&postings_[term_id], 1.0 / (1 + distance));
+            }
+            query.expanded_postings.emplace(word, MergePostingLists(weighted_lists));
+        }
+    }
+}
+
+template <typename ScoringPolicy>
+PostingList BasicSearchServer<ScoringPolicy>::MergePostingLists(const std::vector<std::pair<const PostingList*, double>>& weighted_lists) {
+    struct WeightedCursor {
+        PostingList::Cursor cursor;
+        double weight;
+    };
+
+    // A heap of cursors ordered by their current documents, the earliest on top
+    std::vector<WeightedCursor> cursors;
+    cursors.reserve(weighted_lists.size());
+    for (const auto& [postings, weight] : weighted_lists) {
+        cursors.push_back({postings->GetCursor(), weight});
+    }
+    const auto is_later = [](const WeightedCursor& lhs, const WeightedCursor& rhs) {
+        return lhs.cursor.GetDocumentOrdinal() > rhs.cursor.GetDocumentOrdinal();
+    };
+    std::make_heap(cursors.begin(), cursors.end(), is_later);
+
+    PostingList merged_postings;
+    while (!cursors.empty()) {
+        const uint32_t document_ordinal = cursors.front().cursor.GetDocumentOrdinal();
+        double term_freq = 0.0;
+        while (!cursors.empty() && cursors.front().cursor.GetDocumentOrdinal() == document_ordinal) {
+            std::pop_heap(cursors.begin(), cursors.end(), is_later);
+            WeightedCursor& weighted_cursor = cursors.back();
+            term_freq += weighted_cursor.cursor.GetTermFreq() * weighted_cursor.weight;
+            weighted_cursor.cursor.Next();
+            if (weighted_cursor.cursor.GetDocumentOrdinal() == END_DOCUMENT_ORDINAL) {
+                cursors.pop_back();
+            } else {
+                std::push_heap(cursors.begin(), cursors.end(), is_later);
+            }
+        }
+        merged_postings.PushBack({document_ordinal, term_freq});
+    }
+    return merged_postings;
+}
+
+template <typename ScoringPolicy>
+const PostingList* BasicSearchServer<ScoringPolicy>::FindPostingList(const Query& query, std::string_view word) const {
+    if (!IsExpanded(word)) {
+        return FindPostingList(word);
+    }
+    const auto it = query.expanded_postings.find(word);
+    return it == query.expanded_postings.end() || it->second.GetSize() == 0 ? nullptr : &it->second;
+}
+
+template <typename ScoringPolicy>
+DocumentBitmap BasicSearchServer<ScoringPolicy>::CollectMinusDocuments(const Query& query) const {
+    DocumentBitmap documents;
+    for (const std::string_view word : query.minus_words) {
+        if (const PostingList* postings = FindPostingList(query, word)) {
+            postings->ForEach([&documents](const Posting& posting) {
+                documents.Add(posting.document_ordinal);
+            });
+        }
+    }
+    return documents;
+}
+
+template <typename ScoringPolicy>
+const PostingList* BasicSearchServer<ScoringPolicy>::FindPostingList(std::string_view word) const {
+    const auto term_id = terms_.Find(word);
+    if (!term_id || postings_[*term_id].GetSize() == 0) {
+        return nullptr;
+    }
+    return &postings_[*term_id];
+}
+
+template <typename ScoringPolicy>
+typename BasicSearchServer<ScoringPolicy>::WordScorer BasicSearchServer<ScoringPolicy>::MakeWordScorer(
+    std::string_view word, const PostingList& postings, const QueryStatistics* statistics) const {
+    ScoringStatistics scoring_statistics;
+    scoring_statistics.document_count = GetDocumentCount();
+    scoring_statistics.average_document_length = documents_.empty() ? 0.0 : document_length_sum_ * 1.0 / documents_.size();
+    scoring_statistics.document_lengths = ordinal_lengths_.data();
+    if (statistics == nullptr) {
+        return WordScorer(scoring_statistics, static_cast<int>(postings.GetSize()));
+    }
+    scoring_statistics.document_count = statistics->document_count;
+    scoring_statistics.average_document_length = statistics->document_count == 0 ? 0.0
+        : statistics->document_length_sum * 1.0 / statistics->document_count;
+    // A word missing from the statistics has no documents counted in the collection,
+    // so its documents are excluded from the results by the caller anyway
+    const auto it = statistics->document_freqs.find(word);
+    return WordScorer(scoring_statistics, it == statistics->document_freqs.end() ? 0 : it->second);
+}
+
+template class BasicSearchServer<TfIdfScoring>;
+template class BasicSearchServer<Bm25Scoring>;
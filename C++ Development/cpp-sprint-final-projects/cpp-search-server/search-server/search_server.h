@@ -1,129 +1,889 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
+#include <exception>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <set>
 #include <string>
+#include <string_view>
 #include <tuple>
+#include <type_traits>
 #include <vector>
 #include <algorithm>
+#include <execution>
+#include <limits>
 #include "document.h"
+#include "document_bitmap.h"
+#include "mapped_file.h"
+#include "mapped_vector.h"
+#include "position_index.h"
+#include "posting_list.h"
+#include "query_cache.h"
+#include "query_statistics.h"
+#include "relevance_accumulator.h"
+#include "scoring_policy.h"
+#include "search_cursor.h"
 #include "string_processing.h"
+#include "term_dictionary.h"
+#include "top_documents.h"
 
 const int MAX_RESULT_DOCUMENT_COUNT = 5;
+// A prefix or fuzzy query word matching more terms is expanded to the closest of them,
+// then to those with the most documents
+const size_t MAX_WORD_EXPANSION_COUNT = 1000;
+const int MAX_FUZZY_DISTANCE = 2;
 
-class SearchServer {
+// A document for AddDocuments. The text is only read while the document is added
+struct DocumentInput {
+    int id = 0;
+    std::string_view text;
+    DocumentStatus status = DocumentStatus::ACTUAL;
+    std::vector<int> ratings;
+};
+
+// Ranks documents by the relevance that ScoringPolicy gives them (see scoring_policy.h).
+// The policy is a template parameter, so that its scoring is inlined into the search loops.
+// SearchServer ranks with TF-IDF
+template <typename ScoringPolicy>
+class BasicSearchServer {
 public:
     template <typename StringContainer>
-    explicit SearchServer(const StringContainer& stop_words);
+    explicit BasicSearchServer(const StringContainer& stop_words);
+
+    explicit BasicSearchServer(const std::string& stop_words_text);
+    explicit BasicSearchServer(std::string_view stop_words_text);
+
+    // The word frequencies refer to the strings of the term dictionary,
+    // so a copy would point into the index of the original server
+    BasicSearchServer(const BasicSearchServer&) = delete;
+    BasicSearchServer(BasicSearchServer&&) = default;
+
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+
+    // Adds a range of DocumentInput in its order, with the ordinals and relevances that AddDocument
+    // would give them one by one. Groups of documents are tokenized on different threads into
+    // partial indexes, which are then appended to the posting lists, split between threads by term.
+    // Throws std::invalid_argument if an id or a word is invalid; nothing is added then
+    template <typename DocumentRange>
+    void AddDocuments(const DocumentRange& documents);
+
+    // Makes the server keep the positions of words in documents, which phrase queries need:
+    // "a b c" matches documents with these words in this order, one after another, and
+    // "a b c"~N also allows up to N other words in every gap. Stop words keep their places.
+    // Throws std::logic_error if the server already has documents
+    void EnablePositions();
+    // Zero while positions are off
+    size_t GetPositionMemoryUsage() const;
+
+    // Adds the documents of another server with the same stop words, keeping their ratings,
+    // statuses, term frequencies and positions. Throws std::invalid_argument if the stop words
+    // differ, if this server keeps positions and the other does not, or if a document id
+    // is already present; nothing is added then
+    void AddDocumentsFrom(const BasicSearchServer& other, const std::set<int>& excluded_ids = {});
+
+    // Does nothing if there is no document with such id
+    void RemoveDocument(int document_id);
+
+    template <typename ExecutionPolicy>
+    void RemoveDocument(ExecutionPolicy&& policy, int document_id);
+
+    // A query word ending with '*', such as cat*, matches every word starting with the rest of it.
+    // A query word ending with '~' and an edit distance up to MAX_FUZZY_DISTANCE, such as cat~1,
+    // matches every word within that many inserted, deleted or replaced characters of the rest of it;
+    // the term frequency of a word is divided by one plus its distance. Either word is expanded to up
+    // to MAX_WORD_EXPANSION_COUNT words, which count as one query word: their term frequencies
+    // add up, and the inverse document frequency is that of all their documents
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const;
+
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
+
+    template <typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate) const;
 
-    explicit SearchServer(const std::string& stop_words_text);
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentStatus status) const;
 
-    void AddDocument(int document_id, const std::string& document, DocumentStatus status, const std::vector<int>& ratings);
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query) const;
 
+    // For a server holding a part of a collection: ranks its documents with the statistics
+    // of the whole collection, summed from GetQueryStatistics of every part.
+    // The results bypass the query cache
+    template <typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate,
+                                           const QueryStatistics& statistics) const;
+
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentStatus status,
+                                           const QueryStatistics& statistics) const;
+
+    // Returns up to page_size documents ranked right below the cursor, best first, with the cursor
+    // of the next page; documents are ranked as by FindTopDocuments, and the pages follow each other
+    // without gaps or repeats. Only one page of documents is kept while searching, however deep
+    // the page is. The results bypass the query cache. Throws std::invalid_argument if page_size is zero
     template <typename DocumentPredicate>
-    std::vector<Document> FindTopDocuments(const std::string& raw_query, DocumentPredicate document_predicate) const;
+    DocumentPage FindDocumentsPage(std::string_view raw_query, const SearchCursor& cursor, size_t page_size,
+                                   DocumentPredicate document_predicate) const;
+
+    DocumentPage FindDocumentsPage(std::string_view raw_query, const SearchCursor& cursor, size_t page_size, DocumentStatus status) const;
+    DocumentPage FindDocumentsPage(std::string_view raw_query, const SearchCursor& cursor, size_t page_size) const;
 
-    std::vector<Document> FindTopDocuments(const std::string& raw_query, DocumentStatus status) const;
-    std::vector<Document> FindTopDocuments(const std::string& raw_query) const;
+    QueryStatistics GetQueryStatistics(std::string_view raw_query) const;
+    // Leaves out the documents with the excluded ids, as if they were removed.
+    // Prefix and fuzzy words count the excluded documents of every word they expand to
+    QueryStatistics GetQueryStatistics(std::string_view raw_query, const std::set<int>& excluded_ids) const;
 
     int GetDocumentCount() const;
+    // Ids are numbered in ascending order; the lookup takes constant time
     int GetDocumentId(int index) const;
-    std::tuple<std::vector<std::string>, DocumentStatus> MatchDocument(const std::string& raw_query, int document_id) const;
+    std::vector<int>::const_iterator begin() const;
+    std::vector<int>::const_iterator end() const;
+
+    // Returns an empty map if there is no document with such id
+    const std::map<std::string_view, double>& GetWordFrequencies(int document_id) const;
+    std::tuple<std::vector<std::string>, DocumentStatus> MatchDocument(std::string_view raw_query, int document_id) const;
+
+    // Returns the plus words of the query found in the document, sorted and unique,
+    // or none if a minus word is found. A prefix or fuzzy word matches every word of
+    // the document it expands to. The words point into the term dictionary
+    // and stay valid while the server exists. Words are looked up in the forward
+    // index, which for a server opened from a snapshot is collected on the first call
+    template <typename ExecutionPolicy>
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(ExecutionPolicy&& policy, std::string_view raw_query, int document_id) const;
+
+    // Matches one query against many documents, parsing it once; with std::execution::par
+    // the documents are matched in parallel. Throws std::out_of_range if a document is missing
+    template <typename ExecutionPolicy>
+    std::vector<std::tuple<std::vector<std::string_view>, DocumentStatus>> MatchDocuments(
+        ExecutionPolicy&& policy, std::string_view raw_query, const std::vector<int>& document_ids) const;
+
+    // Keeps the results of up to capacity recent queries. Only queries filtered by
+    // status are cached: predicates cannot be told apart. Adding or removing a document
+    // invalidates all cached results. Zero capacity turns the cache off, which is the default
+    void SetQueryCacheCapacity(size_t capacity);
+    // All zeros while the cache is off
+    QueryCacheStats GetQueryCacheStats() const;
+
+    // Writes the index to a file that OpenSnapshot maps. The file is replaced
+    // only once it is written completely
+    void SaveSnapshot(const std::string& path) const;
+    // Maps a file written by SaveSnapshot. Terms and posting lists are read from
+    // the mapping in place, and the pages are shared with other processes that
+    // map the same file. A posting list is copied into memory the first time a
+    // document is added to or removed from it. Throws std::invalid_argument
+    // if the file is not a snapshot of a server built with the same posting lists, or if
+    // the policy needs document lengths and the snapshot is older than version 3, which added them
+    static BasicSearchServer OpenSnapshot(const std::string& path);
 
 private:
+    using TermId = TermDictionary::TermId;
+
+    // Documents are numbered densely in the order they were added;
+    // posting lists refer to documents by this ordinal
     struct DocumentData {
         int rating;
         DocumentStatus status;
+        uint32_t ordinal;
+    };
+
+    struct MappedSnapshot {
+        explicit MappedSnapshot(const std::string& path)
+            : file(path) {}
+
+        MappedFile file;
+        std::once_flag word_freqs_collected;
+    };
+
+    struct SnapshotDocument {
+        int id;
+        DocumentData data;
     };
-    const std::set<std::string> stop_words_;
-    std::map<std::string, std::map<int, double>> word_to_document_freqs_;
+
+    // The predicate of the overloads taking a status. The search recognizes it
+    // and checks the status bitmaps instead of calling it for every document
+    struct StatusPredicate {
+        DocumentStatus status;
+
+        bool operator()(int document_id, DocumentStatus document_status, int rating) const;
+    };
+
+    static constexpr size_t DOCUMENT_STATUS_COUNT = 4;
+
+    static constexpr uint32_t SNAPSHOT_MAGIC = 0x534E5353;  // "SSNS"
+    // Version 2 added the position index and version 3 document lengths; older files are still read
+    static constexpr uint32_t SNAPSHOT_VERSION = 3;
+
+    // Set if the index was opened from a snapshot; the terms and posting lists
+    // may refer to the mapped file, so it is destroyed after them
+    std::shared_ptr<MappedSnapshot> snapshot_;
+    const std::set<std::string, std::less<>> stop_words_;
+    // Posting lists are indexed by the term ids of the dictionary. Each of them
+    // is sorted by document ordinal; ordinals only grow, so adding a document
+    // appends to the end of its lists
+    TermDictionary terms_;
+    std::vector<PostingList> postings_;
     std::map<int, DocumentData> documents_;
+    // Forward index: lets a document be removed by touching only its own posting lists.
+    // It is not stored in snapshots: for the documents of a snapshot it is collected
+    // from the posting lists when first needed
+    mutable std::map<int, std::map<std::string_view, double>> document_to_word_freqs_;
+    // Sorted, so that GetDocumentId indexes it directly
     std::vector<int> document_ids_;
+    // Maps document ordinals to ids; ordinals of removed documents are never reused
+    MappedVector<int> ordinal_to_document_id_;
+    // Ratings and statuses by ordinal, so that the search reads them without looking
+    // documents up by id. Entries of removed documents stay, as their ordinals do
+    std::vector<int> ordinal_ratings_;
+    std::vector<DocumentStatus> ordinal_statuses_;
+    std::vector<DocumentLength> ordinal_lengths_;
+    // Of the documents present
+    uint64_t document_length_sum_ = 0;
+    // Set by EnablePositions
+    std::unique_ptr<PositionIndex> positions_;
+    // Ordinals of the documents with each status, indexed by the status
+    std::array<DocumentBitmap, DOCUMENT_STATUS_COUNT> status_documents_;
+
+    void CollectSnapshotWordFrequencies() const;
+    // Sorts the ids appended to document_ids_ from first_new on and merges them with the rest
+    void MergeDocumentIds(size_t first_new);
+
+    std::unique_ptr<QueryCache> query_cache_;
+
+    // Documents of AddDocuments tokenized by one thread, with their words numbered
+    // in order of first appearance. The words point into the texts of the documents
+    struct PartialIndex {
+        size_t first_document = 0;
+        std::vector<std::string_view> words;
+        // Pairs of word ids and term frequencies; those of the i-th document end at document_term_ends[i]
+        std::vector<std::pair<uint32_t, double>> document_terms;
+        std::vector<size_t> document_term_ends;
+        // Pairs of word ids and positions, while positions are on
+        std::vector<std::pair<uint32_t, uint32_t>> document_positions;
+        std::vector<size_t> document_position_ends;
+        std::vector<DocumentLength> document_lengths;
+        // Pairs of document indexes and term frequencies, grouped by word:
+        // those of word w start at word_posting_begins[w]
+        std::vector<std::pair<uint32_t, double>> word_postings;
+        std::vector<size_t> word_posting_begins;
+        // Filled in while merging: the term id of each word, and the words grouped
+        // by the stripe of their term id, those of stripe s starting at stripe_word_begins[s]
+        std::vector<TermId> term_ids;
+        std::vector<uint32_t> stripe_words;
+        std::vector<size_t> stripe_word_begins;
+        // Set if a document has an invalid word; the rest is then incomplete
+        std::exception_ptr error;
+    };
 
-    bool IsStopWord(const std::string& word) const;
-    static bool IsValidWord(const std::string& word);
-    std::vector<std::string> SplitIntoWordsNoStop(const std::string& text) const;
+    // Documents tokenized by one task of AddDocuments
+    static constexpr size_t ADD_DOCUMENTS_GROUP_SIZE = 256;
+    // Posting lists are appended by this many tasks, each taking the term ids
+    // equal to its number modulo the count, so that frequent terms are spread out
+    static constexpr TermId POSTING_STRIPE_COUNT = 256;
+
+    void AddDocumentBatch(const std::vector<const DocumentInput*>& documents);
+    PartialIndex BuildPartialIndex(const std::vector<const DocumentInput*>& documents, size_t begin, size_t end) const;
+
+    bool IsStopWord(std::string_view word) const;
+    static bool IsValidWord(std::string_view word);
+    // Query words ending with '*' are prefixes; a lone "*" is an ordinary word
+    static bool IsPrefix(std::string_view word);
+    // Returns the edit distance of a fuzzy query word, such as 1 for cat~1, and 0 for other words
+    static int GetFuzzyDistance(std::string_view word);
+    static bool IsExpanded(std::string_view word);
+    // Words of the document that a prefix or fuzzy query word expands to
+    static std::vector<std::string_view> FindExpandedWords(std::string_view word, const std::map<std::string_view, double>& word_freqs);
+    // Replaces the contents of words with the words of the text other than stop words, and those
+    // of positions, if it is given, with their positions. The text is scanned once for both words
+    // and invalid characters, see TokenizeWords. Throws std::invalid_argument if a word is invalid
+    void SplitIntoWordsNoStop(std::string_view text, std::vector<std::string_view>& words, std::vector<uint32_t>* positions = nullptr) const;
+    // Whether the word, which points into the text, holds the byte at the offset;
+    // with the offset of the first control character, tells an invalid word
+    static bool ContainsOffset(std::string_view text, std::string_view word, size_t offset);
     static int ComputeAverageRating(const std::vector<int>& ratings);
+    static DocumentLength ToDocumentLength(size_t word_count);
 
     struct QueryWord {
-        std::string data;
+        std::string_view data;
         bool is_minus;
         bool is_stop;
     };
 
-    QueryWord ParseQueryWord(const std::string& text) const;
+    // The word is checked for control characters by the caller
+    QueryWord ParseQueryWord(std::string_view text, bool is_valid) const;
 
+    // Words of a phrase without its stop words, with their offsets from the first one
+    struct Phrase {
+        std::vector<std::pair<std::string_view, uint32_t>> words;
+        uint32_t slop = 0;
+    };
+
+    // Words point into the raw query text. They are kept sorted and unique
+    // so that they can be split between threads. The words of phrases are
+    // plus words as well. Prefixes and fuzzy words keep their '*' or '~' and distance
     struct Query {
-        std::set<std::string> plus_words;
-        std::set<std::string> minus_words;
+        std::vector<std::string_view> plus_words;
+        std::vector<std::string_view> minus_words;
+        std::vector<Phrase> phrases;
+        // Filled in by ExpandWords: the union of the posting lists of the terms each
+        // prefix or fuzzy word expands to. A map, so that cursors into the lists stay valid
+        std::map<std::string_view, PostingList> expanded_postings;
     };
 
-    Query ParseQuery(const std::string& text) const;
+    Query ParseQuery(std::string_view text) const;
+    // Parses the phrase whose opening quote is at text[begin]; returns the position after it.
+    // control_offset is that of the first control character of the text. Only called while positions are on
+    size_t ParsePhrase(std::string_view text, size_t begin, size_t control_offset, Query& query) const;
+    static std::string MakeQueryCacheKey(const Query& query, DocumentStatus status);
+    // Must be called before the query is searched; matching does not need it
+    void ExpandWords(Query& query) const;
+    // Sums the weighted term frequencies of documents found in several lists
+    static PostingList MergePostingLists(const std::vector<std::pair<const PostingList*, double>>& weighted_lists);
+
+    // Returns nullptr for unknown words and for words left without documents
+    const PostingList* FindPostingList(std::string_view word) const;
+    // Looks prefix and fuzzy words up among the expanded ones
+    const PostingList* FindPostingList(const Query& query, std::string_view word) const;
+    // Ordinals of the documents with any of the minus words
+    DocumentBitmap CollectMinusDocuments(const Query& query) const;
+    // The documents a status predicate accepts; nullptr for other predicates, which can only be called
+    template <typename DocumentPredicate>
+    const DocumentBitmap* FindStatusDocuments(const DocumentPredicate& document_predicate) const;
+
+    // Minus words are checked first: if one is found, no plus words are looked up
+    template <typename ExecutionPolicy>
+    std::vector<std::string_view> MatchWords(ExecutionPolicy&& policy, const Query& query, int document_id) const;
+
+    bool ContainsPhrase(uint32_t document_ordinal, const Phrase& phrase) const;
+    bool ContainsPhrases(uint32_t document_ordinal, const Query& query) const;
+    // Ordinals of the documents with all phrases of the query: the posting lists of the
+    // phrase words are intersected first, and positions are only read for the documents
+    // found in all of them
+    std::vector<uint32_t> FindPhraseDocuments(const Query& query) const;
 
-    double ComputeWordInverseDocumentFreq(const std::string& word) const;
+    using WordScorer = typename ScoringPolicy::WordScorer;
+
+    // Uses the document count, average document length and frequency of the collection if statistics
+    // are given, and of this server otherwise. The length of each document is read from this server
+    WordScorer MakeWordScorer(std::string_view word, const PostingList& postings, const QueryStatistics* statistics) const;
+
+    // Scores documents one at a time across all posting lists and skips those
+    // that cannot get into the top (MaxScore dynamic pruning). Selects document_count
+    // documents; if last_document is given, only from those ranked below it
+    template <typename DocumentPredicate>
+    std::vector<Document> SelectTopDocuments(const std::execution::sequenced_policy&, const Query& query, DocumentPredicate document_predicate,
+                                             const QueryStatistics* statistics, size_t document_count = MAX_RESULT_DOCUMENT_COUNT,
+                                             const Document* last_document = nullptr) const;
 
+    // Scores all matching documents term at a time and keeps the best of them. Ranges of
+    // ordinals are scored on different threads, each into its own RelevanceAccumulator
     template <typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(const Query& query, DocumentPredicate document_predicate) const;
+    std::vector<Document> SelectTopDocuments(const std::execution::parallel_policy&, const Query& query, DocumentPredicate document_predicate,
+                                             const QueryStatistics* statistics) const;
+
+    // Scores the documents found by FindPhraseDocuments, the same way as the other queries
+    template <typename DocumentPredicate>
+    std::vector<Document> SelectPhraseDocuments(const Query& query, DocumentPredicate document_predicate,
+                                                const QueryStatistics* statistics, size_t document_count = MAX_RESULT_DOCUMENT_COUNT,
+                                                const Document* last_document = nullptr) const;
+
+    // Fits the relevances of a range into the cache of a core
+    static constexpr uint32_t ACCUMULATOR_RANGE_SIZE = 1 << 15;
 };
 
 // Template method implementations
 
+template <typename ScoringPolicy>
 template <typename StringContainer>
-SearchServer::SearchServer(const StringContainer& stop_words)
+BasicSearchServer<ScoringPolicy>::BasicSearchServer(const StringContainer& stop_words)
     : stop_words_(MakeUniqueNonEmptyStrings(stop_words)) {
     if (!std::all_of(stop_words_.begin(), stop_words_.end(), IsValidWord)) {
         throw std::invalid_argument("Some of stop words are invalid");
     }
 }
 
+template <typename ScoringPolicy>
+template <typename DocumentRange>
+void BasicSearchServer<ScoringPolicy>::AddDocuments(const DocumentRange& documents) {
+    std::vector<const DocumentInput*> document_inputs;
+    for (const DocumentInput& document : documents) {
+        document_inputs.push_back(&document);
+    }
+    AddDocumentBatch(document_inputs);
+}
+
+template <typename ScoringPolicy>
+template <typename ExecutionPolicy>
+void BasicSearchServer<ScoringPolicy>::RemoveDocument(ExecutionPolicy&& policy, int document_id) {
+    const auto document = documents_.find(document_id);
+    if (document == documents_.end()) {
+        return;
+    }
+    const uint32_t document_ordinal = document->second.ordinal;
+    CollectSnapshotWordFrequencies();
+    const auto word_freqs = document_to_word_freqs_.find(document_id);
+
+    std::vector<PostingList*> posting_lists;
+    posting_lists.reserve(word_freqs->second.size());
+    for (const auto& [word, _] : word_freqs->second) {
+        posting_lists.push_back(&postings_[*terms_.Find(word)]);
+    }
+    std::for_each(policy, posting_lists.begin(), posting_lists.end(),
+        [document_ordinal](PostingList* postings) {
+            postings->Erase(document_ordinal);
+        });
+
+    if (positions_) {
+        positions_->RemoveDocument(document_ordinal);
+    }
+    status_documents_[static_cast<size_t>(document->second.status)].Remove(document_ordinal);
+    document_length_sum_ -= ordinal_lengths_[document_ordinal];
+    documents_.erase(document);
+    document_to_word_freqs_.erase(word_freqs);
+    document_ids_.erase(std::lower_bound(document_ids_.begin(), document_ids_.end(), document_id));
+    if (query_cache_) {
+        query_cache_->Invalidate();
+    }
+}
+
+template <typename ScoringPolicy>
+template <typename DocumentPredicate>
+std::vector<Document> BasicSearchServer<ScoringPolicy>::FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const {
+    return FindTopDocuments(std::execution::seq, raw_query, document_predicate);
+}
+
+template <typename ScoringPolicy>
+template <typename ExecutionPolicy, typename DocumentPredicate>
+std::vector<Document> BasicSearchServer<ScoringPolicy>::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate) const {
+    auto query = ParseQuery(raw_query);
+    ExpandWords(query);
+    return SelectTopDocuments(policy, query, document_predicate, nullptr);
+}
+
+template <typename ScoringPolicy>
+template <typename ExecutionPolicy>
+std::vector<Document> BasicSearchServer<ScoringPolicy>::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentStatus status) const {
+    auto query = ParseQuery(raw_query);
+    const StatusPredicate status_predicate{status};
+    if (!query_cache_) {
+        ExpandWords(query);
+        return SelectTopDocuments(policy, query, status_predicate, nullptr);
+    }
+
+    // Both policies give the same results, so they share the cached ones
+    const std::string key = MakeQueryCacheKey(query, status);
+    if (auto documents = query_cache_->Find(key)) {
+        return std::move(*documents);
+    }
+    const uint64_t generation = query_cache_->GetGeneration();
+    ExpandWords(query);
+    auto documents = SelectTopDocuments(policy, query, status_predicate, nullptr);
+    query_cache_->Insert(key, generation, documents);
+    return documents;
+}
+
+template <typename ScoringPolicy>
+template <typename ExecutionPolicy>
+std::vector<Document> BasicSearchServer<ScoringPolicy>::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query) const {
+    return FindTopDocuments(policy, raw_query, DocumentStatus::ACTUAL);
+}
+
+template <typename ScoringPolicy>
+template <typename ExecutionPolicy, typename DocumentPredicate>
+std::vector<Document> BasicSearchServer<ScoringPolicy>::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate,
+                                                     const QueryStatistics& statistics) const {
+    auto query = ParseQuery(raw_query);
+    ExpandWords(query);
+    return SelectTopDocuments(policy, query, document_predicate, &statistics);
+}
+
+template <typename ScoringPolicy>
+template <typename ExecutionPolicy>
+std::vector<Document> BasicSearchServer<ScoringPolicy>::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentStatus status,
+                                                     const QueryStatistics& statistics) const {
+    auto query = ParseQuery(raw_query);
+    ExpandWords(query);
+    return SelectTopDocuments(policy, query, StatusPredicate{status}, &statistics);
+}
+
+template <typename ScoringPolicy>
 template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindTopDocuments(const std::string& raw_query, DocumentPredicate document_predicate) const {
+DocumentPage BasicSearchServer<ScoringPolicy>::FindDocumentsPage(std::string_view raw_query, const SearchCursor& cursor, size_t page_size,
+                                             DocumentPredicate document_predicate) const {
+    if (page_size == 0) {
+        throw std::invalid_argument("Page size must be positive");
+    }
+    auto query = ParseQuery(raw_query);
+    if (cursor.IsEnd()) {
+        return {{}, cursor};
+    }
+    ExpandWords(query);
+    DocumentPage page;
+    page.documents = SelectTopDocuments(std::execution::seq, query, document_predicate, nullptr, page_size, cursor.GetLastDocument());
+    page.next_cursor = page.documents.size() < page_size ? SearchCursor::MakeEnd() : SearchCursor::MakeAfter(page.documents.back());
+    return page;
+}
+
+template <typename ScoringPolicy>
+template <typename ExecutionPolicy>
+std::tuple<std::vector<std::string_view>, DocumentStatus> BasicSearchServer<ScoringPolicy>::MatchDocument(ExecutionPolicy&& policy, std::string_view raw_query, int document_id) const {
     const auto query = ParseQuery(raw_query);
-    auto matched_documents = FindAllDocuments(query, document_predicate);
-
-    std::sort(matched_documents.begin(), matched_documents.end(),
-        [](const Document& lhs, const Document& rhs) {
-            if (std::abs(lhs.relevance - rhs.relevance) < 1e-6) {
-                return lhs.rating > rhs.rating;
-            } else {
-                return lhs.relevance > rhs.relevance;
-            }
+    const DocumentStatus status = documents_.at(document_id).status;
+    return {MatchWords(policy, query, document_id), status};
+}
+
+template <typename ScoringPolicy>
+template <typename ExecutionPolicy>
+std::vector<std::tuple<std::vector<std::string_view>, DocumentStatus>> BasicSearchServer<ScoringPolicy>::MatchDocuments(
+    ExecutionPolicy&& policy, std::string_view raw_query, const std::vector<int>& document_ids) const {
+    const auto query = ParseQuery(raw_query);
+    // Checked up front: an exception thrown inside a parallel algorithm terminates the program
+    std::vector<DocumentStatus> statuses;
+    statuses.reserve(document_ids.size());
+    for (const int document_id : document_ids) {
+        statuses.push_back(documents_.at(document_id).status);
+    }
+
+    std::vector<std::tuple<std::vector<std::string_view>, DocumentStatus>> matches(document_ids.size());
+    std::transform(policy, document_ids.begin(), document_ids.end(), statuses.begin(), matches.begin(),
+        [this, &query](int document_id, DocumentStatus status) {
+            return std::tuple{MatchWords(std::execution::seq, query, document_id), status};
         });
-    if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
-        matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+    return matches;
+}
+
+template <typename ScoringPolicy>
+template <typename ExecutionPolicy>
+std::vector<std::string_view> BasicSearchServer<ScoringPolicy>::MatchWords(ExecutionPolicy&& policy, const Query& query, int document_id) const {
+    const auto& word_freqs = GetWordFrequencies(document_id);
+    const auto is_in_document = [&word_freqs](std::string_view word) {
+        return IsExpanded(word) ? !FindExpandedWords(word, word_freqs).empty() : word_freqs.count(word) > 0;
+    };
+    if (std::any_of(policy, query.minus_words.begin(), query.minus_words.end(), is_in_document)) {
+        return {};
     }
+    if (!query.phrases.empty() && !ContainsPhrases(documents_.at(document_id).ordinal, query)) {
+        return {};
+    }
+
+    // Plus words are sorted and unique, and the transform keeps their order
+    std::vector<std::string_view> matched_words(query.plus_words.size());
+    std::transform(policy, query.plus_words.begin(), query.plus_words.end(), matched_words.begin(),
+        [&word_freqs](std::string_view word) {
+            const auto it = IsExpanded(word) ? word_freqs.end() : word_freqs.find(word);
+            return it == word_freqs.end() ? std::string_view() : it->first;
+        });
+    matched_words.erase(std::remove_if(matched_words.begin(), matched_words.end(),
+                                       [](std::string_view word) { return word.empty(); }),
+                        matched_words.end());
 
-    return matched_documents;
+    bool has_expanded_word = false;
+    for (const std::string_view word : query.plus_words) {
+        if (IsExpanded(word)) {
+            has_expanded_word = true;
+            for (const std::string_view expanded_word : FindExpandedWords(word, word_freqs)) {
+                matched_words.push_back(expanded_word);
+            }
+        }
+    }
+    if (has_expanded_word) {
+        std::sort(matched_words.begin(), matched_words.end());
+        matched_words.erase(std::unique(matched_words.begin(), matched_words.end()), matched_words.end());
+    }
+    return matched_words;
 }
 
+template <typename ScoringPolicy>
 template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(const Query& query, DocumentPredicate document_predicate) const {
-    std::map<int, double> document_to_relevance;
-    for (const std::string& word : query.plus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
+std::vector<Document> BasicSearchServer<ScoringPolicy>::SelectTopDocuments(const std::execution::sequenced_policy&, const Query& query, DocumentPredicate document_predicate,
+                                                       const QueryStatistics* statistics, size_t document_count,
+                                                       const Document* last_document) const {
+    if (!query.phrases.empty()) {
+        return SelectPhraseDocuments(query, document_predicate, statistics, document_count, last_document);
+    }
+
+    struct TermCursor {
+        PostingList::Cursor cursor;
+        WordScorer scorer;
+        double max_relevance;
+        size_t word_index;
+    };
+
+    std::vector<TermCursor> terms;
+    for (size_t word_index = 0; word_index < query.plus_words.size(); ++word_index) {
+        const PostingList* postings = FindPostingList(query, query.plus_words[word_index]);
+        if (postings == nullptr) {
             continue;
         }
-        const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-        for (const auto& [document_id, term_freq] : word_to_document_freqs_.at(word)) {
-            const auto& document_data = documents_.at(document_id);
-            if (document_predicate(document_id, document_data.status, document_data.rating)) {
-                document_to_relevance[document_id] += term_freq * inverse_document_freq;
+        const WordScorer scorer = MakeWordScorer(query.plus_words[word_index], *postings, statistics);
+        terms.push_back({postings->GetCursor(), scorer, scorer.GetMaxScore(postings->GetMaxTermFreq()), word_index});
+    }
+    std::vector<PostingList::Cursor> minus_cursors;
+    for (const std::string_view word : query.minus_words) {
+        if (const PostingList* postings = FindPostingList(query, word)) {
+            minus_cursors.push_back(postings->GetCursor());
+        }
+    }
+
+    // MaxScore: with terms ordered by their highest possible contribution, the longest
+    // prefix whose contributions add up to less than the threshold is non-essential.
+    // A document found only in non-essential lists cannot make it into the top,
+    // so candidates are taken from the essential lists alone
+    std::sort(terms.begin(), terms.end(), [](const TermCursor& lhs, const TermCursor& rhs) {
+        return lhs.max_relevance < rhs.max_relevance;
+    });
+    std::vector<double> max_relevance_prefix_sums(terms.size() + 1, 0.0);
+    for (size_t i = 0; i < terms.size(); ++i) {
+        max_relevance_prefix_sums[i + 1] = max_relevance_prefix_sums[i] + terms[i].max_relevance;
+    }
+
+    const DocumentBitmap* status_documents = FindStatusDocuments(document_predicate);
+    // The search skips straight to the documents of a rare status. A common one is only
+    // checked for the documents left after pruning: skipping would not pay for the lookups
+    const bool skips_to_status = status_documents != nullptr && status_documents->GetSize() * 2 < documents_.size();
+    TopDocuments top_documents(document_count);
+    // A document can outrank the worst kept one only if its relevance is above
+    // the worst relevance minus RELEVANCE_EPSILON; the extra margin covers rounding
+    // in the sums of maximal contributions
+    double threshold = -std::numeric_limits<double>::infinity();
+    size_t first_essential = 0;
+    std::vector<double> word_relevances(query.plus_words.size());
+
+    while (first_essential < terms.size()) {
+        uint32_t document_ordinal = END_DOCUMENT_ORDINAL;
+        for (size_t i = first_essential; i < terms.size(); ++i) {
+            document_ordinal = std::min(document_ordinal, terms[i].cursor.GetDocumentOrdinal());
+        }
+        if (document_ordinal == END_DOCUMENT_ORDINAL) {
+            break;
+        }
+        if (skips_to_status) {
+            const uint32_t next_ordinal = status_documents->FindNext(document_ordinal);
+            if (next_ordinal != document_ordinal) {
+                for (size_t i = first_essential; i < terms.size(); ++i) {
+                    terms[i].cursor.SkipTo(next_ordinal);
+                }
+                continue;
             }
         }
+
+        std::fill(word_relevances.begin(), word_relevances.end(), 0.0);
+        double relevance_bound = 0.0;
+        for (size_t i = first_essential; i < terms.size(); ++i) {
+            TermCursor& term = terms[i];
+            if (term.cursor.GetDocumentOrdinal() == document_ordinal) {
+                const double word_relevance = term.scorer.Score(document_ordinal, term.cursor.GetTermFreq());
+                word_relevances[term.word_index] = word_relevance;
+                relevance_bound += word_relevance;
+                term.cursor.Next();
+            }
+        }
+        bool is_pruned = false;
+        for (size_t i = first_essential; i-- > 0;) {
+            if (relevance_bound + max_relevance_prefix_sums[i + 1] < threshold) {
+                is_pruned = true;
+                break;
+            }
+            TermCursor& term = terms[i];
+            term.cursor.SkipTo(document_ordinal);
+            if (term.cursor.GetDocumentOrdinal() == document_ordinal) {
+                const double word_relevance = term.scorer.Score(document_ordinal, term.cursor.GetTermFreq());
+                word_relevances[term.word_index] = word_relevance;
+                relevance_bound += word_relevance;
+            }
+        }
+        if (is_pruned || relevance_bound < threshold) {
+            continue;
+        }
+
+        if (status_documents != nullptr && !skips_to_status && !status_documents->Contains(document_ordinal)) {
+            continue;
+        }
+        const bool has_minus_word = std::any_of(minus_cursors.begin(), minus_cursors.end(),
+            [document_ordinal](PostingList::Cursor& cursor) {
+                cursor.SkipTo(document_ordinal);
+                return cursor.GetDocumentOrdinal() == document_ordinal;
+            });
+        if (has_minus_word) {
+            continue;
+        }
+        const int document_id = ordinal_to_document_id_[document_ordinal];
+        const int rating = ordinal_ratings_[document_ordinal];
+        if (status_documents == nullptr && !document_predicate(document_id, ordinal_statuses_[document_ordinal], rating)) {
+            continue;
+        }
+
+        // Summed in query word order, exactly as the exhaustive evaluation does
+        double relevance = 0.0;
+        for (const double word_relevance : word_relevances) {
+            relevance += word_relevance;
+        }
+        // Documents up to the last one of the previous page were returned with it
+        if (last_document != nullptr && !IsRankedHigher(*last_document, {document_id, relevance, rating})) {
+            continue;
+        }
+        if (top_documents.Add({document_id, relevance, rating}) && top_documents.IsFull()) {
+            threshold = top_documents.GetWorst().relevance - 2 * RELEVANCE_EPSILON;
+            while (first_essential < terms.size() && max_relevance_prefix_sums[first_essential + 1] < threshold) {
+                ++first_essential;
+            }
+        }
+    }
+    return top_documents.Extract();
+}
+
+template <typename ScoringPolicy>
+template <typename DocumentPredicate>
+std::vector<Document> BasicSearchServer<ScoringPolicy>::SelectTopDocuments(const std::execution::parallel_policy&, const Query& query, DocumentPredicate document_predicate,
+                                                       const QueryStatistics* statistics) const {
+    if (!query.phrases.empty()) {
+        // Phrase documents are few after the intersection, and checking positions is cheap
+        return SelectPhraseDocuments(query, document_predicate, statistics);
+    }
+
+    struct WeightedPostings {
+        const PostingList* postings;
+        WordScorer scorer;
+    };
+
+    // Kept in query word order: a range is scored on one thread, so relevances
+    // are summed in the same order as by the sequential search
+    std::vector<WeightedPostings> terms;
+    for (const std::string_view word : query.plus_words) {
+        if (const PostingList* postings = FindPostingList(query, word)) {
+            terms.push_back({postings, MakeWordScorer(word, *postings, statistics)});
+        }
+    }
+    // Minus words and the status are checked once per document found, against
+    // the bitmap of the minus words and that of the status, which is not copied
+    const DocumentBitmap minus_documents = CollectMinusDocuments(query);
+    const DocumentBitmap* status_documents = FindStatusDocuments(document_predicate);
+
+    const auto ordinal_count = static_cast<uint32_t>(ordinal_to_document_id_.size());
+    std::vector<uint32_t> range_begins;
+    for (uint32_t range_begin = 0; range_begin < ordinal_count; range_begin += std::min(ACCUMULATOR_RANGE_SIZE, ordinal_count - range_begin)) {
+        range_begins.push_back(range_begin);
     }
+    std::vector<std::vector<Document>> range_documents(range_begins.size());
+    std::transform(std::execution::par, range_begins.begin(), range_begins.end(), range_documents.begin(),
+        [&](uint32_t range_begin) {
+            const uint32_t range_end = range_begin + std::min(ACCUMULATOR_RANGE_SIZE, ordinal_count - range_begin);
+            // A range without documents of the status is not scored at all
+            if (status_documents != nullptr && status_documents->FindNext(range_begin) >= range_end) {
+                return std::vector<Document>{};
+            }
+            thread_local RelevanceAccumulator accumulator;
+            accumulator.Reset(range_begin, range_end - range_begin);
+            for (const WeightedPostings& term : terms) {
+                auto cursor = term.postings->GetCursor();
+                for (cursor.SkipTo(range_begin); cursor.GetDocumentOrdinal() < range_end; cursor.Next()) {
+                    const uint32_t document_ordinal = cursor.GetDocumentOrdinal();
+                    accumulator.Add(document_ordinal, term.scorer.Score(document_ordinal, cursor.GetTermFreq()));
+                }
+            }
+
+            TopDocuments top_documents(MAX_RESULT_DOCUMENT_COUNT);
+            accumulator.ForEachTouched([&](uint32_t document_ordinal, double relevance) {
+                const bool is_excluded = minus_documents.Contains(document_ordinal)
+                    || (status_documents != nullptr && !status_documents->Contains(document_ordinal));
+                if (is_excluded) {
+                    return;
+                }
+                const int document_id = ordinal_to_document_id_[document_ordinal];
+                const int rating = ordinal_ratings_[document_ordinal];
+                if (status_documents == nullptr && !document_predicate(document_id, ordinal_statuses_[document_ordinal], rating)) {
+                    return;
+                }
+                top_documents.Add({document_id, relevance, rating});
+            });
+            return top_documents.Extract();
+        });
+
+    TopDocuments top_documents(MAX_RESULT_DOCUMENT_COUNT);
+    for (const auto& documents : range_documents) {
+        for (const Document& document : documents) {
+            top_documents.Add(document);
+        }
+    }
+    return top_documents.Extract();
+}
 
-    for (const std::string& word : query.minus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
+template <typename ScoringPolicy>
+template <typename DocumentPredicate>
+std::vector<Document> BasicSearchServer<ScoringPolicy>::SelectPhraseDocuments(const Query& query, DocumentPredicate document_predicate,
+                                                          const QueryStatistics* statistics, size_t document_count,
+                                                          const Document* last_document) const {
+    struct TermCursor {
+        PostingList::Cursor cursor;
+        WordScorer scorer;
+    };
+
+    // Kept in query word order, so that relevances are summed as elsewhere
+    std::vector<TermCursor> terms;
+    for (const std::string_view word : query.plus_words) {
+        if (const PostingList* postings = FindPostingList(query, word)) {
+            terms.push_back({postings->GetCursor(), MakeWordScorer(word, *postings, statistics)});
+        }
+    }
+    std::vector<PostingList::Cursor> minus_cursors;
+    for (const std::string_view word : query.minus_words) {
+        if (const PostingList* postings = FindPostingList(query, word)) {
+            minus_cursors.push_back(postings->GetCursor());
+        }
+    }
+
+    const DocumentBitmap* status_documents = FindStatusDocuments(document_predicate);
+    TopDocuments top_documents(document_count);
+    for (const uint32_t document_ordinal : FindPhraseDocuments(query)) {
+        if (status_documents != nullptr && !status_documents->Contains(document_ordinal)) {
             continue;
         }
-        for (const auto& [document_id, _] : word_to_document_freqs_.at(word)) {
-            document_to_relevance.erase(document_id);
+        const bool has_minus_word = std::any_of(minus_cursors.begin(), minus_cursors.end(),
+            [document_ordinal](PostingList::Cursor& cursor) {
+                cursor.SkipTo(document_ordinal);
+                return cursor.GetDocumentOrdinal() == document_ordinal;
+            });
+        if (has_minus_word) {
+            continue;
+        }
+        const int document_id = ordinal_to_document_id_[document_ordinal];
+        const int rating = ordinal_ratings_[document_ordinal];
+        if (status_documents == nullptr && !document_predicate(document_id, ordinal_statuses_[document_ordinal], rating)) {
+            continue;
         }
+
+        double relevance = 0.0;
+        for (TermCursor& term : terms) {
+            term.cursor.SkipTo(document_ordinal);
+            if (term.cursor.GetDocumentOrdinal() == document_ordinal) {
+                relevance += term.scorer.Score(document_ordinal, term.cursor.GetTermFreq());
+            }
+        }
+        if (last_document != nullptr && !IsRankedHigher(*last_document, {document_id, relevance, rating})) {
+            continue;
+        }
+        top_documents.Add({document_id, relevance, rating});
     }
+    return top_documents.Extract();
+}
 
-    std::vector<Document> matched_documents;
-    for (const auto& [document_id, relevance] : document_to_relevance) {
-        matched_documents.push_back({document_id, relevance, documents_.at(document_id).rating});
+template <typename ScoringPolicy>
+template <typename DocumentPredicate>
+const DocumentBitmap* BasicSearchServer<ScoringPolicy>::FindStatusDocuments(const DocumentPredicate& document_predicate) const {
+    if constexpr (std::is_same_v<DocumentPredicate, StatusPredicate>) {
+        return &status_documents_[static_cast<size_t>(document_predicate.status)];
+    } else {
+        (void)document_predicate;
+        return nullptr;
     }
-    return matched_documents;
-}
\ No newline at end of file
+}
+
+using SearchServer = BasicSearchServer<TfIdfScoring>;
+
+// Both policies are instantiated in search_server.cpp
+extern template class BasicSearchServer<TfIdfScoring>;
+extern template class BasicSearchServer<Bm25Scoring>;
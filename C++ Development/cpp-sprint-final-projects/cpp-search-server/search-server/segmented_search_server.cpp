@@ -0,0 +1,190 @@
+#include "segmented_search_server.h"
+#include <iterator>
+#include <stdexcept>
+
+using namespace std::literals;
+
+SegmentedSearchServer::SegmentedSearchServer(const std::string& stop_words_text, size_t flush_document_count)
+    : SegmentedSearchServer(std::string_view(stop_words_text), flush_document_count) {}
+
+SegmentedSearchServer::SegmentedSearchServer(std::string_view stop_words_text, size_t flush_document_count)
+    : SegmentedSearchServer(SplitIntoWords(stop_words_text), flush_document_count) {}
+
+SegmentedSearchServer::~SegmentedSearchServer() {
+    {
+        std::lock_guard guard(mutex_);
+        is_stopped_ = true;
+    }
+    merge_condition_.notify_all();
+    merge_thread_.join();
+}
+
+void SegmentedSearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings) {
+    std::lock_guard guard(mutex_);
+    if (document_servers_.count(document_id) > 0) {
+        throw std::invalid_argument("Invalid document_id"s);
+    }
+    writable_server_->AddDocument(document_id, document, status, ratings);
+    document_servers_.emplace(document_id, nullptr);
+    if (static_cast<size_t>(writable_server_->GetDocumentCount()) >= flush_document_count_) {
+        FlushLocked();
+    }
+}
+
+void SegmentedSearchServer::RemoveDocument(int document_id) {
+    std::lock_guard guard(mutex_);
+    const auto it = document_servers_.find(document_id);
+    if (it == document_servers_.end()) {
+        return;
+    }
+    const SearchServer* server = it->second;
+    document_servers_.erase(it);
+    if (server == nullptr) {
+        writable_server_->RemoveDocument(document_id);
+        return;
+    }
+
+    SegmentList segments = *segments_;
+    for (Segment& segment : segments) {
+        if (segment.server.get() == server) {
+            auto removed_ids = std::make_shared<std::set<int>>(*segment.removed_ids);
+            removed_ids->insert(document_id);
+            segment.removed_ids = std::move(removed_ids);
+            break;
+        }
+    }
+    PublishSegments(std::move(segments));
+}
+
+void SegmentedSearchServer::Flush() {
+    std::lock_guard guard(mutex_);
+    FlushLocked();
+}
+
+void SegmentedSearchServer::WaitForMerges() {
+    std::unique_lock lock(mutex_);
+    merge_condition_.wait(lock, [this] {
+        return !is_merging_ && ChooseSegmentsToMerge().empty();
+    });
+}
+
+std::vector<Document> SegmentedSearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status) const {
+    return FindTopDocuments(std::execution::seq, raw_query, status);
+}
+
+std::vector<Document> SegmentedSearchServer::FindTopDocuments(std::string_view raw_query) const {
+    return FindTopDocuments(std::execution::seq, raw_query);
+}
+
+int SegmentedSearchServer::GetDocumentCount() const {
+    int document_count = 0;
+    for (const Segment& segment : *GetSegments()) {
+        document_count += segment.server->GetDocumentCount() - static_cast<int>(segment.removed_ids->size());
+    }
+    return document_count;
+}
+
+size_t SegmentedSearchServer::GetSegmentCount() const {
+    return GetSegments()->size();
+}
+
+std::shared_ptr<const SegmentedSearchServer::SegmentList> SegmentedSearchServer::GetSegments() const {
+    return std::atomic_load(&segments_);
+}
+
+void SegmentedSearchServer::PublishSegments(SegmentList segments) {
+    std::atomic_store(&segments_, std::shared_ptr<const SegmentList>(std::make_shared<SegmentList>(std::move(segments))));
+}
+
+void SegmentedSearchServer::FlushLocked() {
+    if (writable_server_->GetDocumentCount() == 0) {
+        return;
+    }
+    std::shared_ptr<const SearchServer> server = std::move(writable_server_);
+    writable_server_ = std::make_unique<SearchServer>(stop_words_);
+    for (const int document_id : *server) {
+        document_servers_[document_id] = server.get();
+    }
+
+    SegmentList segments = *segments_;
+    segments.push_back({server, std::make_shared<const std::set<int>>()});
+    PublishSegments(std::move(segments));
+    merge_condition_.notify_all();
+}
+
+std::vector<SegmentedSearchServer::Segment> SegmentedSearchServer::ChooseSegmentsToMerge() const {
+    std::map<int, std::vector<Segment>> tiers;
+    for (const Segment& segment : *segments_) {
+        int tier = 0;
+        for (size_t tier_capacity = flush_document_count_;
+             tier_capacity < static_cast<size_t>(segment.server->GetDocumentCount());
+             tier_capacity *= MERGE_FACTOR) {
+            ++tier;
+        }
+        auto& tier_segments = tiers[tier];
+        tier_segments.push_back(segment);
+        if (tier_segments.size() == MERGE_FACTOR) {
+            return tier_segments;
+        }
+    }
+    return {};
+}
+
+void SegmentedSearchServer::RunMerges() {
+    std::unique_lock lock(mutex_);
+    while (true) {
+        std::vector<Segment> segments;
+        merge_condition_.wait(lock, [this, &segments] {
+            if (is_stopped_) {
+                return true;
+            }
+            segments = ChooseSegmentsToMerge();
+            return !segments.empty();
+        });
+        if (is_stopped_) {
+            return;
+        }
+
+        is_merging_ = true;
+        lock.unlock();
+        // Documents removed before the merge has started are left out;
+        // the ones removed while it runs are carried over to the merged segment
+        auto server = std::make_shared<SearchServer>(stop_words_);
+        for (const Segment& segment : segments) {
+            server->AddDocumentsFrom(*segment.server, *segment.removed_ids);
+        }
+        lock.lock();
+        PublishMerge(segments, std::move(server));
+        is_merging_ = false;
+        merge_condition_.notify_all();
+    }
+}
+
+void SegmentedSearchServer::PublishMerge(const std::vector<Segment>& merged_segments, std::shared_ptr<const SearchServer> server) {
+    auto removed_ids = std::make_shared<std::set<int>>();
+    SegmentList segments;
+    for (const Segment& segment : *segments_) {
+        const auto merged_segment = std::find_if(merged_segments.begin(), merged_segments.end(),
+            [&segment](const Segment& merged_segment) {
+                return merged_segment.server == segment.server;
+            });
+        if (merged_segment == merged_segments.end()) {
+            segments.push_back(segment);
+            continue;
+        }
+        std::set_difference(segment.removed_ids->begin(), segment.removed_ids->end(),
+                            merged_segment->removed_ids->begin(), merged_segment->removed_ids->end(),
+                            std::inserter(*removed_ids, removed_ids->end()));
+    }
+    for (const int document_id : *server) {
+        if (removed_ids->count(document_id) == 0) {
+            document_servers_.at(document_id) = server.get();
+        }
+    }
+    segments.push_back({std::move(server), std::move(removed_ids)});
+    PublishSegments(std::move(segments));
+}
+
+QueryStatistics SegmentedSearchServer::GetSegmentStatistics(const Segment& segment, std::string_view raw_query) {
+    return segment.server->GetQueryStatistics(raw_query, *segment.removed_ids);
+}
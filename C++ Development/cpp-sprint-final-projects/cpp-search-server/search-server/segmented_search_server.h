@@ -0,0 +1,169 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <execution>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "document.h"
+#include "query_statistics.h"
+#include "search_server.h"
+#include "top_documents.h"
+
+// Search server that keeps its index as a list of immutable segments, so that
+// queries run while documents are added and removed.
+// New documents are collected in a writable SearchServer and become visible to
+// queries when it is sealed into a segment: once it holds flush_document_count
+// documents or on Flush. Removed documents are hidden at once and dropped from
+// the index when their segment is merged. A background thread merges segments
+// of similar size, so that their number grows logarithmically.
+// Queries take the current segment list without locking and rank documents with
+// the statistics of all segments, so results are the same as of a single server
+class SegmentedSearchServer {
+public:
+    template <typename StringContainer>
+    explicit SegmentedSearchServer(const StringContainer& stop_words, size_t flush_document_count = DEFAULT_FLUSH_DOCUMENT_COUNT);
+
+    explicit SegmentedSearchServer(const std::string& stop_words_text, size_t flush_document_count = DEFAULT_FLUSH_DOCUMENT_COUNT);
+    explicit SegmentedSearchServer(std::string_view stop_words_text, size_t flush_document_count = DEFAULT_FLUSH_DOCUMENT_COUNT);
+
+    SegmentedSearchServer(const SegmentedSearchServer&) = delete;
+    SegmentedSearchServer& operator=(const SegmentedSearchServer&) = delete;
+    ~SegmentedSearchServer();
+
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+    // Does nothing if there is no document with such id
+    void RemoveDocument(int document_id);
+    // Makes all added documents visible to queries
+    void Flush();
+    // Blocks until the merges that the current segments call for are done
+    void WaitForMerges();
+
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const;
+
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
+
+    // The policy applies to the segments: with std::execution::par they are searched in parallel
+    template <typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate) const;
+
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentStatus status) const;
+
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query) const;
+
+    // Number of documents visible to queries
+    int GetDocumentCount() const;
+    size_t GetSegmentCount() const;
+
+    static constexpr size_t DEFAULT_FLUSH_DOCUMENT_COUNT = 10000;
+
+private:
+    struct Segment {
+        std::shared_ptr<const SearchServer> server;
+        // Documents removed after the segment was sealed
+        std::shared_ptr<const std::set<int>> removed_ids;
+    };
+
+    // Segment lists are never changed once published: writers publish a new list
+    using SegmentList = std::vector<Segment>;
+
+    // Segments whose document counts fit under flush_document_count * MERGE_FACTOR^k
+    // but not ^(k - 1) are in tier k. MERGE_FACTOR segments of a tier are merged into one
+    static constexpr size_t MERGE_FACTOR = 4;
+
+    const std::vector<std::string> stop_words_;
+    const size_t flush_document_count_;
+    // Parses queries when there are no segments yet
+    const SearchServer empty_server_;
+
+    // Guards everything below except segments_, which readers load atomically
+    mutable std::mutex mutex_;
+    std::shared_ptr<const SegmentList> segments_;
+    std::unique_ptr<SearchServer> writable_server_;
+    // Sealed server of each document, or nullptr for documents of the writable server
+    std::map<int, const SearchServer*> document_servers_;
+
+    std::condition_variable merge_condition_;
+    bool is_merging_ = false;
+    bool is_stopped_ = false;
+    std::thread merge_thread_;
+
+    std::shared_ptr<const SegmentList> GetSegments() const;
+    void PublishSegments(SegmentList segments);
+    void FlushLocked();
+    // Returns an empty vector if no tier has enough segments
+    std::vector<Segment> ChooseSegmentsToMerge() const;
+    void RunMerges();
+    void PublishMerge(const std::vector<Segment>& merged_segments, std::shared_ptr<const SearchServer> server);
+
+    static QueryStatistics GetSegmentStatistics(const Segment& segment, std::string_view raw_query);
+};
+
+// Template method implementations
+
+template <typename StringContainer>
+SegmentedSearchServer::SegmentedSearchServer(const StringContainer& stop_words, size_t flush_document_count)
+    : stop_words_(stop_words.begin(), stop_words.end()),
+      flush_document_count_(std::max<size_t>(flush_document_count, 1)),
+      empty_server_(stop_words_),
+      segments_(std::make_shared<const SegmentList>()),
+      writable_server_(std::make_unique<SearchServer>(stop_words_)),
+      merge_thread_([this] { RunMerges(); }) {}
+
+template <typename DocumentPredicate>
+std::vector<Document> SegmentedSearchServer::FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const {
+    return FindTopDocuments(std::execution::seq, raw_query, document_predicate);
+}
+
+template <typename ExecutionPolicy, typename DocumentPredicate>
+std::vector<Document> SegmentedSearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate) const {
+    const auto segments = GetSegments();
+    QueryStatistics statistics = empty_server_.GetQueryStatistics(raw_query);
+    for (const Segment& segment : *segments) {
+        statistics += GetSegmentStatistics(segment, raw_query);
+    }
+
+    std::vector<std::vector<Document>> segment_documents(segments->size());
+    std::transform(policy, segments->begin(), segments->end(), segment_documents.begin(),
+        [&](const Segment& segment) {
+            const std::set<int>& removed_ids = *segment.removed_ids;
+            return segment.server->FindTopDocuments(std::execution::seq, raw_query,
+                [&](int document_id, DocumentStatus status, int rating) {
+                    return removed_ids.count(document_id) == 0 && document_predicate(document_id, status, rating);
+                },
+                statistics);
+        });
+
+    TopDocuments top_documents(MAX_RESULT_DOCUMENT_COUNT);
+    for (const auto& documents : segment_documents) {
+        for (const Document& document : documents) {
+            top_documents.Add(document);
+        }
+    }
+    return top_documents.Extract();
+}
+
+template <typename ExecutionPolicy>
+std::vector<Document> SegmentedSearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentStatus status) const {
+    return FindTopDocuments(
+        policy, raw_query, [status](int document_id, DocumentStatus document_status, int rating) {
+            (void)document_id;
+            (void)rating;
+            return document_status == status;
+        });
+}
+
+template <typename ExecutionPolicy>
+std::vector<Document> SegmentedSearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query) const {
+    return FindTopDocuments(policy, raw_query, DocumentStatus::ACTUAL);
+}
@@ -0,0 +1,391 @@
+#include "shard_process.h"
+#include "search_server.h"
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <type_traits>
+#include <unistd.h>
+
+using namespace std::literals;
+
+namespace {
+
+enum class RequestType : uint32_t {
+    ADD_DOCUMENT,
+    REMOVE_DOCUMENT,
+    GET_DOCUMENT_COUNT,
+    MATCH_DOCUMENT,
+    GET_QUERY_STATISTICS,
+    FIND_TOP_DOCUMENTS,
+    STOP,
+};
+
+// Starts every reply; errors are followed by their message
+enum class ReplyStatus : uint32_t {
+    OK,
+    INVALID_ARGUMENT,
+    OUT_OF_RANGE,
+    ERROR,
+};
+
+// Values are sent in the byte order of the machine: both ends are the same program
+class MessageWriter {
+public:
+    template <typename T>
+    void Write(const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        bytes_.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void WriteString(std::string_view text) {
+        Write(static_cast<uint64_t>(text.size()));
+        bytes_.append(text);
+    }
+
+    const std::string& GetBytes() const {
+        return bytes_;
+    }
+
+private:
+    std::string bytes_;
+};
+
+class MessageReader {
+public:
+    explicit MessageReader(std::string_view bytes)
+        : bytes_(bytes) {}
+
+    template <typename T>
+    T Read() {
+        static_assert(std::is_trivially_copyable_v<T>);
+        T value;
+        std::memcpy(&value, ReadBytes(sizeof(T)).data(), sizeof(T));
+        return value;
+    }
+
+    std::string_view ReadString() {
+        return ReadBytes(Read<uint64_t>());
+    }
+
+private:
+    std::string_view bytes_;
+
+    std::string_view ReadBytes(size_t size) {
+        if (size > bytes_.size()) {
+            throw std::runtime_error("Shard message is truncated"s);
+        }
+        const std::string_view bytes = bytes_.substr(0, size);
+        bytes_.remove_prefix(size);
+        return bytes;
+    }
+};
+
+// A message is its length followed by its bytes
+
+void WriteAll(int socket, const char* data, size_t size) {
+    while (size > 0) {
+        // MSG_NOSIGNAL: a worker that is gone is reported as an error, not by SIGPIPE
+        const ssize_t written = send(socket, data, size, MSG_NOSIGNAL);
+        if (written <= 0) {
+            throw std::runtime_error("Cannot send a message to the shard process"s);
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+}
+
+// Returns false if the other end was closed before any byte was read
+bool ReadAll(int socket, char* data, size_t size) {
+    for (size_t offset = 0; offset < size;) {
+        const ssize_t read_size = recv(socket, data + offset, size - offset, 0);
+        if (read_size <= 0) {
+            if (read_size == 0 && offset == 0) {
+                return false;
+            }
+            throw std::runtime_error("Cannot receive a message from the shard process"s);
+        }
+        offset += static_cast<size_t>(read_size);
+    }
+    return true;
+}
+
+void SendMessage(int socket, const std::string& message) {
+    const auto size = static_cast<uint64_t>(message.size());
+    WriteAll(socket, reinterpret_cast<const char*>(&size), sizeof(size));
+    WriteAll(socket, message.data(), message.size());
+}
+
+bool ReceiveMessage(int socket, std::string& message) {
+    uint64_t size = 0;
+    if (!ReadAll(socket, reinterpret_cast<char*>(&size), sizeof(size))) {
+        return false;
+    }
+    message.resize(size);
+    if (!ReadAll(socket, message.data(), message.size())) {
+        throw std::runtime_error("Cannot receive a message from the shard process"s);
+    }
+    return true;
+}
+
+void WriteStatistics(MessageWriter& writer, const QueryStatistics& statistics) {
+    writer.Write(statistics.document_count);
+    writer.Write(statistics.document_length_sum);
+    writer.Write(static_cast<uint64_t>(statistics.document_freqs.size()));
+    for (const auto& [word, document_freq] : statistics.document_freqs) {
+        writer.WriteString(word);
+        writer.Write(document_freq);
+    }
+}
+
+QueryStatistics ReadStatistics(MessageReader& reader) {
+    QueryStatistics statistics;
+    statistics.document_count = reader.Read<int>();
+    statistics.document_length_sum = reader.Read<uint64_t>();
+    const auto word_count = reader.Read<uint64_t>();
+    for (uint64_t i = 0; i < word_count; ++i) {
+        const std::string_view word = reader.ReadString();
+        statistics.document_freqs.emplace(word, reader.Read<int>());
+    }
+    return statistics;
+}
+
+void HandleRequest(SearchServer& server, RequestType type, MessageReader& request, MessageWriter& reply) {
+    switch (type) {
+    case RequestType::ADD_DOCUMENT: {
+        const auto document_id = request.Read<int>();
+        const auto status = request.Read<DocumentStatus>();
+        std::vector<int> ratings(request.Read<uint64_t>());
+        for (int& rating : ratings) {
+            rating = request.Read<int>();
+        }
+        server.AddDocument(document_id, request.ReadString(), status, ratings);
+        break;
+    }
+    case RequestType::REMOVE_DOCUMENT:
+        server.RemoveDocument(request.Read<int>());
+        break;
+    case RequestType::GET_DOCUMENT_COUNT:
+        reply.Write(server.GetDocumentCount());
+        break;
+    case RequestType::MATCH_DOCUMENT: {
+        const auto document_id = request.Read<int>();
+        const auto [words, status] = server.MatchDocument(request.ReadString(), document_id);
+        reply.Write(status);
+        reply.Write(static_cast<uint64_t>(words.size()));
+        for (const std::string& word : words) {
+            reply.WriteString(word);
+        }
+        break;
+    }
+    case RequestType::GET_QUERY_STATISTICS:
+        WriteStatistics(reply, server.GetQueryStatistics(request.ReadString()));
+        break;
+    case RequestType::FIND_TOP_DOCUMENTS: {
+        const auto status = request.Read<DocumentStatus>();
+        const std::string_view raw_query = request.ReadString();
+        const QueryStatistics statistics = ReadStatistics(request);
+        const auto documents = server.FindTopDocuments(std::execution::seq, raw_query, status, statistics);
+        reply.Write(static_cast<uint64_t>(documents.size()));
+        for (const Document& document : documents) {
+            reply.Write(document);
+        }
+        break;
+    }
+    default:
+        throw std::runtime_error("Unknown shard request"s);
+    }
+}
+
+// Threads of this process, or one where /proc is not available to count them
+int CountThreads() {
+    std::ifstream status("/proc/self/status"s);
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("Threads:"s, 0) == 0) {
+            return std::stoi(line.substr(line.find(':') + 1));
+        }
+    }
+    return 1;
+}
+
+// Serves requests until the parent stops the worker or closes its end of the socket
+[[noreturn]] void RunWorker(int socket, const std::vector<std::string>& stop_words) {
+    int exit_code = 0;
+    try {
+        SearchServer server(stop_words);
+        std::string request;
+        while (ReceiveMessage(socket, request)) {
+            MessageReader reader(request);
+            const auto type = reader.Read<RequestType>();
+            if (type == RequestType::STOP) {
+                break;
+            }
+            MessageWriter reply;
+            try {
+                MessageWriter payload;
+                HandleRequest(server, type, reader, payload);
+                reply.Write(ReplyStatus::OK);
+                reply.WriteString(payload.GetBytes());
+            } catch (const std::invalid_argument& e) {
+                reply.Write(ReplyStatus::INVALID_ARGUMENT);
+                reply.WriteString(e.what());
+            } catch (const std::out_of_range& e) {
+                reply.Write(ReplyStatus::OUT_OF_RANGE);
+                reply.WriteString(e.what());
+            } catch (const std::exception& e) {
+                reply.Write(ReplyStatus::ERROR);
+                reply.WriteString(e.what());
+            }
+            SendMessage(socket, reply.GetBytes());
+        }
+    } catch (...) {
+        exit_code = 1;
+    }
+    // The forked copy of the parent must not run its destructors or atexit handlers
+    _exit(exit_code);
+}
+
+}  // namespace
+
+ShardProcess::ShardProcess(const std::vector<std::string>& stop_words) {
+    if (CountThreads() > 1) {
+        throw std::logic_error("Shard processes must be started before other threads"s);
+    }
+    // Invalid stop words are rejected here: a worker could only report them by exiting
+    const SearchServer stop_words_check(stop_words);
+    int sockets[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0) {
+        throw std::runtime_error("Cannot create a socket pair for the shard process"s);
+    }
+    pid_ = fork();
+    if (pid_ < 0) {
+        close(sockets[0]);
+        close(sockets[1]);
+        throw std::runtime_error("Cannot start the shard process"s);
+    }
+    if (pid_ == 0) {
+        close(sockets[0]);
+        RunWorker(sockets[1], stop_words);
+    }
+    close(sockets[1]);
+    socket_ = sockets[0];
+}
+
+ShardProcess::~ShardProcess() {
+    // Other workers may hold copies of this socket, forked along with them,
+    // so the worker is told to stop rather than left to notice it is closed
+    try {
+        MessageWriter request;
+        request.Write(RequestType::STOP);
+        Send(request.GetBytes());
+    } catch (const std::exception&) {
+        // The worker is gone already
+    }
+    close(socket_);
+    waitpid(pid_, nullptr, 0);
+}
+
+void ShardProcess::AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings) {
+    MessageWriter request;
+    request.Write(RequestType::ADD_DOCUMENT);
+    request.Write(document_id);
+    request.Write(status);
+    request.Write(static_cast<uint64_t>(ratings.size()));
+    for (const int rating : ratings) {
+        request.Write(rating);
+    }
+    request.WriteString(document);
+    Send(request.GetBytes());
+    Receive();
+}
+
+void ShardProcess::RemoveDocument(int document_id) {
+    MessageWriter request;
+    request.Write(RequestType::REMOVE_DOCUMENT);
+    request.Write(document_id);
+    Send(request.GetBytes());
+    Receive();
+}
+
+int ShardProcess::GetDocumentCount() const {
+    MessageWriter request;
+    request.Write(RequestType::GET_DOCUMENT_COUNT);
+    Send(request.GetBytes());
+    const std::string reply = Receive();
+    return MessageReader(reply).Read<int>();
+}
+
+std::tuple<std::vector<std::string>, DocumentStatus> ShardProcess::MatchDocument(std::string_view raw_query, int document_id) const {
+    MessageWriter request;
+    request.Write(RequestType::MATCH_DOCUMENT);
+    request.Write(document_id);
+    request.WriteString(raw_query);
+    Send(request.GetBytes());
+    const std::string reply = Receive();
+    MessageReader reader(reply);
+    const auto status = reader.Read<DocumentStatus>();
+    std::vector<std::string> words(reader.Read<uint64_t>());
+    for (std::string& word : words) {
+        word = reader.ReadString();
+    }
+    return {words, status};
+}
+
+void ShardProcess::SendQueryStatisticsRequest(std::string_view raw_query) const {
+    MessageWriter request;
+    request.Write(RequestType::GET_QUERY_STATISTICS);
+    request.WriteString(raw_query);
+    Send(request.GetBytes());
+}
+
+QueryStatistics ShardProcess::ReceiveQueryStatistics() const {
+    const std::string reply = Receive();
+    MessageReader reader(reply);
+    return ReadStatistics(reader);
+}
+
+void ShardProcess::SendTopDocumentsRequest(std::string_view raw_query, DocumentStatus status, const QueryStatistics& statistics) const {
+    MessageWriter request;
+    request.Write(RequestType::FIND_TOP_DOCUMENTS);
+    request.Write(status);
+    request.WriteString(raw_query);
+    WriteStatistics(request, statistics);
+    Send(request.GetBytes());
+}
+
+std::vector<Document> ShardProcess::ReceiveTopDocuments() const {
+    const std::string reply = Receive();
+    MessageReader reader(reply);
+    std::vector<Document> documents(reader.Read<uint64_t>());
+    for (Document& document : documents) {
+        document = reader.Read<Document>();
+    }
+    return documents;
+}
+
+void ShardProcess::Send(const std::string& request) const {
+    SendMessage(socket_, request);
+}
+
+std::string ShardProcess::Receive() const {
+    std::string message;
+    if (!ReceiveMessage(socket_, message)) {
+        throw std::runtime_error("The shard process has exited"s);
+    }
+    MessageReader reader(message);
+    const auto status = reader.Read<ReplyStatus>();
+    std::string payload(reader.ReadString());
+    switch (status) {
+    case ReplyStatus::OK:
+        return payload;
+    case ReplyStatus::INVALID_ARGUMENT:
+        throw std::invalid_argument(payload);
+    case ReplyStatus::OUT_OF_RANGE:
+        throw std::out_of_range(payload);
+    default:
+        throw std::runtime_error(payload);
+    }
+}
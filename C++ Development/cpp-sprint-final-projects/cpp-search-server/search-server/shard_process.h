@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <sys/types.h>
+#include <tuple>
+#include <vector>
+#include "document.h"
+#include "query_statistics.h"
+
+// A SearchServer in a forked worker process, driven over a Unix socket pair.
+// Errors thrown by the server in the worker are thrown again here with the same
+// type: std::invalid_argument, std::out_of_range or std::runtime_error.
+// Query requests are sent and received separately, so that several workers
+// can be given a query before any of them is waited for. Not thread-safe
+class ShardProcess {
+public:
+    // Forks the worker. The child gets only the calling thread, so a lock that another
+    // thread held at the fork, such as one of the allocator or of the TBB pool behind
+    // std::execution::par, would stay locked in it forever. Workers must therefore be
+    // started while the process has one thread, e.g. first thing in main.
+    // Throws std::logic_error if the process has other threads, std::invalid_argument
+    // if the stop words are invalid and std::runtime_error if the process cannot be started
+    explicit ShardProcess(const std::vector<std::string>& stop_words);
+    ShardProcess(const ShardProcess&) = delete;
+    ShardProcess& operator=(const ShardProcess&) = delete;
+    // Stops the worker and waits for it to exit
+    ~ShardProcess();
+
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+    void RemoveDocument(int document_id);
+    int GetDocumentCount() const;
+    std::tuple<std::vector<std::string>, DocumentStatus> MatchDocument(std::string_view raw_query, int document_id) const;
+
+    void SendQueryStatisticsRequest(std::string_view raw_query) const;
+    QueryStatistics ReceiveQueryStatistics() const;
+    void SendTopDocumentsRequest(std::string_view raw_query, DocumentStatus status, const QueryStatistics& statistics) const;
+    std::vector<Document> ReceiveTopDocuments() const;
+
+private:
+    pid_t pid_;
+    int socket_;
+
+    void Send(const std::string& request) const;
+    // Throws the error the worker replied with
+    std::string Receive() const;
+};
@@ -0,0 +1,164 @@
+#include "sharded_search_server.h"
+#include <cstdint>
+
+using namespace std::literals;
+
+ShardedSearchServer::ShardedSearchServer(const std::string& stop_words_text, size_t shard_count, ShardMode mode)
+    : ShardedSearchServer(std::string_view(stop_words_text), shard_count, mode) {}
+
+ShardedSearchServer::ShardedSearchServer(std::string_view stop_words_text, size_t shard_count, ShardMode mode)
+    : ShardedSearchServer(SplitIntoWords(stop_words_text), shard_count, mode) {}
+
+ShardedSearchServer::ShardedSearchServer(std::vector<std::unique_ptr<ShardProcess>> processes)
+    : processes_(std::move(processes)) {
+    if (processes_.empty()) {
+        throw std::invalid_argument("A sharded server needs at least one shard"s);
+    }
+}
+
+void ShardedSearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings) {
+    // A document id always maps to the same shard, which rejects it if it is taken
+    const size_t shard = GetShard(document_id);
+    if (!servers_.empty()) {
+        servers_[shard]->AddDocument(document_id, document, status, ratings);
+        return;
+    }
+    std::lock_guard guard(processes_mutex_);
+    processes_[shard]->AddDocument(document_id, document, status, ratings);
+}
+
+void ShardedSearchServer::RemoveDocument(int document_id) {
+    const size_t shard = GetShard(document_id);
+    if (!servers_.empty()) {
+        servers_[shard]->RemoveDocument(document_id);
+        return;
+    }
+    std::lock_guard guard(processes_mutex_);
+    processes_[shard]->RemoveDocument(document_id);
+}
+
+std::vector<Document> ShardedSearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status) const {
+    if (!processes_.empty()) {
+        return SearchProcesses(raw_query, status);
+    }
+    return SearchServers(raw_query, [raw_query, status](const SearchServer& server, const QueryStatistics& statistics) {
+        return server.FindTopDocuments(std::execution::seq, raw_query, status, statistics);
+    });
+}
+
+std::vector<Document> ShardedSearchServer::FindTopDocuments(std::string_view raw_query) const {
+    return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
+}
+
+std::tuple<std::vector<std::string>, DocumentStatus> ShardedSearchServer::MatchDocument(std::string_view raw_query, int document_id) const {
+    const size_t shard = GetShard(document_id);
+    if (!servers_.empty()) {
+        return servers_[shard]->MatchDocument(raw_query, document_id);
+    }
+    std::lock_guard guard(processes_mutex_);
+    return processes_[shard]->MatchDocument(raw_query, document_id);
+}
+
+int ShardedSearchServer::GetDocumentCount() const {
+    int document_count = 0;
+    for (const auto& server : servers_) {
+        document_count += server->GetDocumentCount();
+    }
+    std::lock_guard guard(processes_mutex_);
+    for (const auto& process : processes_) {
+        document_count += process->GetDocumentCount();
+    }
+    return document_count;
+}
+
+size_t ShardedSearchServer::GetShardCount() const {
+    return servers_.size() + processes_.size();
+}
+
+size_t ShardedSearchServer::GetShard(int document_id) const {
+    // Fibonacci hashing, so that runs of consecutive ids are spread over all shards
+    const uint64_t hash = static_cast<uint32_t>(document_id) * 0x9E3779B97F4A7C15ull;
+    return static_cast<size_t>(hash >> 32) % GetShardCount();
+}
+
+void ShardedSearchServer::StartShards(size_t shard_count, ShardMode mode) {
+    if (shard_count == 0) {
+        throw std::invalid_argument("A sharded server needs at least one shard"s);
+    }
+    if (mode == ShardMode::THREADS) {
+        for (size_t shard = 0; shard < shard_count; ++shard) {
+            servers_.push_back(std::make_unique<SearchServer>(stop_words_));
+        }
+        return;
+    }
+    for (size_t shard = 0; shard < shard_count; ++shard) {
+        processes_.push_back(std::make_unique<ShardProcess>(stop_words_));
+    }
+}
+
+std::vector<Document> ShardedSearchServer::SearchProcesses(std::string_view raw_query, DocumentStatus status) const {
+    std::lock_guard guard(processes_mutex_);
+    // Every reply is received before an error is thrown, so that the next request
+    // to a worker is not answered with the reply to this one
+    std::exception_ptr error;
+    const auto receive_all = [this, &error](auto receive) {
+        for (const auto& process : processes_) {
+            try {
+                receive(*process);
+            } catch (...) {
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    };
+
+    for (const auto& process : processes_) {
+        process->SendQueryStatisticsRequest(raw_query);
+    }
+    QueryStatistics statistics;
+    receive_all([&statistics](const ShardProcess& process) {
+        statistics += process.ReceiveQueryStatistics();
+    });
+
+    for (const auto& process : processes_) {
+        process->SendTopDocumentsRequest(raw_query, status, statistics);
+    }
+    std::vector<std::vector<Document>> shard_documents;
+    shard_documents.reserve(processes_.size());
+    receive_all([&shard_documents](const ShardProcess& process) {
+        shard_documents.push_back(process.ReceiveTopDocuments());
+    });
+    return MergeTopDocuments(shard_documents);
+}
+
+std::vector<Document> ShardedSearchServer::MergeTopDocuments(const std::vector<std::vector<Document>>& shard_documents) {
+    // The heap holds the position of the next document of every list, the best on top
+    using Position = std::pair<size_t, size_t>;
+    const auto is_ranked_lower = [&shard_documents](const Position& lhs, const Position& rhs) {
+        return IsRankedHigher(shard_documents[rhs.first][rhs.second], shard_documents[lhs.first][lhs.second]);
+    };
+    std::vector<Position> heap;
+    for (size_t shard = 0; shard < shard_documents.size(); ++shard) {
+        if (!shard_documents[shard].empty()) {
+            heap.emplace_back(shard, 0);
+        }
+    }
+    std::make_heap(heap.begin(), heap.end(), is_ranked_lower);
+
+    std::vector<Document> documents;
+    while (!heap.empty() && documents.size() < static_cast<size_t>(MAX_RESULT_DOCUMENT_COUNT)) {
+        std::pop_heap(heap.begin(), heap.end(), is_ranked_lower);
+        const auto [shard, index] = heap.back();
+        heap.pop_back();
+        documents.push_back(shard_documents[shard][index]);
+        if (index + 1 < shard_documents[shard].size()) {
+            heap.emplace_back(shard, index + 1);
+            std::push_heap(heap.begin(), heap.end(), is_ranked_lower);
+        }
+    }
+    return documents;
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <algorithm>
+#include <exception>
+#include <execution>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+#include "document.h"
+#include "query_statistics.h"
+#include "search_server.h"
+#include "shard_process.h"
+
+enum class ShardMode {
+    // Shards are servers of this process, searched on parallel threads
+    THREADS,
+    // Shards are worker processes (see ShardProcess); queries may filter only by status.
+    // They are forked, so they must be started while the process has one thread
+    PROCESSES,
+};
+
+// Search server that spreads documents over several shards, each a SearchServer
+// of its own, by a hash of their ids. A query goes to all shards at once: first
+// for their QueryStatistics, which add up to those of the whole collection, then
+// for their best documents ranked with these statistics. The results are those of
+// a single server holding all documents; the lists of the shards are merged with
+// a k-way heap. Like SearchServer, it must not be changed while it is searched
+class ShardedSearchServer {
+public:
+    // Throws std::invalid_argument if shard_count is zero or the stop words are invalid.
+    // In ShardMode::PROCESSES, throws std::logic_error if the process already has other threads:
+    // start the workers first instead and pass them to the constructor below
+    template <typename StringContainer>
+    ShardedSearchServer(const StringContainer& stop_words, size_t shard_count, ShardMode mode = ShardMode::THREADS);
+
+    ShardedSearchServer(const std::string& stop_words_text, size_t shard_count, ShardMode mode = ShardMode::THREADS);
+    ShardedSearchServer(std::string_view stop_words_text, size_t shard_count, ShardMode mode = ShardMode::THREADS);
+
+    // Serves the shards with workers started beforehand, all with the same stop words and
+    // no documents. Throws std::invalid_argument if there are no workers
+    explicit ShardedSearchServer(std::vector<std::unique_ptr<ShardProcess>> processes);
+
+    ShardedSearchServer(const ShardedSearchServer&) = delete;
+    ShardedSearchServer& operator=(const ShardedSearchServer&) = delete;
+
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+    // Does nothing if there is no document with such id
+    void RemoveDocument(int document_id);
+
+    // Throws std::logic_error for worker processes: a predicate cannot be sent to them
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const;
+
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
+
+    std::tuple<std::vector<std::string>, DocumentStatus> MatchDocument(std::string_view raw_query, int document_id) const;
+
+    int GetDocumentCount() const;
+    size_t GetShardCount() const;
+
+private:
+    const std::vector<std::string> stop_words_;
+    // One of them is filled, depending on the mode
+    std::vector<std::unique_ptr<SearchServer>> servers_;
+    std::vector<std::unique_ptr<ShardProcess>> processes_;
+    // A worker answers requests in order, so queries to the workers take turns
+    mutable std::mutex processes_mutex_;
+
+    size_t GetShard(int document_id) const;
+    void StartShards(size_t shard_count, ShardMode mode);
+
+    // Calls search(server, statistics) for every server in parallel
+    template <typename Search>
+    std::vector<Document> SearchServers(std::string_view raw_query, Search search) const;
+    std::vector<Document> SearchProcesses(std::string_view raw_query, DocumentStatus status) const;
+
+    // Takes the best documents of lists that are sorted best first
+    static std::vector<Document> MergeTopDocuments(const std::vector<std::vector<Document>>& shard_documents);
+};
+
+// Template method implementations
+
+template <typename StringContainer>
+ShardedSearchServer::ShardedSearchServer(const StringContainer& stop_words, size_t shard_count, ShardMode mode)
+    : stop_words_(stop_words.begin(), stop_words.end()) {
+    StartShards(shard_count, mode);
+}
+
+template <typename DocumentPredicate>
+std::vector<Document> ShardedSearchServer::FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const {
+    using namespace std::literals;
+    if (!processes_.empty()) {
+        throw std::logic_error("Shard processes can only filter documents by status"s);
+    }
+    return SearchServers(raw_query, [raw_query, &document_predicate](const SearchServer& server, const QueryStatistics& statistics) {
+        return server.FindTopDocuments(std::execution::seq, raw_query, document_predicate, statistics);
+    });
+}
+
+template <typename Search>
+std::vector<Document> ShardedSearchServer::SearchServers(std::string_view raw_query, Search search) const {
+    // The first shard parses the query alone: an exception thrown inside
+    // a parallel algorithm would terminate the program
+    std::vector<QueryStatistics> shard_statistics(servers_.size());
+    shard_statistics[0] = servers_[0]->GetQueryStatistics(raw_query);
+    std::transform(std::execution::par, servers_.begin() + 1, servers_.end(), shard_statistics.begin() + 1,
+        [raw_query](const std::unique_ptr<SearchServer>& server) {
+            return server->GetQueryStatistics(raw_query);
+        });
+    QueryStatistics statistics;
+    for (const QueryStatistics& statistics_part : shard_statistics) {
+        statistics += statistics_part;
+    }
+
+    std::vector<std::vector<Document>> shard_documents(servers_.size());
+    std::transform(std::execution::par, servers_.begin(), servers_.end(), shard_documents.begin(),
+        [&search, &statistics](const std::unique_ptr<SearchServer>& server) {
+            return search(*server, statistics);
+        });
+    return MergeTopDocuments(shard_documents);
+}
@@ -0,0 +1,59 @@
+#include "snapshot_io.h"
+#include <cstdio>
+#include <stdexcept>
+
+using namespace std::literals;
+
+namespace {
+
+size_t GetPadding(size_t offset) {
+    return (SNAPSHOT_ALIGNMENT - offset % SNAPSHOT_ALIGNMENT) % SNAPSHOT_ALIGNMENT;
+}
+
+}  // namespace
+
+SnapshotWriter::SnapshotWriter(const std::string& path)
+    : path_(path), temporary_path_(path + ".tmp"s), output_(temporary_path_, std::ios::binary | std::ios::trunc) {
+    if (!output_) {
+        throw std::invalid_argument("Cannot create snapshot file "s + temporary_path_);
+    }
+}
+
+SnapshotWriter::~SnapshotWriter() {
+    if (!finished_) {
+        output_.close();
+        std::remove(temporary_path_.c_str());
+    }
+}
+
+void SnapshotWriter::Finish() {
+    finished_ = true;
+    output_.close();
+    if (!output_ || std::rename(temporary_path_.c_str(), path_.c_str()) != 0) {
+        std::remove(temporary_path_.c_str());
+        throw std::invalid_argument("Cannot write snapshot file "s + path_);
+    }
+}
+
+void SnapshotWriter::WriteBytes(const void* data, size_t size) {
+    static const char zeros[SNAPSHOT_ALIGNMENT] = {};
+    output_.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+    output_.write(zeros, static_cast<std::streamsize>(GetPadding(size)));
+}
+
+SnapshotReader::SnapshotReader(const char* data, size_t size)
+    : data_(data), size_(size) {}
+
+const char* SnapshotReader::ReadBytes(size_t size) {
+    const size_t padded_size = size + GetPadding(size);
+    if (padded_size > size_ - offset_) {
+        ThrowTruncated();
+    }
+    const char* bytes = data_ + offset_;
+    offset_ += padded_size;
+    return bytes;
+}
+
+void SnapshotReader::ThrowTruncated() {
+    throw std::invalid_argument("Snapshot is truncated"s);
+}
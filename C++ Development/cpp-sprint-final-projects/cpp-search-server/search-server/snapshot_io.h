@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "mapped_vector.h"
+
+// Every value and array in a snapshot starts at a multiple of SNAPSHOT_ALIGNMENT,
+// so arrays of a mapped snapshot can be used in place. Values are stored
+// in the byte order of the machine that wrote them
+constexpr size_t SNAPSHOT_ALIGNMENT = 8;
+
+// Writes into a temporary file that replaces the target file only in Finish,
+// so the previous snapshot stays intact, even for processes that have it mapped
+class SnapshotWriter {
+public:
+    // Throws std::invalid_argument if the file cannot be created
+    explicit SnapshotWriter(const std::string& path);
+    SnapshotWriter(const SnapshotWriter&) = delete;
+    SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+    // Removes the temporary file unless Finish was called, e.g. when saving threw
+    ~SnapshotWriter();
+
+    template <typename T>
+    void Write(const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        WriteBytes(&value, sizeof(T));
+    }
+
+    // Writes the element count followed by the elements
+    template <typename T>
+    void WriteArray(const T* data, size_t size) {
+        static_assert(std::is_trivially_copyable_v<T> && alignof(T) <= SNAPSHOT_ALIGNMENT);
+        Write(static_cast<uint64_t>(size));
+        WriteBytes(data, size * sizeof(T));
+    }
+
+    template <typename T>
+    void WriteArray(const std::vector<T>& elements) {
+        WriteArray(elements.data(), elements.size());
+    }
+
+    template <typename T>
+    void WriteArray(const MappedVector<T>& elements) {
+        WriteArray(elements.data(), elements.size());
+    }
+
+    // Throws std::invalid_argument if writing failed
+    void Finish();
+
+private:
+    std::string path_;
+    std::string temporary_path_;
+    std::ofstream output_;
+    bool finished_ = false;
+
+    void WriteBytes(const void* data, size_t size);
+};
+
+// Elements whose bytes are all zero, padding included. Types with padding are written
+// through such an array with their members set one by one, so that the padding
+// stays zero instead of carrying uninitialized memory into the file
+template <typename T>
+std::vector<T> MakeZeroedArray(size_t size) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    std::vector<T> elements(size);
+    std::memset(static_cast<void*>(elements.data()), 0, size * sizeof(T));
+    return elements;
+}
+
+// Reads a snapshot written by SnapshotWriter from memory, usually a mapped file
+class SnapshotReader {
+public:
+    // The data must be aligned to SNAPSHOT_ALIGNMENT
+    SnapshotReader(const char* data, size_t size);
+
+    template <typename T>
+    T Read() {
+        static_assert(std::is_trivially_copyable_v<T>);
+        T value;
+        std::memcpy(&value, ReadBytes(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    // The returned vector refers to the snapshot memory without copying it
+    template <typename T>
+    MappedVector<T> ReadArray() {
+        static_assert(std::is_trivially_copyable_v<T> && alignof(T) <= SNAPSHOT_ALIGNMENT);
+        const auto size = Read<uint64_t>();
+        if (size > (size_ - offset_) / sizeof(T)) {
+            ThrowTruncated();
+        }
+        const auto* data = reinterpret_cast<const T*>(ReadBytes(size * sizeof(T)));
+        return MappedVector<T>::View(data, size);
+    }
+
+private:
+    const char* data_;
+    size_t size_;
+    size_t offset_ = 0;
+
+    // Throws std::invalid_argument if the snapshot ends earlier
+    const char* ReadBytes(size_t size);
+    [[noreturn]] static void ThrowTruncated();
+};
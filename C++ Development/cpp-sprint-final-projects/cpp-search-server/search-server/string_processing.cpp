@@ -1,21 +1,183 @@
 #include "string_processing.h"
+#include <stdexcept>
 
-std::vector<std::string> SplitIntoWords(const std::string& text) {
-    std::vector<std::string> words;
-    std::string word;
-    for (const char c : text) {
-        if (c == ' ') {
-            if (!word.empty()) {
-                words.push_back(word);
-                word.clear();
-            }
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SEARCH_SERVER_X86_TOKENIZER
+#include <immintrin.h>
+#endif
+
+using namespace std::literals;
+
+namespace {
+
+// Keeps the word being read between blocks of bytes
+class WordCollector {
+public:
+    WordCollector(std::string_view text, std::vector<std::string_view>& words)
+        : text_(text), words_(words) {}
+
+    bool IsInWord() const {
+        return in_word_;
+    }
+
+    // Called at every offset where a word starts or ends
+    void Toggle(size_t offset) {
+        if (in_word_) {
+            words_.push_back(text_.substr(word_begin_, offset - word_begin_));
         } else {
-            word += c;
+            word_begin_ = offset;
+        }
+        in_word_ = !in_word_;
+    }
+
+    void Finish() {
+        if (in_word_) {
+            Toggle(text_.size());
         }
     }
-    if (!word.empty()) {
-        words.push_back(word);
+
+private:
+    std::string_view text_;
+    std::vector<std::string_view>& words_;
+    bool in_word_ = false;
+    size_t word_begin_ = 0;
+};
+
+bool IsControlCharacter(char c) {
+    return static_cast<unsigned char>(c) < 0x20;
+}
+
+// Reads text[begin, end) one byte at a time: the whole text of the scalar version,
+// and the bytes after the last full block of the vector ones
+void TokenizeBytes(std::string_view text, size_t begin, WordCollector& collector, size_t& control_offset) {
+    for (size_t i = begin; i < text.size(); ++i) {
+        if ((text[i] != ' ') != collector.IsInWord()) {
+            collector.Toggle(i);
+        }
+        if (control_offset == std::string_view::npos && IsControlCharacter(text[i])) {
+            control_offset = i;
+        }
     }
+}
 
+size_t TokenizeScalar(std::string_view text, std::vector<std::string_view>& words) {
+    WordCollector collector(text, words);
+    size_t control_offset = std::string_view::npos;
+    TokenizeBytes(text, 0, collector, control_offset);
+    collector.Finish();
+    return control_offset;
+}
+
+#ifdef SEARCH_SERVER_X86_TOKENIZER
+
+// Takes the masks of a block: bit i is set if byte i is not a space, or if it is a
+// control character. A word starts or ends wherever a bit differs from the one before it
+template <typename Mask>
+void CollectBlock(size_t block_begin, Mask non_space_mask, Mask control_mask, WordCollector& collector, size_t& control_offset) {
+    const Mask previous_bits = static_cast<Mask>(non_space_mask << 1) | static_cast<Mask>(collector.IsInWord() ? 1 : 0);
+    Mask boundaries = non_space_mask ^ previous_bits;
+    while (boundaries != 0) {
+        collector.Toggle(block_begin + __builtin_ctzll(boundaries));
+        boundaries &= boundaries - 1;
+    }
+    if (control_mask != 0 && control_offset == std::string_view::npos) {
+        control_offset = block_begin + __builtin_ctzll(control_mask);
+    }
+}
+
+__attribute__((target("sse2")))
+size_t TokenizeSse2(std::string_view text, std::vector<std::string_view>& words) {
+    constexpr size_t BLOCK_SIZE = 16;
+    WordCollector collector(text, words);
+    size_t control_offset = std::string_view::npos;
+    const __m128i spaces = _mm_set1_epi8(' ');
+    const __m128i last_control = _mm_set1_epi8(0x1F);
+    size_t i = 0;
+    for (; i + BLOCK_SIZE <= text.size(); i += BLOCK_SIZE) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + i));
+        const auto space_mask = static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, spaces)));
+        // A byte is at most 0x1F exactly when the unsigned minimum of the two is the byte itself
+        const auto control_mask = static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(bytes, last_control), bytes)));
+        CollectBlock<uint16_t>(i, static_cast<uint16_t>(~space_mask), control_mask, collector, control_offset);
+    }
+    TokenizeBytes(text, i, collector, control_offset);
+    collector.Finish();
+    return control_offset;
+}
+
+__attribute__((target("avx2")))
+size_t TokenizeAvx2(std::string_view text, std::vector<std::string_view>& words) {
+    constexpr size_t BLOCK_SIZE = 32;
+    WordCollector collector(text, words);
+    size_t control_offset = std::string_view::npos;
+    const __m256i spaces = _mm256_set1_epi8(' ');
+    const __m256i last_control = _mm256_set1_epi8(0x1F);
+    size_t i = 0;
+    for (; i + BLOCK_SIZE <= text.size(); i += BLOCK_SIZE) {
+        const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text.data() + i));
+        const auto space_mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, spaces)));
+        const auto control_mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(bytes, last_control), bytes)));
+        CollectBlock<uint32_t>(i, ~space_mask, control_mask, collector, control_offset);
+    }
+    TokenizeBytes(text, i, collector, control_offset);
+    collector.Finish();
+    return control_offset;
+}
+
+#endif
+
+TokenizerIsa DetectTokenizerIsa() {
+#ifdef SEARCH_SERVER_X86_TOKENIZER
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return TokenizerIsa::AVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return TokenizerIsa::SSE2;
+    }
+#endif
+    return TokenizerIsa::SCALAR;
+}
+
+}  // namespace
+
+std::vector<std::string_view> SplitIntoWords(std::string_view text) {
+    std::vector<std::string_view> words;
+    TokenizeWords(text, words);
     return words;
-}
\ No newline at end of file
+}
+
+TokenizerIsa GetTokenizerIsa() {
+    static const TokenizerIsa isa = DetectTokenizerIsa();
+    return isa;
+}
+
+bool IsTokenizerIsaSupported(TokenizerIsa isa) {
+    return isa <= GetTokenizerIsa();
+}
+
+size_t TokenizeWords(std::string_view text, std::vector<std::string_view>& words) {
+    return TokenizeWords(text, words, GetTokenizerIsa());
+}
+
+size_t TokenizeWords(std::string_view text, std::vector<std::string_view>& words, TokenizerIsa isa) {
+    switch (isa) {
+#ifdef SEARCH_SERVER_X86_TOKENIZER
+    case TokenizerIsa::AVX2:
+        if (IsTokenizerIsaSupported(isa)) {
+            return TokenizeAvx2(text, words);
+        }
+        break;
+    case TokenizerIsa::SSE2:
+        if (IsTokenizerIsaSupported(isa)) {
+            return TokenizeSse2(text, words);
+        }
+        break;
+#endif
+    case TokenizerIsa::SCALAR:
+        return TokenizeScalar(text, words);
+    default:
+        break;
+    }
+    throw std::invalid_argument("The CPU does not support this instruction set"s);
+}
@@ -1,19 +1,40 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <set>
 
-// Function to split text into words
-std::vector<std::string> SplitIntoWords(const std::string& text);
+// Function to split text into words. The words point into the text
+std::vector<std::string_view> SplitIntoWords(std::string_view text);
+
+// Instruction sets TokenizeWords can scan text with
+enum class TokenizerIsa {
+    SCALAR,
+    SSE2,
+    AVX2,
+};
+
+// The widest instruction set the CPU supports, detected on the first call
+TokenizerIsa GetTokenizerIsa();
+bool IsTokenizerIsaSupported(TokenizerIsa isa);
+
+// Splits text into words at spaces, appending them to words, and finds control characters
+// (bytes below 0x20) in the same pass. Returns the offset of the first of them in the text,
+// or std::string_view::npos if there is none. The words point into the text. Compares 16 or
+// 32 bytes at a time and collects the results as bit masks with SSE2 or AVX2; the overload
+// without an instruction set uses GetTokenizerIsa. Throws std::invalid_argument if the CPU
+// does not support the instruction set
+size_t TokenizeWords(std::string_view text, std::vector<std::string_view>& words);
+size_t TokenizeWords(std::string_view text, std::vector<std::string_view>& words, TokenizerIsa isa);
 
 // Full definition of the template function
 template <typename StringContainer>
-std::set<std::string> MakeUniqueNonEmptyStrings(const StringContainer& strings) {
-    std::set<std::string> non_empty_strings;
-    for (const std::string& str : strings) {
+std::set<std::string, std::less<>> MakeUniqueNonEmptyStrings(const StringContainer& strings) {
+    std::set<std::string, std::less<>> non_empty_strings;
+    for (const auto& str : strings) {
         if (!str.empty()) {
-            non_empty_strings.insert(str);
+            non_empty_strings.emplace(str);
         }
     }
     return non_empty_strings;
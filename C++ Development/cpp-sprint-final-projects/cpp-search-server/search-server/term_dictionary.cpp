@@ -0,0 +1,276 @@
+#include "term_dictionary.h"
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+using namespace std::literals;
+
+namespace {
+
+using TermId = TermDictionary::TermId;
+
+// The other parts of the dictionary walked like FrontCodedTerms::Cursor
+
+class SortedIdsCursor {
+public:
+    SortedIdsCursor(const TermDictionary& dictionary, const MappedVector<TermId>& sorted_ids)
+        : dictionary_(dictionary),
+          it_(sorted_ids.begin()),
+          end_(sorted_ids.end()) {}
+
+    bool IsValid() const {
+        return it_ != end_;
+    }
+    std::string_view GetTerm() const {
+        return dictionary_.GetTerm(*it_);
+    }
+    TermId GetTermId() const {
+        return *it_;
+    }
+    void Next() {
+        ++it_;
+    }
+    void SkipTo(std::string_view target) {
+        it_ = std::lower_bound(it_, end_, target, [this](TermId term_id, std::string_view target) {
+            return dictionary_.GetTerm(term_id) < target;
+        });
+    }
+
+private:
+    const TermDictionary& dictionary_;
+    const TermId* it_;
+    const TermId* end_;
+};
+
+class SortedMapCursor {
+public:
+    explicit SortedMapCursor(const std::map<std::string_view, TermId>& terms)
+        : terms_(terms),
+          it_(terms.begin()) {}
+
+    bool IsValid() const {
+        return it_ != terms_.end();
+    }
+    std::string_view GetTerm() const {
+        return it_->first;
+    }
+    TermId GetTermId() const {
+        return it_->second;
+    }
+    void Next() {
+        ++it_;
+    }
+    void SkipTo(std::string_view target) {
+        if (IsValid() && it_->first < target) {
+            it_ = terms_.lower_bound(target);
+        }
+    }
+
+private:
+    const std::map<std::string_view, TermId>& terms_;
+    std::map<std::string_view, TermId>::const_iterator it_;
+};
+
+template <typename Cursor>
+void FindPrefixIn(Cursor cursor, std::string_view prefix, std::vector<TermId>& term_ids) {
+    for (cursor.SkipTo(prefix); cursor.IsValid() && cursor.GetTerm().substr(0, prefix.size()) == prefix; cursor.Next()) {
+        term_ids.push_back(cursor.GetTermId());
+    }
+}
+
+template <typename Cursor>
+void FindNearIn(Cursor cursor, const LevenshteinAutomaton& automaton, std::vector<std::pair<TermId, int>>& terms) {
+    // states[i] is the state after the first i characters of read_prefix;
+    // states past them are kept only to reuse their memory
+    std::vector<LevenshteinAutomaton::State> states{automaton.Start()};
+    std::string read_prefix;
+    while (cursor.IsValid()) {
+        const std::string_view term = cursor.GetTerm();
+        size_t length = 0;
+        while (length < read_prefix.size() && length < term.size() && read_prefix[length] == term[length]) {
+            ++length;
+        }
+        read_prefix.resize(length);
+        bool can_match = true;
+        for (; can_match && length < term.size(); ++length) {
+            if (states.size() < length + 2) {
+                states.emplace_back();
+            }
+            automaton.Step(states[length], term[length], states[length + 1]);
+            read_prefix.push_back(term[length]);
+            can_match = automaton.CanMatch(states[length + 1]);
+        }
+        if (can_match) {
+            if (automaton.IsMatch(states[length])) {
+                terms.emplace_back(cursor.GetTermId(), automaton.GetDistance(states[length]));
+            }
+            cursor.Next();
+            continue;
+        }
+
+        // No term starting with read_prefix can match. The next term that may starts with
+        // the longest prefix of it followed by a greater character that keeps a match possible
+        std::optional<char> next_char;
+        while (!read_prefix.empty()) {
+            const char last_char = read_prefix.back();
+            read_prefix.pop_back();
+            next_char = automaton.FindNextChar(states[read_prefix.size()], last_char);
+            if (next_char) {
+                break;
+            }
+        }
+        if (!next_char) {
+            return;
+        }
+        read_prefix.push_back(*next_char);
+        cursor.SkipTo(read_prefix);
+        // The state for the new character is not computed yet
+        read_prefix.pop_back();
+    }
+}
+
+}  // namespace
+
+TermDictionary::TermDictionary(const TermDictionary& other)
+    : snapshot_chars_(other.snapshot_chars_),
+      snapshot_term_offsets_(other.snapshot_term_offsets_),
+      snapshot_sorted_ids_(other.snapshot_sorted_ids_),
+      terms_(other.terms_),
+      sorted_terms_(other.sorted_terms_) {
+    const TermId snapshot_size = GetSnapshotSize();
+    term_ids_.reserve(terms_.size());
+    for (size_t i = 0; i < terms_.size(); ++i) {
+        term_ids_.emplace(terms_[i], static_cast<TermId>(snapshot_size + i));
+    }
+    for (size_t i = terms_.size() - other.recent_terms_.size(); i < terms_.size(); ++i) {
+        recent_terms_.emplace(terms_[i], static_cast<TermId>(snapshot_size + i));
+    }
+}
+
+TermDictionary& TermDictionary::operator=(const TermDictionary& other) {
+    if (this != &other) {
+        TermDictionary copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+TermDictionary::TermId TermDictionary::Intern(std::string_view word) {
+    if (const auto term_id = Find(word)) {
+        return *term_id;
+    }
+    const auto term_id = static_cast<TermId>(GetSize());
+    terms_.emplace_back(word);
+    term_ids_.emplace(terms_.back(), term_id);
+    recent_terms_.emplace(terms_.back(), term_id);
+    // Re-encoding takes time linear in the sorted terms, so it is done only after
+    // a fixed share of them has been added
+    if (recent_terms_.size() > std::max(MIN_RECENT_TERM_COUNT, sorted_terms_.GetSize() / 8)) {
+        SortRecentTerms();
+    }
+    return term_id;
+}
+
+std::optional<TermDictionary::TermId> TermDictionary::Find(std::string_view word) const {
+    if (const auto term_id = FindInSnapshot(word)) {
+        return term_id;
+    }
+    const auto it = term_ids_.find(word);
+    if (it == term_ids_.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+std::string_view TermDictionary::GetTerm(TermId term_id) const {
+    const TermId snapshot_size = GetSnapshotSize();
+    if (term_id < snapshot_size) {
+        const uint32_t begin = snapshot_term_offsets_[term_id];
+        return {snapshot_chars_.data() + begin, snapshot_term_offsets_[term_id + 1] - begin};
+    }
+    return terms_.at(term_id - snapshot_size);
+}
+
+std::vector<TermDictionary::TermId> TermDictionary::FindPrefix(std::string_view prefix) const {
+    std::vector<TermId> term_ids;
+    FindPrefixIn(SortedIdsCursor(*this, snapshot_sorted_ids_), prefix, term_ids);
+    FindPrefixIn(sorted_terms_.GetCursor(), prefix, term_ids);
+    FindPrefixIn(SortedMapCursor(recent_terms_), prefix, term_ids);
+    return term_ids;
+}
+
+std::vector<std::pair<TermDictionary::TermId, int>> TermDictionary::FindNear(const LevenshteinAutomaton& automaton) const {
+    std::vector<std::pair<TermId, int>> terms;
+    FindNearIn(SortedIdsCursor(*this, snapshot_sorted_ids_), automaton, terms);
+    FindNearIn(sorted_terms_.GetCursor(), automaton, terms);
+    FindNearIn(SortedMapCursor(recent_terms_), automaton, terms);
+    return terms;
+}
+
+size_t TermDictionary::GetSize() const {
+    return GetSnapshotSize() + terms_.size();
+}
+
+void TermDictionary::Save(SnapshotWriter& writer) const {
+    const auto size = static_cast<TermId>(GetSize());
+    std::string chars;
+    std::vector<uint32_t> term_offsets;
+    term_offsets.reserve(size + 1);
+    std::vector<TermId> sorted_ids(size);
+    for (TermId term_id = 0; term_id < size; ++term_id) {
+        term_offsets.push_back(static_cast<uint32_t>(chars.size()));
+        chars += GetTerm(term_id);
+        sorted_ids[term_id] = term_id;
+    }
+    term_offsets.push_back(static_cast<uint32_t>(chars.size()));
+    std::sort(sorted_ids.begin(), sorted_ids.end(), [this](TermId lhs, TermId rhs) {
+        return GetTerm(lhs) < GetTerm(rhs);
+    });
+    writer.WriteArray(chars.data(), chars.size());
+    writer.WriteArray(term_offsets);
+    writer.WriteArray(sorted_ids);
+}
+
+TermDictionary TermDictionary::Load(SnapshotReader& reader) {
+    TermDictionary dictionary;
+    dictionary.snapshot_chars_ = reader.ReadArray<char>();
+    dictionary.snapshot_term_offsets_ = reader.ReadArray<uint32_t>();
+    dictionary.snapshot_sorted_ids_ = reader.ReadArray<TermId>();
+    const auto& offsets = dictionary.snapshot_term_offsets_;
+    if (offsets.empty() || dictionary.snapshot_sorted_ids_.size() != offsets.size() - 1
+        || offsets.back() != dictionary.snapshot_chars_.size()) {
+        throw std::invalid_argument("Snapshot term dictionary is corrupted"s);
+    }
+    return dictionary;
+}
+
+TermDictionary::TermId TermDictionary::GetSnapshotSize() const {
+    return snapshot_term_offsets_.empty() ? 0 : static_cast<TermId>(snapshot_term_offsets_.size() - 1);
+}
+
+void TermDictionary::SortRecentTerms() {
+    // The decoded terms are temporary, so the merged ones point into terms_
+    std::vector<std::pair<std::string_view, TermId>> merged_terms;
+    merged_terms.reserve(sorted_terms_.GetSize() + recent_terms_.size());
+    auto recent_term = recent_terms_.begin();
+    sorted_terms_.ForEach([&](std::string_view term, TermId term_id) {
+        for (; recent_term != recent_terms_.end() && recent_term->first < term; ++recent_term) {
+            merged_terms.push_back(*recent_term);
+        }
+        merged_terms.emplace_back(GetTerm(term_id), term_id);
+    });
+    merged_terms.insert(merged_terms.end(), recent_term, recent_terms_.end());
+    sorted_terms_ = FrontCodedTerms(merged_terms);
+    recent_terms_.clear();
+}
+
+std::optional<TermDictionary::TermId> TermDictionary::FindInSnapshot(std::string_view word) const {
+    const auto it = std::lower_bound(snapshot_sorted_ids_.begin(), snapshot_sorted_ids_.end(), word,
+        [this](TermId term_id, std::string_view word) {
+            return GetTerm(term_id) < word;
+        });
+    if (it == snapshot_sorted_ids_.end() || GetTerm(*it) != word) {
+        return std::nullopt;
+    }
+    return *it;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "front_coded_terms.h"
+#include "levenshtein_automaton.h"
+#include "mapped_vector.h"
+#include "snapshot_io.h"
+
+// Interns words into dense ids: ids are assigned in order of first appearance
+// and index the stored strings directly.
+// A dictionary loaded from a snapshot looks its terms up in place, by binary
+// search over the term ids sorted by term; words added later are kept as usual.
+// For prefix and fuzzy search the words added later are also kept front-coded
+// in sorted order; the newest of them wait in a small map until it is worth
+// re-encoding
+class TermDictionary {
+public:
+    using TermId = uint32_t;
+
+    TermDictionary() = default;
+    TermDictionary(const TermDictionary& other);
+    TermDictionary(TermDictionary&& other) = default;
+    TermDictionary& operator=(const TermDictionary& other);
+    TermDictionary& operator=(TermDictionary&& other) = default;
+
+    // Returns the id of the word, adding it to the dictionary if it is new
+    TermId Intern(std::string_view word);
+    std::optional<TermId> Find(std::string_view word) const;
+    std::string_view GetTerm(TermId term_id) const;
+    // Ids of the terms starting with the prefix, in no particular order
+    std::vector<TermId> FindPrefix(std::string_view prefix) const;
+    // Ids of the terms the automaton accepts with their edit distances, in no particular order.
+    // Only the terms sharing a prefix the automaton can still match are read
+    std::vector<std::pair<TermId, int>> FindNear(const LevenshteinAutomaton& automaton) const;
+    size_t GetSize() const;
+
+    void Save(SnapshotWriter& writer) const;
+    static TermDictionary Load(SnapshotReader& reader);
+
+private:
+    // Terms loaded from a snapshot take the ids below snapshot_term_offsets_.size() - 1.
+    // Term i spans characters [offsets[i], offsets[i + 1])
+    MappedVector<char> snapshot_chars_;
+    MappedVector<uint32_t> snapshot_term_offsets_;
+    MappedVector<TermId> snapshot_sorted_ids_;
+    // Deque keeps the strings in place, so the views used as keys stay valid
+    std::deque<std::string> terms_;
+    std::unordered_map<std::string_view, TermId> term_ids_;
+    // Every term of terms_ is either in sorted_terms_ or in recent_terms_;
+    // the recent ones are the last added
+    FrontCodedTerms sorted_terms_;
+    std::map<std::string_view, TermId> recent_terms_;
+
+    static constexpr size_t MIN_RECENT_TERM_COUNT = 1024;
+
+    TermId GetSnapshotSize() const;
+    std::optional<TermId> FindInSnapshot(std::string_view word) const;
+    // Moves the recent terms into sorted_terms_
+    void SortRecentTerms();
+};
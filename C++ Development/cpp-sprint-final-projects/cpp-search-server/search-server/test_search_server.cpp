@@ -0,0 +1,1676 @@
+#include "test_search_server.h"
+#include "../benchmarks/corpus_generator.h"
+#include "concurrent_search_server.h"
+#include "document_bitmap.h"
+#include "process_queries.h"
+#include "relevance_accumulator.h"
+#include "remove_duplicates.h"
+#include "request_queue.h"
+#include "search_server.h"
+#include "segmented_search_server.h"
+#include "shard_process.h"
+#include "sharded_search_server.h"
+#include <cassert>
+#include <cmath>
+#include <execution>
+#include <filesystem>
+#include <fstream>
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <iterator>
+#include <functional>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <set>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+void AssertSameDocuments(const vector<Document>& documents, const vector<Document>& expected) {
+    assert(documents.size() == expected.size());
+    for (size_t i = 0; i < documents.size(); ++i) {
+        assert(documents[i].id == expected[i].id);
+        assert(abs(documents[i].relevance - expected[i].relevance) < RELEVANCE_EPSILON);
+        assert(documents[i].rating == expected[i].rating);
+    }
+}
+
+// Frequencies collected from compressed posting lists are rounded to float
+void AssertSameWordFrequencies(const map<string_view, double>& word_freqs, const map<string_view, double>& expected) {
+    assert(equal(word_freqs.begin(), word_freqs.end(), expected.begin(), expected.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.first == rhs.first && abs(lhs.second - rhs.second) < RELEVANCE_EPSILON;
+    }));
+}
+
+const vector<string> TEST_DOCUMENTS = {
+    "funny pet and nasty rat"s,
+    "funny pet with curly hair"s,
+    "funny pet and not very nasty rat"s,
+    "pet with rat and rat and rat"s,
+    "nasty rat with curly hair"s,
+    "big cat nasty hair"s,
+    "big dog cat Vladislav"s,
+    "big dog hamster Borya"s,
+};
+
+const vector<string> TEST_QUERIES = {
+    "curly dog"s,
+    "nasty rat -not"s,
+    "funny pet -curly"s,
+    "big cat hair"s,
+    "rat"s,
+    "unknown words"s,
+};
+
+// Adds the test documents with ids 1, 2, ..., every fourth of them BANNED
+void AddTestDocuments(SearchServer& search_server) {
+    for (size_t i = 0; i < TEST_DOCUMENTS.size(); ++i) {
+        const int id = static_cast<int>(i) + 1;
+        search_server.AddDocument(id, TEST_DOCUMENTS[i], i % 4 == 3 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL, {id, id % 3});
+    }
+}
+
+struct TestDocument {
+    string text;
+    DocumentStatus status;
+    vector<int> ratings;
+};
+
+// Documents of random words of a small vocabulary, so that queries find many of them
+struct TestCorpus {
+    vector<string> stop_words;
+    map<int, TestDocument> documents;
+};
+
+const vector<string> RANDOM_WORDS = {
+    "cat"s, "cats"s, "catalog"s, "cart"s, "cut"s, "dog"s, "dig"s, "dogma"s, "rat"s, "rate"s,
+    "hair"s, "hail"s, "pet"s, "pets"s, "petal"s, "big"s, "bog"s, "and"s, "with"s, "in"s,
+};
+
+string DrawRandomWords(mt19937& generator, int min_count, int max_count) {
+    string text;
+    const int count = uniform_int_distribution<int>(min_count, max_count)(generator);
+    for (int i = 0; i < count; ++i) {
+        // Lower ranks are drawn more often, as in real text
+        const size_t rank = min(uniform_int_distribution<size_t>(0, RANDOM_WORDS.size() - 1)(generator),
+                                uniform_int_distribution<size_t>(0, RANDOM_WORDS.size() - 1)(generator));
+        text += (i > 0 ? " "s : ""s) + RANDOM_WORDS[rank];
+    }
+    return text;
+}
+
+TestCorpus MakeRandomCorpus(int document_count, uint32_t seed) {
+    mt19937 generator(seed);
+    TestCorpus corpus;
+    corpus.stop_words = {"and"s, "with"s, "in"s};
+    for (int id = 0; id < document_count; ++id) {
+        const auto status = static_cast<DocumentStatus>(uniform_int_distribution<int>(0, 3)(generator));
+        vector<int> ratings(uniform_int_distribution<int>(0, 3)(generator));
+        for (int& rating : ratings) {
+            rating = uniform_int_distribution<int>(-5, 10)(generator);
+        }
+        // Ids leave gaps, as after removals
+        corpus.documents[id * 3 + 1] = {DrawRandomWords(generator, 1, 12), status, ratings};
+    }
+    return corpus;
+}
+
+// Queries of two to four words, one of them a minus word in every third query
+vector<string> MakeRandomQueries(int query_count, uint32_t seed) {
+    mt19937 generator(seed);
+    vector<string> queries;
+    for (int i = 0; i < query_count; ++i) {
+        string query = DrawRandomWords(generator, 2, 4);
+        if (i % 3 == 0) {
+            query += " -"s + DrawRandomWords(generator, 1, 1);
+        }
+        queries.push_back(query);
+    }
+    return queries;
+}
+
+template <typename Server>
+void AddCorpus(Server& search_server, const TestCorpus& corpus) {
+    for (const auto& [id, document] : corpus.documents) {
+        search_server.AddDocument(id, document.text, document.status, document.ratings);
+    }
+}
+
+// Ranks the documents of a corpus by TF-IDF directly from their texts
+class ReferenceRanking {
+public:
+    explicit ReferenceRanking(const TestCorpus& corpus)
+        : stop_words_(corpus.stop_words.begin(), corpus.stop_words.end()) {
+        for (const auto& [id, document] : corpus.documents) {
+            vector<string> words;
+            for (const string_view word : SplitIntoWords(document.text)) {
+                if (stop_words_.count(word) == 0) {
+                    words.emplace_back(word);
+                }
+            }
+            DocumentData& data = documents_[id];
+            for (const string& word : words) {
+                data.term_freqs[word] += 1.0 / words.size();
+            }
+            for (const auto& [word, _] : data.term_freqs) {
+                ++document_freqs_[word];
+            }
+            data.status = document.status;
+            data.rating = document.ratings.empty() ? 0 : accumulate(document.ratings.begin(), document.ratings.end(), 0) / static_cast<int>(document.ratings.size());
+        }
+    }
+
+    vector<Document> FindTopDocuments(string_view raw_query, const function<bool(int, DocumentStatus, int)>& document_predicate,
+                                      size_t document_count = MAX_RESULT_DOCUMENT_COUNT) const {
+        const auto [plus_words, minus_words] = ParseQuery(raw_query);
+        vector<pair<WordWeights, double>> plus_word_idfs;
+        for (const string& word : plus_words) {
+            WordWeights word_weights = ExpandWord(word);
+            const auto document_freq = count_if(documents_.begin(), documents_.end(), [&word_weights](const auto& document) {
+                return GetTermFreq(document.second.term_freqs, word_weights) > 0.0;
+            });
+            const double idf = document_freq == 0 ? 0.0 : log(documents_.size() * 1.0 / document_freq);
+            plus_word_idfs.emplace_back(move(word_weights), idf);
+        }
+        const vector<WordWeights> minus_word_weights = ExpandWords(minus_words);
+
+        vector<Document> documents;
+        for (const auto& [id, data] : documents_) {
+            const auto& term_freqs = data.term_freqs;
+            if (ContainsAny(term_freqs, minus_word_weights)) {
+                continue;
+            }
+            double relevance = 0.0;
+            bool is_found = false;
+            for (const auto& [word_weights, idf] : plus_word_idfs) {
+                if (const double term_freq = GetTermFreq(term_freqs, word_weights); term_freq > 0.0) {
+                    relevance += term_freq * idf;
+                    is_found = true;
+                }
+            }
+            if (is_found && document_predicate(id, data.status, data.rating)) {
+                documents.push_back({id, relevance, data.rating});
+            }
+        }
+        sort(documents.begin(), documents.end(), IsRankedHigher);
+        documents.resize(min(documents.size(), document_count));
+        return documents;
+    }
+
+    vector<Document> FindTopDocuments(string_view raw_query, DocumentStatus status = DocumentStatus::ACTUAL) const {
+        return FindTopDocuments(raw_query, [status](int, DocumentStatus document_status, int) {
+            return document_status == status;
+        });
+    }
+
+    // All documents found, however many
+    vector<Document> FindAllDocuments(string_view raw_query, DocumentStatus status) const {
+        return FindTopDocuments(raw_query, [status](int, DocumentStatus document_status, int) {
+            return document_status == status;
+        }, documents_.size());
+    }
+
+    // The words of the document that the plus words of the query expand to, or none if a minus word is found
+    vector<string> MatchDocument(string_view raw_query, int document_id) const {
+        const auto [plus_words, minus_words] = ParseQuery(raw_query);
+        const auto& term_freqs = documents_.at(document_id).term_freqs;
+        set<string> words;
+        if (ContainsAny(term_freqs, ExpandWords(minus_words))) {
+            return {};
+        }
+        for (const WordWeights& word_weights : ExpandWords(plus_words)) {
+            for (const auto& [word, _] : word_weights) {
+                if (term_freqs.count(word) > 0) {
+                    words.insert(word);
+                }
+            }
+        }
+        return {words.begin(), words.end()};
+    }
+
+private:
+    // The words a query word matches, with the weights of their term frequencies
+    using WordWeights = map<string, double>;
+
+    struct DocumentData {
+        map<string, double> term_freqs;
+        DocumentStatus status;
+        int rating;
+    };
+
+    // Plus and minus words, without stop words
+    pair<set<string>, set<string>> ParseQuery(string_view raw_query) const {
+        set<string> plus_words;
+        set<string> minus_words;
+        for (const string_view word : SplitIntoWords(raw_query)) {
+            const bool is_minus = word[0] == '-';
+            const string data(is_minus ? word.substr(1) : word);
+            if (stop_words_.count(data) == 0) {
+                (is_minus ? minus_words : plus_words).insert(data);
+            }
+        }
+        return {plus_words, minus_words};
+    }
+
+    // A word ending with '*' matches every word of the corpus starting with the rest of it,
+    // and a word ending with '~' and a distance every word within that many edits, weighted
+    // by one over one plus the edits
+    WordWeights ExpandWord(const string& word) const {
+        const size_t tilde = word.rfind('~');
+        if (tilde != string::npos && tilde > 0 && tilde + 2 == word.size() && word.back() > '0' && word.back() <= '9') {
+            const string fuzzy_word = word.substr(0, tilde);
+            WordWeights word_weights;
+            for (const auto& [corpus_word, _] : document_freqs_) {
+                if (const int distance = GetEditDistance(fuzzy_word, corpus_word); distance <= word.back() - '0') {
+                    word_weights[corpus_word] = 1.0 / (1 + distance);
+                }
+            }
+            return word_weights;
+        }
+        if (word.back() != '*') {
+            return {{word, 1.0}};
+        }
+        const string prefix = word.substr(0, word.size() - 1);
+        WordWeights word_weights;
+        for (const auto& [corpus_word, _] : document_freqs_) {
+            if (corpus_word.compare(0, prefix.size(), prefix) == 0) {
+                word_weights[corpus_word] = 1.0;
+            }
+        }
+        return word_weights;
+    }
+
+    static int GetEditDistance(const string& lhs, const string& rhs) {
+        vector<int> distances(rhs.size() + 1);
+        iota(distances.begin(), distances.end(), 0);
+        for (size_t i = 1; i <= lhs.size(); ++i) {
+            int diagonal = distances[0];
+            distances[0] = static_cast<int>(i);
+            for (size_t j = 1; j <= rhs.size(); ++j) {
+                const int above = distances[j];
+                distances[j] = min({above + 1, distances[j - 1] + 1, diagonal + (lhs[i - 1] != rhs[j - 1])});
+                diagonal = above;
+            }
+        }
+        return distances.back();
+    }
+
+    vector<WordWeights> ExpandWords(const set<string>& words) const {
+        vector<WordWeights> expanded_words;
+        for (const string& word : words) {
+            expanded_words.push_back(ExpandWord(word));
+        }
+        return expanded_words;
+    }
+
+    static double GetTermFreq(const map<string, double>& term_freqs, const WordWeights& word_weights) {
+        double term_freq = 0.0;
+        for (const auto& [word, weight] : word_weights) {
+            if (const auto it = term_freqs.find(word); it != term_freqs.end()) {
+                term_freq += it->second * weight;
+            }
+        }
+        return term_freq;
+    }
+
+    static bool ContainsAny(const map<string, double>& term_freqs, const vector<WordWeights>& expanded_words) {
+        return any_of(expanded_words.begin(), expanded_words.end(), [&term_freqs](const WordWeights& word_weights) {
+            return GetTermFreq(term_freqs, word_weights) > 0.0;
+        });
+    }
+
+    set<string, less<>> stop_words_;
+    map<int, DocumentData> documents_;
+    map<string, int> document_freqs_;
+};
+
+void TestExecutionPolicies() {
+    SearchServer search_server("and with"s);
+    AddTestDocuments(search_server);
+    for (const string& query : TEST_QUERIES) {
+        const auto documents = search_server.FindTopDocuments(query);
+        AssertSameDocuments(search_server.FindTopDocuments(execution::seq, query), documents);
+        AssertSameDocuments(search_server.FindTopDocuments(execution::par, query), documents);
+        AssertSameDocuments(search_server.FindTopDocuments(execution::par, query, DocumentStatus::BANNED),
+                            search_server.FindTopDocuments(query, DocumentStatus::BANNED));
+        const auto even_ids = [](int document_id, DocumentStatus, int) {
+            return document_id % 2 == 0;
+        };
+        AssertSameDocuments(search_server.FindTopDocuments(execution::par, query, even_ids),
+                            search_server.FindTopDocuments(query, even_ids));
+    }
+
+    // Both words are in 2 of the 8 documents, and make a quarter of each ACTUAL one;
+    // equal relevances are ranked by rating
+    const auto documents = search_server.FindTopDocuments(execution::par, "curly dog"s);
+    assert(documents.size() == 3);
+    assert(documents[0].id == 7 && documents[1].id == 5 && documents[2].id == 2);
+    assert(abs(documents[0].relevance - log(8.0 / 2) / 4) < RELEVANCE_EPSILON);
+}
+
+void TestIndexMatchesReference() {
+    const TestCorpus corpus = MakeRandomCorpus(500, 1);
+    SearchServer search_server(corpus.stop_words);
+    AddCorpus(search_server, corpus);
+    assert(search_server.GetDocumentCount() == 500);
+    const ReferenceRanking reference(corpus);
+    for (const string& query : MakeRandomQueries(200, 2)) {
+        for (const DocumentStatus status : {DocumentStatus::ACTUAL, DocumentStatus::BANNED}) {
+            AssertSameDocuments(search_server.FindTopDocuments(query, status), reference.FindTopDocuments(query, status));
+        }
+    }
+
+    // Term frequencies are the shares of the words of a document, without stop words
+    const auto& word_freqs = search_server.GetWordFrequencies(1);
+    double freq_sum = 0.0;
+    for (const auto& [word, freq] : word_freqs) {
+        assert(count(corpus.stop_words.begin(), corpus.stop_words.end(), word) == 0);
+        freq_sum += freq;
+    }
+    assert(word_freqs.empty() || abs(freq_sum - 1.0) < 1e-9);
+    assert(search_server.GetWordFrequencies(2).empty());
+}
+
+// The compressed lists must hold the same postings as the plain ones, up to float precision of term frequencies
+void AssertSamePostings(const CompressedPostingList& postings, const PlainPostingList& expected) {
+    assert(postings.GetSize() == expected.GetSize());
+    vector<Posting> expected_postings;
+    expected.ForEach([&](const Posting& posting) {
+        expected_postings.push_back(posting);
+    });
+    size_t index = 0;
+    postings.ForEach([&](const Posting& posting) {
+        assert(posting.document_ordinal == expected_postings[index].document_ordinal);
+        assert(abs(posting.term_freq - expected_postings[index].term_freq) < 1e-6);
+        ++index;
+    });
+    assert(index == expected_postings.size());
+}
+
+void TestCompressedPostingLists() {
+    mt19937 generator(3);
+    CompressedPostingList compressed;
+    PlainPostingList plain;
+    uint32_t ordinal = 0;
+    for (int i = 0; i < 1000; ++i) {
+        // Gaps of every bit width up to 20
+        ordinal += 1 + (generator() & ((1u << (i % 20)) - 1));
+        const Posting posting{ordinal, uniform_real_distribution<double>(0.01, 1.0)(generator)};
+        compressed.PushBack(posting);
+        plain.PushBack(posting);
+    }
+    AssertSamePostings(compressed, plain);
+    assert(abs(compressed.GetMaxTermFreq() - plain.GetMaxTermFreq()) < 1e-6);
+    assert(compressed.GetMemoryUsage() < plain.GetMemoryUsage());
+
+    for (int i = 0; i < 200; ++i) {
+        const uint32_t target = uniform_int_distribution<uint32_t>(0, ordinal + 1)(generator);
+        auto compressed_cursor = compressed.GetCursor();
+        auto plain_cursor = plain.GetCursor();
+        compressed_cursor.SkipTo(target);
+        plain_cursor.SkipTo(target);
+        for (int step = 0; step < 3; ++step) {
+            assert(compressed_cursor.GetDocumentOrdinal() == plain_cursor.GetDocumentOrdinal());
+            assert(compressed.Contains(target) == plain.Contains(target));
+            compressed_cursor.Next();
+            plain_cursor.Next();
+        }
+    }
+
+    // Erasing from packed blocks and from the unpacked tail
+    vector<uint32_t> ordinals;
+    plain.ForEach([&](const Posting& posting) {
+        ordinals.push_back(posting.document_ordinal);
+    });
+    for (size_t i = 0; i < ordinals.size(); i += 3) {
+        assert(compressed.Erase(ordinals[i]) && plain.Erase(ordinals[i]));
+        assert(!compressed.Erase(ordinals[i]));
+    }
+    AssertSamePostings(compressed, plain);
+    auto cursor = compressed.GetCursor();
+    cursor.SkipTo(END_DOCUMENT_ORDINAL - 1);
+    assert(cursor.GetDocumentOrdinal() == END_DOCUMENT_ORDINAL);
+
+    // The vector decoders match the scalar one on random bits of every width. A block
+    // takes as many words as bits per gap times four, and no decoder reads past them
+    for (uint8_t bit_width = 1; bit_width <= 32; ++bit_width) {
+        vector<uint32_t> packed(bit_width * CompressedPostingList::BLOCK_SIZE / 32);
+        for (uint32_t& word : packed) {
+            word = generator();
+        }
+        const uint32_t first_ordinal = generator() % 1000;
+        vector<uint32_t> expected(CompressedPostingList::BLOCK_SIZE);
+        UnpackOrdinals(packed.data(), bit_width, first_ordinal, expected.data(), TokenizerIsa::SCALAR);
+        for (const TokenizerIsa isa : {TokenizerIsa::SSE2, TokenizerIsa::AVX2}) {
+            if (!IsTokenizerIsaSupported(isa)) {
+                continue;
+            }
+            vector<uint32_t> ordinals(CompressedPostingList::BLOCK_SIZE);
+            UnpackOrdinals(packed.data(), bit_width, first_ordinal, ordinals.data(), isa);
+            assert(ordinals == expected);
+        }
+    }
+}
+
+void TestRemoveDocument() {
+    TestCorpus corpus = MakeRandomCorpus(300, 4);
+    SearchServer search_server(corpus.stop_words);
+    AddCorpus(search_server, corpus);
+    mt19937 generator(5);
+    for (int i = 0; i < 100; ++i) {
+        auto document = next(corpus.documents.begin(), uniform_int_distribution<size_t>(0, corpus.documents.size() - 1)(generator));
+        const int id = document->first;
+        corpus.documents.erase(document);
+        if (i % 2 == 0) {
+            search_server.RemoveDocument(id);
+        } else {
+            search_server.RemoveDocument(execution::par, id);
+        }
+        assert(search_server.GetWordFrequencies(id).empty());
+        assert(search_server.GetDocumentCount() == static_cast<int>(corpus.documents.size()));
+    }
+    // Unknown ids are ignored
+    search_server.RemoveDocument(-1);
+    search_server.RemoveDocument(execution::par, 2);
+    assert(search_server.GetDocumentCount() == 200);
+    assert(equal(search_server.begin(), search_server.end(), corpus.documents.begin(), corpus.documents.end(),
+                 [](int id, const auto& document) {
+                     return id == document.first;
+                 }));
+
+    const ReferenceRanking reference(corpus);
+    for (const string& query : MakeRandomQueries(200, 6)) {
+        AssertSameDocuments(search_server.FindTopDocuments(query), reference.FindTopDocuments(query));
+        AssertSameDocuments(search_server.FindTopDocuments(execution::par, query), reference.FindTopDocuments(query));
+    }
+}
+
+void TestRemoveDuplicates() {
+    SearchServer search_server("and with"s);
+    search_server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, {7, 2, 7});
+    search_server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, {1, 2});
+    // Same words as 2, with stop words and repeats
+    search_server.AddDocument(3, "funny pet with curly hair and hair"s, DocumentStatus::ACTUAL, {1, 2});
+    // Same words as 1 in another order
+    search_server.AddDocument(4, "rat nasty pet funny"s, DocumentStatus::BANNED, {1});
+    search_server.AddDocument(5, "funny pet curly"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(6, "curly funny pet"s, DocumentStatus::ACTUAL, {1});
+
+    vector<int> duplicate_ids;
+    RemoveDuplicates(search_server, [&duplicate_ids](int document_id) {
+        duplicate_ids.push_back(document_id);
+    });
+    assert((duplicate_ids == vector<int>{3, 4, 6}));
+    assert(search_server.GetDocumentCount() == 3);
+    assert((vector<int>(search_server.begin(), search_server.end()) == vector<int>{1, 2, 5}));
+    // The index no longer finds the removed documents
+    assert(search_server.FindTopDocuments("nasty"s, DocumentStatus::BANNED).empty());
+}
+
+template <typename Function>
+void AssertThrowsInvalidArgument(Function function) {
+    try {
+        function();
+    } catch (const invalid_argument&) {
+        return;
+    }
+    assert(false);
+}
+
+void TestProcessQueries() {
+    SearchServer search_server("and with"s);
+    AddTestDocuments(search_server);
+    const vector<string> queries(TEST_QUERIES.begin(), TEST_QUERIES.end());
+    const auto documents_lists = ProcessQueries(search_server, queries);
+    assert(documents_lists.size() == queries.size());
+    vector<Document> expected_joined;
+    for (size_t i = 0; i < queries.size(); ++i) {
+        const auto documents = search_server.FindTopDocuments(queries[i]);
+        AssertSameDocuments(documents_lists[i], documents);
+        expected_joined.insert(expected_joined.end(), documents.begin(), documents.end());
+    }
+    const auto joined = ProcessQueriesJoined(search_server, queries);
+    assert(joined.size() == expected_joined.size());
+    AssertSameDocuments(vector<Document>(joined.begin(), joined.end()), expected_joined);
+    assert(ProcessQueriesJoined(search_server, {}).size() == 0);
+
+    // An invalid query is reported to the caller instead of escaping the parallel run
+    const vector<string> invalid_queries = {"cat"s, "--dog"s, "pet"s};
+    AssertThrowsInvalidArgument([&] {
+        ProcessQueries(search_server, invalid_queries);
+    });
+    AssertThrowsInvalidArgument([&] {
+        ProcessQueriesJoined(search_server, invalid_queries);
+    });
+}
+
+void TestParsing() {
+    const string text = "  funny   pet and  nasty rat "s;
+    const auto words = SplitIntoWords(text);
+    assert((words == vector<string_view>{"funny"sv, "pet"sv, "and"sv, "nasty"sv, "rat"sv}));
+    // The words point into the text
+    assert(words[0].data() == text.data() + 2);
+    assert(SplitIntoWords("   "sv).empty());
+    assert(SplitIntoWords(""sv).empty());
+
+    AssertThrowsInvalidArgument([] {
+        SearchServer search_server("and wi\x12th"s);
+    });
+    SearchServer search_server("and with"s);
+    search_server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, {1});
+    AssertThrowsInvalidArgument([&] {
+        search_server.AddDocument(1, "funny pet"s, DocumentStatus::ACTUAL, {1});
+    });
+    AssertThrowsInvalidArgument([&] {
+        search_server.AddDocument(-1, "funny pet"s, DocumentStatus::ACTUAL, {1});
+    });
+    AssertThrowsInvalidArgument([&] {
+        search_server.AddDocument(2, "funny p\x01et"s, DocumentStatus::ACTUAL, {1});
+    });
+    assert(search_server.GetDocumentCount() == 1);
+    for (const string& query : {"funny -"s, "funny --pet"s, "fu\x1fnny"s, "-pe\x02t"s}) {
+        AssertThrowsInvalidArgument([&] {
+            search_server.FindTopDocuments(query);
+        });
+        AssertThrowsInvalidArgument([&] {
+            search_server.MatchDocument(query, 1);
+        });
+    }
+
+    // Stop words and repeated words are dropped; the words returned point into the index
+    string query = "rat and  funny rat -dog"s;
+    const auto [matched_words, status] = search_server.MatchDocument(execution::seq, query, 1);
+    assert((matched_words == vector<string_view>{"funny"sv, "rat"sv}));
+    assert(status == DocumentStatus::ACTUAL);
+    query.assign(query.size(), 'x');
+    assert(matched_words[0] == "funny"sv);
+    assert(get<0>(search_server.MatchDocument("funny -nasty"s, 1)).empty());
+
+    // Without positions quotes are part of the words, as they are in documents
+    SearchServer quoted_server(""s);
+    quoted_server.AddDocument(1, "a \"dog\" barks"s, DocumentStatus::ACTUAL, {1});
+    quoted_server.AddDocument(2, "a dog barks"s, DocumentStatus::ACTUAL, {1});
+    const auto quoted_documents = quoted_server.FindTopDocuments("\"dog\""s);
+    assert(quoted_documents.size() == 1 && quoted_documents[0].id == 1);
+    const auto unquoted_documents = quoted_server.FindTopDocuments("barks -\"dog\""s);
+    assert(unquoted_documents.size() == 1 && unquoted_documents[0].id == 2);
+    assert((get<0>(quoted_server.MatchDocument("\"dog\" \"cat"s, 1)) == vector<string>{"\"dog\""s}));
+}
+
+// MaxScore skips documents that cannot get into the top; the results must still be those of scoring every document
+void TestTopDocumentsPruning() {
+    TestCorpus corpus = MakeRandomCorpus(3000, 7);
+    // Long and short documents give the words very different upper bounds
+    mt19937 generator(8);
+    for (int id = 10000; id < 10300; ++id) {
+        corpus.documents[id] = {DrawRandomWords(generator, 40, 80), DocumentStatus::ACTUAL, {id % 7}};
+    }
+    SearchServer search_server(corpus.stop_words);
+    AddCorpus(search_server, corpus);
+    const auto positive_rating = [](int, DocumentStatus, int rating) {
+        return rating > 0;
+    };
+    vector<string> queries = MakeRandomQueries(300, 9);
+    queries.push_back(accumulate(RANDOM_WORDS.begin(), RANDOM_WORDS.end(), ""s, [](const string& query, const string& word) {
+        return query + " "s + word;
+    }));
+    const ReferenceRanking reference(corpus);
+    for (const string& query : queries) {
+        AssertSameDocuments(search_server.FindTopDocuments(query), reference.FindTopDocuments(query));
+        AssertSameDocuments(search_server.FindTopDocuments(query, positive_rating), reference.FindTopDocuments(query, positive_rating));
+    }
+}
+
+string MakeTestFilePath(const string& name) {
+    return (filesystem::temp_directory_path() / ("search_server_test_"s + name)).string();
+}
+
+void TestSnapshots() {
+    TestCorpus corpus = MakeRandomCorpus(400, 10);
+    SearchServer search_server(corpus.stop_words);
+    AddCorpus(search_server, corpus);
+    search_server.RemoveDocument(1);
+    corpus.documents.erase(1);
+    const string path = MakeTestFilePath("snapshot"s);
+    search_server.SaveSnapshot(path);
+
+    {
+        SearchServer opened_server = SearchServer::OpenSnapshot(path);
+        assert(opened_server.GetDocumentCount() == search_server.GetDocumentCount());
+        const vector<string> queries = MakeRandomQueries(100, 11);
+        for (const string& query : queries) {
+            AssertSameDocuments(opened_server.FindTopDocuments(query), search_server.FindTopDocuments(query));
+            AssertSameDocuments(opened_server.FindTopDocuments(execution::par, query, DocumentStatus::BANNED),
+                                search_server.FindTopDocuments(query, DocumentStatus::BANNED));
+        }
+        for (const int id : search_server) {
+            AssertSameWordFrequencies(opened_server.GetWordFrequencies(id), search_server.GetWordFrequencies(id));
+            assert(opened_server.MatchDocument(queries[0], id) == search_server.MatchDocument(queries[0], id));
+        }
+
+        // Lists read in place are copied when changed; the file stays as it was
+        for (SearchServer* server : {&search_server, &opened_server}) {
+            server->AddDocument(5000, "cat dog rat"s, DocumentStatus::ACTUAL, {5});
+            server->RemoveDocument(4);
+            server->RemoveDocument(execution::par, 7);
+        }
+        for (const string& query : queries) {
+            AssertSameDocuments(opened_server.FindTopDocuments(query), search_server.FindTopDocuments(query));
+        }
+    }
+    const SearchServer reopened_server = SearchServer::OpenSnapshot(path);
+    const ReferenceRanking reference(corpus);
+    for (const string& query : MakeRandomQueries(100, 12)) {
+        AssertSameDocuments(reopened_server.FindTopDocuments(query), reference.FindTopDocuments(query));
+    }
+
+    AssertThrowsInvalidArgument([] {
+        SearchServer::OpenSnapshot(MakeTestFilePath("missing"s));
+    });
+    const string garbage_path = MakeTestFilePath("garbage"s);
+    ofstream(garbage_path) << "not a snapshot of a search server"s;
+    AssertThrowsInvalidArgument([&] {
+        SearchServer::OpenSnapshot(garbage_path);
+    });
+    // A truncated snapshot
+    filesystem::resize_file(path, filesystem::file_size(path) / 2);
+    AssertThrowsInvalidArgument([&] {
+        SearchServer::OpenSnapshot(path);
+    });
+    filesystem::remove(path);
+    filesystem::remove(garbage_path);
+}
+
+// Overwrites the first occurrence of the bytes of pattern in the file with those of replacement
+template <typename T>
+void PatchFile(const string& path, const T& pattern, const T& replacement) {
+    string bytes;
+    {
+        ifstream input(path, ios::binary);
+        bytes.assign(istreambuf_iterator<char>(input), istreambuf_iterator<char>());
+    }
+    const size_t offset = bytes.find(string(reinterpret_cast<const char*>(&pattern), sizeof(T)));
+    assert(offset != string::npos);
+    bytes.replace(offset, sizeof(T), reinterpret_cast<const char*>(&replacement), sizeof(T));
+    ofstream(path, ios::binary | ios::trunc) << bytes;
+}
+
+void TestCorruptSnapshots() {
+    // One document with one word, so that its table entry and its posting are easy to find
+    SearchServer search_server(""s);
+    search_server.AddDocument(123456789, "cat"s, DocumentStatus::ACTUAL, {987654});
+    const string path = MakeTestFilePath("corrupt"s);
+
+    // The id, rating and status of the document table
+    struct DocumentRecord {
+        int id;
+        int rating;
+        int status;
+    };
+    search_server.SaveSnapshot(path);
+    PatchFile(path, DocumentRecord{123456789, 987654, 0}, DocumentRecord{123456789, 987654, 7});
+    AssertThrowsInvalidArgument([&] {
+        SearchServer::OpenSnapshot(path);
+    });
+
+    // The element count of the posting array and the posting itself, with its padding zeroed
+    struct PostingRecord {
+        uint64_t count;
+        uint32_t document_ordinal;
+        uint32_t padding;
+        double term_freq;
+    };
+    search_server.SaveSnapshot(path);
+    PatchFile(path, PostingRecord{1, 0, 0, 1.0}, PostingRecord{1, 5, 0, 1.0});
+    AssertThrowsInvalidArgument([&] {
+        SearchServer::OpenSnapshot(path);
+    });
+    filesystem::remove(path);
+
+    // A writer dropped before Finish, as when saving throws, leaves no files behind
+    {
+        SnapshotWriter writer(path);
+        writer.Write(1);
+    }
+    assert(!filesystem::exists(path));
+    assert(!filesystem::exists(path + ".tmp"s));
+}
+
+void AssertDocumentIds(const SearchServer& search_server, const vector<int>& expected_ids) {
+    assert(search_server.GetDocumentCount() == static_cast<int>(expected_ids.size()));
+    assert(equal(search_server.begin(), search_server.end(), expected_ids.begin(), expected_ids.end()));
+    for (size_t i = 0; i < expected_ids.size(); ++i) {
+        assert(search_server.GetDocumentId(static_cast<int>(i)) == expected_ids[i]);
+    }
+    try {
+        search_server.GetDocumentId(search_server.GetDocumentCount());
+        assert(false);
+    } catch (const out_of_range&) {
+    }
+}
+
+void TestDocumentIds() {
+    // Ids are added out of order by every way of adding documents
+    SearchServer search_server("and"s);
+    search_server.AddDocument(5, "cat"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(9, "dog"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(2, "rat"s, DocumentStatus::BANNED, {1});
+    search_server.AddDocuments(vector<DocumentInput>{{7, "cat"sv, DocumentStatus::ACTUAL, {1}}, {1, "dog"sv, DocumentStatus::ACTUAL, {1}}, {12, "rat"sv, DocumentStatus::ACTUAL, {1}}});
+    SearchServer other_server("and"s);
+    other_server.AddDocument(8, "cat"s, DocumentStatus::ACTUAL, {1});
+    other_server.AddDocument(0, "dog"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocumentsFrom(other_server);
+    AssertDocumentIds(search_server, {0, 1, 2, 5, 7, 8, 9, 12});
+
+    search_server.RemoveDocument(0);
+    search_server.RemoveDocument(7);
+    search_server.RemoveDocument(12);
+    AssertDocumentIds(search_server, {1, 2, 5, 8, 9});
+    search_server.AddDocument(3, "cat"s, DocumentStatus::ACTUAL, {1});
+    AssertDocumentIds(search_server, {1, 2, 3, 5, 8, 9});
+
+    const string path = MakeTestFilePath("document_ids"s);
+    search_server.SaveSnapshot(path);
+    const SearchServer snapshot_server = SearchServer::OpenSnapshot(path);
+    AssertDocumentIds(snapshot_server, {1, 2, 3, 5, 8, 9});
+    filesystem::remove(path);
+}
+
+void TestQueryCache() {
+    const TestCorpus corpus = MakeRandomCorpus(300, 13);
+    SearchServer search_server(corpus.stop_words);
+    SearchServer cached_server(corpus.stop_words);
+    AddCorpus(search_server, corpus);
+    AddCorpus(cached_server, corpus);
+    assert(cached_server.GetQueryCacheStats().hit_count == 0);
+    cached_server.SetQueryCacheCapacity(1000);
+
+    const vector<string> queries = MakeRandomQueries(50, 14);
+    for (int repeat = 0; repeat < 2; ++repeat) {
+        for (const string& query : queries) {
+            AssertSameDocuments(cached_server.FindTopDocuments(query), search_server.FindTopDocuments(query));
+            AssertSameDocuments(cached_server.FindTopDocuments(execution::par, query, DocumentStatus::BANNED),
+                                search_server.FindTopDocuments(query, DocumentStatus::BANNED));
+        }
+    }
+    QueryCacheStats stats = cached_server.GetQueryCacheStats();
+    assert(stats.hit_count == stats.miss_count);
+    assert(stats.size == stats.miss_count);
+
+    // Predicates cannot be told apart, so their results are not cached
+    cached_server.FindTopDocuments(queries[0], [](int, DocumentStatus, int) {
+        return true;
+    });
+    assert(cached_server.GetQueryCacheStats().hit_count == stats.hit_count);
+
+    // Changing the index turns cached results stale
+    for (SearchServer* server : {&search_server, &cached_server}) {
+        server->AddDocument(5000, queries[0], DocumentStatus::ACTUAL, {100});
+        server->RemoveDocument(4);
+    }
+    for (const string& query : queries) {
+        AssertSameDocuments(cached_server.FindTopDocuments(query), search_server.FindTopDocuments(query));
+    }
+    assert(cached_server.GetQueryCacheStats().hit_count == stats.hit_count);
+
+    // A small cache evicts the least recently used results; each shard keeps at least one
+    cached_server.SetQueryCacheCapacity(4);
+    for (const string& query : queries) {
+        cached_server.FindTopDocuments(query);
+    }
+    stats = cached_server.GetQueryCacheStats();
+    assert(stats.size < queries.size());
+    assert(stats.eviction_count > 0);
+    cached_server.SetQueryCacheCapacity(0);
+    assert(cached_server.GetQueryCacheStats().size == 0);
+}
+
+void TestSegmentedSearchServer() {
+    const TestCorpus corpus = MakeRandomCorpus(300, 15);
+    SearchServer search_server(corpus.stop_words);
+    SegmentedSearchServer segmented_server(corpus.stop_words, 20);
+    AddCorpus(search_server, corpus);
+    AddCorpus(segmented_server, corpus);
+    // Documents of the writable server are not searched yet
+    assert(segmented_server.GetDocumentCount() == 300 - 300 % 20);
+    segmented_server.Flush();
+    assert(segmented_server.GetDocumentCount() == 300);
+
+    mt19937 generator(16);
+    for (int i = 0; i < 60; ++i) {
+        const int id = next(corpus.documents.begin(), uniform_int_distribution<size_t>(0, corpus.documents.size() - 1)(generator))->first;
+        search_server.RemoveDocument(id);
+        segmented_server.RemoveDocument(id);
+    }
+    assert(segmented_server.GetDocumentCount() == search_server.GetDocumentCount());
+
+    // Removed documents are left out of the statistics of prefix and fuzzy words too
+    vector<string> queries = MakeRandomQueries(100, 17);
+    queries.insert(queries.end(), {"cat*"s, "ca* dog"s, "pet* -rat"s, "d* hair"s, "rat -pet*"s,
+                                   "cat~1"s, "dog~2 hair"s, "pet~1 -rat~1"s, "hail -cut~1"s});
+    const auto check_results = [&] {
+        for (const string& query : queries) {
+            AssertSameDocuments(segmented_server.FindTopDocuments(query), search_server.FindTopDocuments(query));
+            AssertSameDocuments(segmented_server.FindTopDocuments(execution::par, query, DocumentStatus::BANNED),
+                                search_server.FindTopDocuments(query, DocumentStatus::BANNED));
+        }
+    };
+    // Before and after merges drop the removed documents
+    check_results();
+    segmented_server.WaitForMerges();
+    assert(segmented_server.GetSegmentCount() < 300 / 20);
+    check_results();
+}
+
+void TestConcurrentSearchServer() {
+    const TestCorpus corpus = MakeRandomCorpus(200, 18);
+    SearchServer search_server(corpus.stop_words);
+    ConcurrentSearchServer concurrent_server(corpus.stop_words);
+    AddCorpus(search_server, corpus);
+    const vector<string> queries = MakeRandomQueries(50, 19);
+
+    // Readers see every document added so far, and never a document half added
+    atomic<bool> is_writing = true;
+    vector<thread> readers;
+    for (int i = 0; i < 2; ++i) {
+        readers.emplace_back([&] {
+            int previous_count = 0;
+            while (is_writing) {
+                const int count = concurrent_server.GetDocumentCount();
+                assert(count >= previous_count);
+                previous_count = count;
+                for (const Document& document : concurrent_server.FindTopDocuments(queries[count % queries.size()])) {
+                    assert(corpus.documents.count(document.id) > 0);
+                }
+            }
+        });
+    }
+    AddCorpus(concurrent_server, corpus);
+    concurrent_server.RemoveDocument(1);
+    is_writing = false;
+    for (thread& reader : readers) {
+        reader.join();
+    }
+
+    search_server.RemoveDocument(1);
+    assert(concurrent_server.GetDocumentCount() == search_server.GetDocumentCount());
+    for (const string& query : queries) {
+        AssertSameDocuments(concurrent_server.FindTopDocuments(query), search_server.FindTopDocuments(query));
+        AssertSameDocuments(concurrent_server.FindTopDocuments(execution::par, query, DocumentStatus::BANNED),
+                            search_server.FindTopDocuments(query, DocumentStatus::BANNED));
+        assert(concurrent_server.MatchDocument(query, 4) == search_server.MatchDocument(query, 4));
+    }
+}
+
+void TestCorpusGenerator() {
+    CorpusOptions options;
+    options.vocabulary_size = 500;
+    options.length_distribution = LengthDistribution::UNIFORM;
+    options.min_document_length = 3;
+    options.max_document_length = 8;
+    CorpusGenerator generator(options);
+    CorpusGenerator same_generator(options);
+    assert(generator.GetVocabulary().size() == 500);
+    assert(generator.GetStopWords().size() == options.stop_word_count);
+
+    // The same options give the same corpus, which the server accepts
+    SearchServer search_server(generator.GetStopWords());
+    for (int id = 0; id < 200; ++id) {
+        const string document = generator.GenerateDocument();
+        assert(document == same_generator.GenerateDocument());
+        vector<string_view> words;
+        TokenizeWords(document, words);
+        assert(words.size() >= 3 && words.size() <= 8);
+        const DocumentStatus status = generator.GenerateStatus();
+        assert(status == same_generator.GenerateStatus());
+        const vector<int> ratings = generator.GenerateRatings();
+        assert(ratings == same_generator.GenerateRatings());
+        search_server.AddDocument(id, document, status, ratings);
+    }
+    for (int i = 0; i < 50; ++i) {
+        const string query = generator.GenerateQuery(3, 1);
+        assert(query == same_generator.GenerateQuery(3, 1));
+        AssertSameDocuments(search_server.FindTopDocuments(execution::par, query), search_server.FindTopDocuments(query));
+    }
+
+    options.stop_word_count = options.vocabulary_size;
+    AssertThrowsInvalidArgument([&] { CorpusGenerator{options}; });
+    options.stop_word_count = 10;
+    options.min_document_length = 9;
+    AssertThrowsInvalidArgument([&] { CorpusGenerator{options}; });
+}
+
+void TestRequestQueue() {
+    const TestCorpus corpus = MakeRandomCorpus(100, 20);
+    SearchServer search_server(corpus.stop_words);
+    AddCorpus(search_server, corpus);
+    search_server.SetQueryCacheCapacity(100);
+    RequestQueue request_queue(search_server);
+
+    const vector<string> queries = MakeRandomQueries(20, 21);
+    int no_result_count = 0;
+    for (const string& query : queries) {
+        const vector<Document> documents = search_server.FindTopDocuments(query);
+        no_result_count += documents.empty();
+        AssertSameDocuments(request_queue.AddFindRequest(query), documents);
+        AssertSameDocuments(request_queue.AddFindRequest(execution::par, query, DocumentStatus::BANNED),
+                            search_server.FindTopDocuments(query, DocumentStatus::BANNED));
+        no_result_count += search_server.FindTopDocuments(query, DocumentStatus::BANNED).empty();
+    }
+    // Requests by status are answered from the cache of the server
+    const QueryCacheStats stats = search_server.GetQueryCacheStats();
+    assert(stats.hit_count >= 2 * queries.size());
+
+    const auto is_even = [](int document_id, DocumentStatus, int) {
+        return document_id % 2 == 0;
+    };
+    const vector<Document> even_documents = search_server.FindTopDocuments(queries[0], is_even);
+    AssertSameDocuments(request_queue.AddFindRequest(queries[0], is_even), even_documents);
+    no_result_count += even_documents.empty();
+    request_queue.AddFindRequest("nonexistent"s);
+    assert(request_queue.GetNoResultRequests() == no_result_count + 1);
+}
+
+void TestMatchDocument() {
+    const TestCorpus corpus = MakeRandomCorpus(100, 22);
+    SearchServer search_server(corpus.stop_words);
+    AddCorpus(search_server, corpus);
+    const ReferenceRanking reference(corpus);
+
+    vector<int> document_ids;
+    for (const auto& [id, _] : corpus.documents) {
+        document_ids.push_back(id);
+    }
+    for (const string& query : MakeRandomQueries(30, 23)) {
+        const auto matches = search_server.MatchDocuments(execution::par, query, document_ids);
+        assert(matches == search_server.MatchDocuments(execution::seq, query, document_ids));
+        for (size_t i = 0; i < document_ids.size(); ++i) {
+            const int id = document_ids[i];
+            const vector<string> expected = reference.MatchDocument(query, id);
+            const auto [words, status] = search_server.MatchDocument(query, id);
+            assert(words == expected && status == corpus.documents.at(id).status);
+            for (const auto& [view_words, view_status] : {search_server.MatchDocument(execution::seq, query, id),
+                                                          search_server.MatchDocument(execution::par, query, id), matches[i]}) {
+                assert(vector<string>(view_words.begin(), view_words.end()) == expected && view_status == status);
+            }
+        }
+    }
+
+    // The words outlive the query they were found by
+    vector<string_view> words;
+    {
+        const string query = "cat dog -unknown"s;
+        words = get<0>(search_server.MatchDocument(execution::par, query, document_ids[0]));
+    }
+    assert(vector<string>(words.begin(), words.end()) == reference.MatchDocument("cat dog"s, document_ids[0]));
+
+    bool is_thrown = false;
+    try {
+        search_server.MatchDocuments(execution::par, "cat"s, {document_ids[0], 2});
+    } catch (const out_of_range&) {
+        is_thrown = true;
+    }
+    assert(is_thrown);
+}
+
+// Whether the words of the phrase follow each other in the text with up to slop other words
+// in every gap. Stop words of the phrase are skipped but keep their places
+bool ContainsReferencePhrase(const string& text, const vector<string>& phrase, int slop, const set<string>& stop_words) {
+    vector<pair<string, int>> phrase_words;
+    for (size_t offset = 0; offset < phrase.size(); ++offset) {
+        if (stop_words.count(phrase[offset]) == 0) {
+            phrase_words.emplace_back(phrase[offset], static_cast<int>(offset));
+        }
+    }
+    const vector<string_view> words = SplitIntoWords(text);
+    // Whether the phrase words from index on match, the previous one being at position
+    const function<bool(size_t, int)> matches_from = [&](size_t index, int position) {
+        if (index == phrase_words.size()) {
+            return true;
+        }
+        const int min_gap = phrase_words[index].second - phrase_words[index - 1].second;
+        for (int next = position + min_gap; next <= position + min_gap + slop && next < static_cast<int>(words.size()); ++next) {
+            if (words[next] == phrase_words[index].first && matches_from(index + 1, next)) {
+                return true;
+            }
+        }
+        return false;
+    };
+    for (size_t position = 0; position < words.size(); ++position) {
+        if (words[position] == phrase_words[0].first && matches_from(1, static_cast<int>(position))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void TestPhraseQueries() {
+    const TestCorpus corpus = MakeRandomCorpus(300, 24);
+    const set<string> stop_words(corpus.stop_words.begin(), corpus.stop_words.end());
+    SearchServer search_server(corpus.stop_words);
+    search_server.EnablePositions();
+    AddCorpus(search_server, corpus);
+    const ReferenceRanking reference(corpus);
+    assert(search_server.GetPositionMemoryUsage() > 0);
+
+    // Phrases are taken from the documents, so that most of them are found
+    mt19937 generator(25);
+    // The phrase, its words, its slop and the words of the query besides the phrase
+    vector<tuple<string, vector<string>, int, string>> queries;
+    for (const auto& [id, document] : corpus.documents) {
+        vector<string> words;
+        for (const string_view word : SplitIntoWords(document.text)) {
+            words.emplace_back(word);
+        }
+        const size_t begin = uniform_int_distribution<size_t>(0, words.size() - 1)(generator);
+        const vector<string> phrase(words.begin() + begin, words.begin() + min(words.size(), begin + 3));
+        if (all_of(phrase.begin(), phrase.end(), [&stop_words](const string& word) {
+                return stop_words.count(word) > 0;
+            })) {
+            continue;
+        }
+        const int slop = uniform_int_distribution<int>(0, 2)(generator);
+        string phrase_text;
+        for (const string& word : phrase) {
+            phrase_text += (phrase_text.empty() ? ""s : " "s) + word;
+        }
+        queries.emplace_back(phrase_text, phrase, slop, DrawRandomWords(generator, 0, 1));
+        if (queries.size() == 50) {
+            break;
+        }
+    }
+
+    SearchServer snapshot_source(corpus.stop_words);
+    snapshot_source.EnablePositions();
+    snapshot_source.AddDocumentsFrom(search_server);
+    const string path = MakeTestFilePath("phrases"s);
+    snapshot_source.SaveSnapshot(path);
+    const SearchServer snapshot_server = SearchServer::OpenSnapshot(path);
+
+    for (const auto& [phrase_text, phrase, slop, other_words] : queries) {
+        const string query = "\""s + phrase_text + "\"~"s + to_string(slop) + " "s + other_words;
+        const auto expected = reference.FindTopDocuments(phrase_text + " "s + other_words, [&](int id, DocumentStatus status, int) {
+            return status == DocumentStatus::ACTUAL && ContainsReferencePhrase(corpus.documents.at(id).text, phrase, slop, stop_words);
+        });
+        AssertSameDocuments(search_server.FindTopDocuments(query), expected);
+        AssertSameDocuments(search_server.FindTopDocuments(execution::par, query), expected);
+        AssertSameDocuments(snapshot_source.FindTopDocuments(query), expected);
+        AssertSameDocuments(snapshot_server.FindTopDocuments(execution::par, query), expected);
+    }
+    filesystem::remove(path);
+
+    SearchServer server_without_positions(corpus.stop_words);
+    // Without positions the quotes are ordinary characters of the words "cat and dog"
+    assert(server_without_positions.FindTopDocuments("\"cat dog\""s).empty());
+    AssertThrowsInvalidArgument([&] { search_server.FindTopDocuments("\"cat dog"s); });
+    AssertThrowsInvalidArgument([&] { search_server.FindTopDocuments("-\"cat dog\""s); });
+    AssertThrowsInvalidArgument([&] { snapshot_source.AddDocumentsFrom(server_without_positions); });
+    bool is_thrown = false;
+    try {
+        search_server.EnablePositions();
+    } catch (const logic_error&) {
+        is_thrown = true;
+    }
+    assert(is_thrown);
+}
+
+void TestPrefixQueries() {
+    const TestCorpus corpus = MakeRandomCorpus(300, 26);
+    SearchServer search_server(corpus.stop_words);
+    AddCorpus(search_server, corpus);
+    const ReferenceRanking reference(corpus);
+
+    // cat* expands to cat, cats, catalog; c* also to cart and cut
+    const vector<string> queries = {"cat*"s, "c* dog"s, "pet* -rat"s, "rat -pet*"s, "catalog* hair"s, "x*"s, "dog -d*"s};
+    for (const string& query : queries) {
+        const auto expected = reference.FindTopDocuments(query);
+        AssertSameDocuments(search_server.FindTopDocuments(query), expected);
+        AssertSameDocuments(search_server.FindTopDocuments(execution::par, query), expected);
+        AssertSameDocuments(search_server.FindTopDocuments(execution::par, query, DocumentStatus::BANNED),
+                            reference.FindTopDocuments(query, DocumentStatus::BANNED));
+        for (const auto& [id, _] : corpus.documents) {
+            const auto [words, status] = search_server.MatchDocument(execution::par, query, id);
+            assert(vector<string>(words.begin(), words.end()) == reference.MatchDocument(query, id));
+        }
+    }
+}
+
+void TestFuzzyQueries() {
+    const TestCorpus corpus = MakeRandomCorpus(300, 27);
+    SearchServer search_server(corpus.stop_words);
+    AddCorpus(search_server, corpus);
+    const ReferenceRanking reference(corpus);
+
+    // cat~1 expands to cat, cats, cart, cut and rat; their term frequencies are weighted by distance
+    const vector<string> queries = {"cat~1"s, "cat~2 dog"s, "pet~1 -rat"s, "rat -pet~1"s, "dgo~2 hair~1"s, "xyzzy~1"s, "cat~1 ca*"s};
+    for (const string& query : queries) {
+        const auto expected = reference.FindTopDocuments(query);
+        AssertSameDocuments(search_server.FindTopDocuments(query), expected);
+        AssertSameDocuments(search_server.FindTopDocuments(execution::par, query), expected);
+        AssertSameDocuments(search_server.FindTopDocuments(execution::par, query, DocumentStatus::BANNED),
+                            reference.FindTopDocuments(query, DocumentStatus::BANNED));
+        for (const auto& [id, _] : corpus.documents) {
+            const auto [words, status] = search_server.MatchDocument(execution::par, query, id);
+            assert(vector<string>(words.begin(), words.end()) == reference.MatchDocument(query, id));
+        }
+    }
+    AssertThrowsInvalidArgument([&] { search_server.FindTopDocuments("cat~3"s); });
+}
+
+void AssertSameOrdinals(const DocumentBitmap& bitmap, const set<uint32_t>& expected) {
+    assert(bitmap.GetSize() == expected.size());
+    vector<uint32_t> ordinals;
+    for (uint32_t ordinal = bitmap.FindNext(0); ordinal != END_DOCUMENT_ORDINAL; ordinal = bitmap.FindNext(ordinal + 1)) {
+        assert(bitmap.Contains(ordinal));
+        ordinals.push_back(ordinal);
+    }
+    assert(equal(ordinals.begin(), ordinals.end(), expected.begin(), expected.end()));
+}
+
+void TestDocumentBitmap() {
+    // The first container gets dense enough to become a bitset, the others stay arrays
+    mt19937 generator(28);
+    DocumentBitmap bitmap;
+    DocumentBitmap other_bitmap;
+    set<uint32_t> ordinals;
+    set<uint32_t> other_ordinals;
+    for (int i = 0; i < 20'000; ++i) {
+        const uint32_t ordinal = i % 4 == 0 ? uniform_int_distribution<uint32_t>(0, 300'000)(generator)
+                                            : uniform_int_distribution<uint32_t>(0, (1 << 16) - 1)(generator);
+        bitmap.Add(ordinal);
+        ordinals.insert(ordinal);
+        if (i % 3 == 0) {
+            other_bitmap.Add(ordinal);
+            other_ordinals.insert(ordinal);
+        }
+    }
+    AssertSameOrdinals(bitmap, ordinals);
+    assert(!bitmap.Contains(300'001) && bitmap.FindNext(300'001) == END_DOCUMENT_ORDINAL);
+    const size_t bitset_memory_usage = bitmap.GetMemoryUsage();
+
+    bitmap.AndNot(other_bitmap);
+    for (const uint32_t ordinal : other_ordinals) {
+        ordinals.erase(ordinal);
+    }
+    AssertSameOrdinals(bitmap, ordinals);
+
+    // Removing most ordinals turns the bitset back into an array
+    for (auto it = ordinals.begin(); it != ordinals.end();) {
+        if (*it % 8 != 0) {
+            bitmap.Remove(*it);
+            it = ordinals.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    bitmap.Remove(300'001);
+    AssertSameOrdinals(bitmap, ordinals);
+    assert(bitmap.GetMemoryUsage() < bitset_memory_usage);
+}
+
+void TestStatusFilters() {
+    const TestCorpus corpus = MakeRandomCorpus(2000, 29);
+    SearchServer search_server(corpus.stop_words);
+    AddCorpus(search_server, corpus);
+    for (int id = 1; id < 600; id += 6) {
+        search_server.RemoveDocument(id);
+    }
+
+    // Queries by status are filtered by bitmaps, and must rank as the same predicate does
+    vector<string> queries = MakeRandomQueries(40, 30);
+    queries.insert(queries.end(), {"cat -dog -rat -pet -hair"s, "cat* -c*"s, "dog -cat~1"s});
+    for (const string& query : queries) {
+        for (const DocumentStatus status : {DocumentStatus::ACTUAL, DocumentStatus::IRRELEVANT, DocumentStatus::BANNED, DocumentStatus::REMOVED}) {
+            const auto has_status = [status](int, DocumentStatus document_status, int) {
+                return document_status == status;
+            };
+            const auto expected = search_server.FindTopDocuments(query, has_status);
+            AssertSameDocuments(search_server.FindTopDocuments(query, status), expected);
+            AssertSameDocuments(search_server.FindTopDocuments(execution::par, query, status), expected);
+            AssertSameDocuments(search_server.FindTopDocuments(execution::par, query, has_status), expected);
+        }
+    }
+}
+
+void TestRelevanceAccumulator() {
+    mt19937 generator(31);
+    RelevanceAccumulator accumulator;
+    for (const uint32_t begin : {0u, 1u << 15, 5u << 15}) {
+        accumulator.Reset(begin, 1 << 15);
+        map<uint32_t, double> expected;
+        vector<uint32_t> first_touched;
+        for (int i = 0; i < 1000; ++i) {
+            const uint32_t ordinal = begin + uniform_int_distribution<uint32_t>(0, 2000)(generator);
+            // Zero relevances are still reported
+            const double relevance = i % 10 == 0 ? 0.0 : uniform_real_distribution<double>(0.0, 1.0)(generator);
+            if (expected.count(ordinal) == 0) {
+                first_touched.push_back(ordinal);
+            }
+            expected[ordinal] += relevance;
+            accumulator.Add(ordinal, relevance);
+        }
+        vector<uint32_t> touched;
+        accumulator.ForEachTouched([&](uint32_t ordinal, double relevance) {
+            touched.push_back(ordinal);
+            assert(abs(relevance - expected.at(ordinal)) < RELEVANCE_EPSILON);
+        });
+        assert(touched == first_touched);
+    }
+}
+
+void TestParallelRanges() {
+    // Enough documents for the parallel search to split them into several ranges
+    const TestCorpus corpus = MakeRandomCorpus(50'000, 32);
+    SearchServer search_server(corpus.stop_words);
+    AddCorpus(search_server, corpus);
+    for (int id = 1; id < 30'000; id += 9) {
+        search_server.RemoveDocument(id);
+    }
+    for (const string& query : MakeRandomQueries(10, 33)) {
+        AssertSameDocuments(search_server.FindTopDocuments(execution::par, query), search_server.FindTopDocuments(query));
+        const auto has_positive_rating = [](int, DocumentStatus, int rating) {
+            return rating > 0;
+        };
+        AssertSameDocuments(search_server.FindTopDocuments(execution::par, query, has_positive_rating),
+                            search_server.FindTopDocuments(query, has_positive_rating));
+    }
+}
+
+template <typename Server>
+void AssertSameAsSingleServer(Server& sharded_server, const TestCorpus& corpus) {
+    SearchServer search_server(corpus.stop_words);
+    AddCorpus(search_server, corpus);
+    AddCorpus(sharded_server, corpus);
+    for (int id = 1; id < 300; id += 9) {
+        search_server.RemoveDocument(id);
+        sharded_server.RemoveDocument(id);
+    }
+    assert(sharded_server.GetDocumentCount() == search_server.GetDocumentCount());
+
+    for (const string& query : MakeRandomQueries(50, 35)) {
+        AssertSameDocuments(sharded_server.FindTopDocuments(query), search_server.FindTopDocuments(query));
+        AssertSameDocuments(sharded_server.FindTopDocuments(query, DocumentStatus::BANNED),
+                            search_server.FindTopDocuments(query, DocumentStatus::BANNED));
+        assert(sharded_server.MatchDocument(query, 4) == search_server.MatchDocument(query, 4));
+    }
+    // Errors of the shards reach the caller with their types
+    AssertThrowsInvalidArgument([&] { sharded_server.FindTopDocuments("cat --dog"s); });
+    AssertThrowsInvalidArgument([&] { sharded_server.AddDocument(4, "cat"s, DocumentStatus::ACTUAL, {}); });
+    bool is_thrown = false;
+    try {
+        sharded_server.MatchDocument("cat"s, 2);
+    } catch (const out_of_range&) {
+        is_thrown = true;
+    }
+    assert(is_thrown);
+}
+
+// Forks workers, so it must run while the process has one thread
+void TestShardedSearchServer() {
+    const TestCorpus corpus = MakeRandomCorpus(500, 34);
+    vector<unique_ptr<ShardProcess>> processes;
+    for (int i = 0; i < 3; ++i) {
+        processes.push_back(make_unique<ShardProcess>(corpus.stop_words));
+    }
+    // Statistics come back from a worker as the server computed them
+    ShardProcess statistics_process(corpus.stop_words);
+    SearchServer statistics_server(corpus.stop_words);
+    for (const auto& [id, document] : corpus.documents) {
+        if (id % 5 == 0) {
+            statistics_process.AddDocument(id, document.text, document.status, document.ratings);
+            statistics_server.AddDocument(id, document.text, document.status, document.ratings);
+        }
+    }
+    for (const string& query : MakeRandomQueries(10, 35)) {
+        statistics_process.SendQueryStatisticsRequest(query);
+        const QueryStatistics received = statistics_process.ReceiveQueryStatistics();
+        const QueryStatistics expected = statistics_server.GetQueryStatistics(query);
+        assert(received.document_count == expected.document_count);
+        assert(received.document_length_sum == expected.document_length_sum);
+        assert(received.document_freqs == expected.document_freqs);
+    }
+    ShardedSearchServer process_server(move(processes));
+    assert(process_server.GetShardCount() == 3);
+    AssertSameAsSingleServer(process_server, corpus);
+    bool is_thrown = false;
+    try {
+        process_server.FindTopDocuments("cat"s, [](int, DocumentStatus, int) {
+            return true;
+        });
+    } catch (const logic_error&) {
+        is_thrown = true;
+    }
+    assert(is_thrown);
+
+    ShardedSearchServer thread_server(corpus.stop_words, 4);
+    AssertSameAsSingleServer(thread_server, corpus);
+    const auto is_even = [](int document_id, DocumentStatus, int) {
+        return document_id % 2 == 0;
+    };
+    SearchServer search_server(corpus.stop_words);
+    AddCorpus(search_server, corpus);
+    for (int id = 1; id < 300; id += 9) {
+        search_server.RemoveDocument(id);
+    }
+    for (const string& query : MakeRandomQueries(10, 36)) {
+        AssertSameDocuments(thread_server.FindTopDocuments(query, is_even), search_server.FindTopDocuments(query, is_even));
+    }
+    AssertThrowsInvalidArgument([&] { ShardedSearchServer(corpus.stop_words, 0); });
+
+    // Once another thread runs, a fork is refused rather than risking a deadlock
+    is_thrown = false;
+    atomic<bool> is_started = false;
+    atomic<bool> is_stopped = false;
+    thread other_thread([&] {
+        is_started = true;
+        while (!is_stopped) {
+            this_thread::yield();
+        }
+    });
+    while (!is_started) {
+        this_thread::yield();
+    }
+    try {
+        ShardProcess process(corpus.stop_words);
+    } catch (const logic_error&) {
+        is_thrown = true;
+    }
+    is_stopped = true;
+    other_thread.join();
+    assert(is_thrown);
+}
+
+void TestPagination() {
+    const TestCorpus corpus = MakeRandomCorpus(400, 37);
+    SearchServer search_server(corpus.stop_words);
+    AddCorpus(search_server, corpus);
+    const ReferenceRanking reference(corpus);
+
+    // Pages follow each other without gaps or repeats, down to the last document found
+    for (const string& query : MakeRandomQueries(20, 38)) {
+        for (const size_t page_size : {1, 3, 7, 1000}) {
+            vector<Document> documents;
+            SearchCursor cursor;
+            while (!cursor.IsEnd()) {
+                // Clients get the cursor back as a string
+                const DocumentPage page = search_server.FindDocumentsPage(query, SearchCursor::FromString(cursor.ToString()), page_size,
+                                                                          DocumentStatus::BANNED);
+                assert(page.documents.size() <= page_size);
+                assert(page.next_cursor.IsEnd() == (page.documents.size() < page_size));
+                documents.insert(documents.end(), page.documents.begin(), page.documents.end());
+                cursor = page.next_cursor;
+            }
+            AssertSameDocuments(documents, reference.FindAllDocuments(query, DocumentStatus::BANNED));
+            assert(search_server.FindDocumentsPage(query, cursor, page_size).documents.empty());
+        }
+        // The first page is the top documents
+        AssertSameDocuments(search_server.FindDocumentsPage(query, {}, MAX_RESULT_DOCUMENT_COUNT).documents,
+                            search_server.FindTopDocuments(query));
+    }
+
+    // A document added after a page is found on a later page only if it ranks below the cursor
+    const DocumentPage first_page = search_server.FindDocumentsPage("cat"s, {}, 3);
+    search_server.AddDocument(10'000, "cat cat cat"s, DocumentStatus::ACTUAL, {});
+    const DocumentPage second_page = search_server.FindDocumentsPage("cat"s, first_page.next_cursor, 3);
+    for (const Document& document : second_page.documents) {
+        assert(document.id != 10'000 && !IsRankedHigher(document, first_page.documents.back()));
+    }
+
+    AssertThrowsInvalidArgument([&] { search_server.FindDocumentsPage("cat"s, {}, 0); });
+    AssertThrowsInvalidArgument([] { SearchCursor::FromString("not a cursor"s); });
+    assert(SearchCursor::FromString(SearchCursor().ToString()) == SearchCursor());
+}
+
+// Ranks the documents of a corpus by the textbook Okapi BM25 formula, word counts and all
+vector<Document> FindBm25Documents(const TestCorpus& corpus, string_view raw_query, DocumentStatus status) {
+    const set<string, less<>> stop_words(corpus.stop_words.begin(), corpus.stop_words.end());
+    map<int, map<string, int>> document_word_counts;
+    map<int, int> document_lengths;
+    map<string, int> document_freqs;
+    double length_sum = 0.0;
+    for (const auto& [id, document] : corpus.documents) {
+        for (const string_view word : SplitIntoWords(document.text)) {
+            if (stop_words.count(word) == 0) {
+                ++document_word_counts[id][string(word)];
+                ++document_lengths[id];
+            }
+        }
+        for (const auto& [word, _] : document_word_counts[id]) {
+            ++document_freqs[word];
+        }
+        length_sum += document_lengths[id];
+    }
+    const double document_count = corpus.documents.size();
+    const double average_length = length_sum / document_count;
+
+    set<string> plus_words;
+    set<string> minus_words;
+    for (const string_view word : SplitIntoWords(raw_query)) {
+        const bool is_minus = word[0] == '-';
+        const string data(is_minus ? word.substr(1) : word);
+        if (stop_words.count(data) == 0) {
+            (is_minus ? minus_words : plus_words).insert(data);
+        }
+    }
+
+    vector<Document> documents;
+    for (const auto& [id, document] : corpus.documents) {
+        const auto& word_counts = document_word_counts[id];
+        if (document.status != status || any_of(minus_words.begin(), minus_words.end(), [&word_counts](const string& word) {
+                return word_counts.count(word) > 0;
+            })) {
+            continue;
+        }
+        double relevance = 0.0;
+        bool is_found = false;
+        for (const string& word : plus_words) {
+            if (const auto it = word_counts.find(word); it != word_counts.end()) {
+                const double idf = log(1.0 + (document_count - document_freqs[word] + 0.5) / (document_freqs[word] + 0.5));
+                const double length_norm = Bm25Scoring::K1 * (1.0 - Bm25Scoring::B + Bm25Scoring::B * document_lengths[id] / average_length);
+                relevance += idf * it->second * (Bm25Scoring::K1 + 1.0) / (it->second + length_norm);
+                is_found = true;
+            }
+        }
+        if (is_found) {
+            const int rating = document.ratings.empty() ? 0 : accumulate(document.ratings.begin(), document.ratings.end(), 0) / static_cast<int>(document.ratings.size());
+            documents.push_back({id, relevance, rating});
+        }
+    }
+    sort(documents.begin(), documents.end(), IsRankedHigher);
+    documents.resize(min<size_t>(documents.size(), MAX_RESULT_DOCUMENT_COUNT));
+    return documents;
+}
+
+void TestBm25Scoring() {
+    const TestCorpus corpus = MakeRandomCorpus(500, 39);
+    BasicSearchServer<Bm25Scoring> search_server(corpus.stop_words);
+    AddCorpus(search_server, corpus);
+    const string path = MakeTestFilePath("bm25"s);
+    search_server.SaveSnapshot(path);
+    const auto snapshot_server = BasicSearchServer<Bm25Scoring>::OpenSnapshot(path);
+    filesystem::remove(path);
+
+    for (const string& query : MakeRandomQueries(50, 40)) {
+        const auto expected = FindBm25Documents(corpus, query, DocumentStatus::ACTUAL);
+        AssertSameDocuments(search_server.FindTopDocuments(query), expected);
+        AssertSameDocuments(search_server.FindTopDocuments(execution::par, query), expected);
+        AssertSameDocuments(snapshot_server.FindTopDocuments(execution::par, query), expected);
+        AssertSameDocuments(search_server.FindTopDocuments(execution::par, query, DocumentStatus::BANNED),
+                            FindBm25Documents(corpus, query, DocumentStatus::BANNED));
+        const auto has_positive_rating = [](int, DocumentStatus, int rating) {
+            return rating > 0;
+        };
+        AssertSameDocuments(search_server.FindTopDocuments(execution::par, query, has_positive_rating),
+                            search_server.FindTopDocuments(query, has_positive_rating));
+    }
+
+    // Parts of a collection searched with their summed statistics rank as the whole, average
+    // document length included, as shards and segments do. The parts also hold documents
+    // removed from the collection, which are left out as a segment leaves them out
+    TestCorpus collection = corpus;
+    set<int> removed_ids;
+    for (const auto& [id, _] : corpus.documents) {
+        if (id % 7 == 0) {
+            removed_ids.insert(id);
+            collection.documents.erase(id);
+        }
+    }
+    vector<unique_ptr<BasicSearchServer<Bm25Scoring>>> parts;
+    for (int i = 0; i < 3; ++i) {
+        parts.push_back(make_unique<BasicSearchServer<Bm25Scoring>>(corpus.stop_words));
+    }
+    for (const auto& [id, document] : corpus.documents) {
+        parts[id / 3 % parts.size()]->AddDocument(id, document.text, document.status, document.ratings);
+    }
+    const auto is_visible_actual = [&removed_ids](int document_id, DocumentStatus status, int) {
+        return removed_ids.count(document_id) == 0 && status == DocumentStatus::ACTUAL;
+    };
+    for (const string& query : MakeRandomQueries(50, 42)) {
+        QueryStatistics statistics;
+        for (const auto& part : parts) {
+            statistics += part->GetQueryStatistics(query, removed_ids);
+        }
+        TopDocuments top_documents(MAX_RESULT_DOCUMENT_COUNT);
+        for (const auto& part : parts) {
+            for (const Document& document : part->FindTopDocuments(execution::seq, query, is_visible_actual, statistics)) {
+                top_documents.Add(document);
+            }
+        }
+        AssertSameDocuments(top_documents.Extract(), FindBm25Documents(collection, query, DocumentStatus::ACTUAL));
+    }
+
+}
+
+void TestAddDocuments() {
+    const TestCorpus corpus = MakeRandomCorpus(3000, 41);
+    vector<DocumentInput> documents;
+    for (const auto& [id, document] : corpus.documents) {
+        documents.push_back({id, document.text, document.status, document.ratings});
+    }
+    // Both servers keep positions, so that phrases are compared too
+    SearchServer search_server(corpus.stop_words);
+    SearchServer batch_server(corpus.stop_words);
+    search_server.EnablePositions();
+    batch_server.EnablePositions();
+    AddCorpus(search_server, corpus);
+    batch_server.AddDocuments(vector<DocumentInput>(documents.begin(), documents.begin() + 1000));
+    batch_server.AddDocuments(vector<DocumentInput>(documents.begin() + 1000, documents.end()));
+
+    assert(batch_server.GetDocumentCount() == search_server.GetDocumentCount());
+    assert(equal(batch_server.begin(), batch_server.end(), search_server.begin(), search_server.end()));
+    for (const auto& [id, _] : corpus.documents) {
+        assert(batch_server.GetWordFrequencies(id) == search_server.GetWordFrequencies(id));
+    }
+    vector<string> queries = MakeRandomQueries(30, 42);
+    queries.insert(queries.end(), {"\"cat dog\""s, "\"pet and rat\"~1 hair"s, "ca* -big"s});
+    for (const string& query : queries) {
+        AssertSameDocuments(batch_server.FindTopDocuments(query), search_server.FindTopDocuments(query));
+        AssertSameDocuments(batch_server.FindTopDocuments(execution::par, query, DocumentStatus::BANNED),
+                            search_server.FindTopDocuments(query, DocumentStatus::BANNED));
+    }
+
+    // A batch with an invalid document adds none of its documents. The documents refer to
+    // their texts, so these are literals rather than temporary strings
+    const vector<vector<DocumentInput>> invalid_batches = {
+        {{20'000, "cat"sv, DocumentStatus::ACTUAL, {}}, {20'001, "d\x01og"sv, DocumentStatus::ACTUAL, {}}},
+        {{20'000, "cat"sv, DocumentStatus::ACTUAL, {}}, {1, "dog"sv, DocumentStatus::ACTUAL, {}}},
+        {{20'000, "cat"sv, DocumentStatus::ACTUAL, {}}, {20'000, "dog"sv, DocumentStatus::ACTUAL, {}}},
+        {{20'000, "cat"sv, DocumentStatus::ACTUAL, {}}, {-1, "dog"sv, DocumentStatus::ACTUAL, {}}},
+    };
+    for (const auto& batch : invalid_batches) {
+        AssertThrowsInvalidArgument([&] { batch_server.AddDocuments(batch); });
+        assert(batch_server.GetDocumentCount() == search_server.GetDocumentCount());
+        AssertSameDocuments(batch_server.FindTopDocuments("cat dog"s), search_server.FindTopDocuments("cat dog"s));
+    }
+    batch_server.AddDocuments(vector<DocumentInput>{});
+    assert(batch_server.GetDocumentCount() == search_server.GetDocumentCount());
+}
+
+void TestTokenizer() {
+    // Runs of spaces, letters, bytes above 0x7F and rare control characters, in texts
+    // long and short enough to end inside and between vector blocks
+    mt19937 generator(43);
+    const string alphabet = "  ab\x80\xff"s;
+    for (int i = 0; i < 2000; ++i) {
+        string text(uniform_int_distribution<size_t>(0, 100)(generator), ' ');
+        for (char& c : text) {
+            c = uniform_int_distribution<int>(0, 199)(generator) == 0 ? static_cast<char>(uniform_int_distribution<int>(0, 0x1F)(generator))
+                                                                      : alphabet[uniform_int_distribution<size_t>(0, alphabet.size() - 1)(generator)];
+        }
+        vector<string_view> expected_words;
+        size_t word_begin = text.find_first_not_of(' ');
+        while (word_begin != string::npos) {
+            const size_t word_end = min(text.find(' ', word_begin), text.size());
+            expected_words.push_back(string_view(text).substr(word_begin, word_end - word_begin));
+            word_begin = text.find_first_not_of(' ', word_end);
+        }
+        const auto control = find_if(text.begin(), text.end(), [](char c) {
+            return static_cast<unsigned char>(c) < 0x20;
+        });
+        const size_t expected_offset = control == text.end() ? string_view::npos : static_cast<size_t>(control - text.begin());
+
+        for (const TokenizerIsa isa : {TokenizerIsa::SCALAR, TokenizerIsa::SSE2, TokenizerIsa::AVX2}) {
+            if (!IsTokenizerIsaSupported(isa)) {
+                AssertThrowsInvalidArgument([&] {
+                    vector<string_view> words;
+                    TokenizeWords(text, words, isa);
+                });
+                continue;
+            }
+            // Words are appended to the ones already there
+            vector<string_view> words = {"previous"sv};
+            assert(TokenizeWords(text, words, isa) == expected_offset);
+            assert(words.front() == "previous"sv);
+            assert(equal(words.begin() + 1, words.end(), expected_words.begin(), expected_words.end(),
+                         [](string_view lhs, string_view rhs) {
+                             return lhs.data() == rhs.data() && lhs.size() == rhs.size();
+                         }));
+        }
+    }
+    assert(IsTokenizerIsaSupported(GetTokenizerIsa()));
+}
+
+}  // namespace
+
+void TestSearchServer() {
+    TestShardedSearchServer();
+    TestExecutionPolicies();
+    TestIndexMatchesReference();
+    TestCompressedPostingLists();
+    TestRemoveDocument();
+    TestRemoveDuplicates();
+    TestProcessQueries();
+    TestParsing();
+    TestTopDocumentsPruning();
+    TestSnapshots();
+    TestCorruptSnapshots();
+    TestDocumentIds();
+    TestQueryCache();
+    TestSegmentedSearchServer();
+    TestConcurrentSearchServer();
+    TestCorpusGenerator();
+    TestRequestQueue();
+    TestMatchDocument();
+    TestPhraseQueries();
+    TestPrefixQueries();
+    TestFuzzyQueries();
+    TestDocumentBitmap();
+    TestStatusFilters();
+    TestRelevanceAccumulator();
+    TestParallelRanges();
+    TestPagination();
+    TestBm25Scoring();
+    TestAddDocuments();
+    TestTokenizer();
+    cout << "Search server tests passed"s << endl;
+}
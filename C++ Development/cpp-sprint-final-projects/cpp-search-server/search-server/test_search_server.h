@@ -0,0 +1,4 @@
+#pragma once
+
+// Runs every test of the search server; a failed check aborts with assert
+void TestSearchServer();
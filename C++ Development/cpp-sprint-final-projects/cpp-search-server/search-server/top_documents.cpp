@@ -0,0 +1,37 @@
+#include "top_documents.h"
+#include <algorithm>
+
+TopDocuments::TopDocuments(size_t capacity)
+    : capacity_(capacity) {
+    heap_.reserve(capacity);
+}
+
+bool TopDocuments::Add(const Document& document) {
+    if (heap_.size() < capacity_) {
+        heap_.push_back(document);
+        std::push_heap(heap_.begin(), heap_.end(), IsRankedHigher);
+        return true;
+    }
+    if (capacity_ == 0 || !IsRankedHigher(document, heap_.front())) {
+        return false;
+    }
+    std::pop_heap(heap_.begin(), heap_.end(), IsRankedHigher);
+    heap_.back() = document;
+    std::push_heap(heap_.begin(), heap_.end(), IsRankedHigher);
+    return true;
+}
+
+bool TopDocuments::IsFull() const {
+    return heap_.size() == capacity_;
+}
+
+const Document& TopDocuments::GetWorst() const {
+    return heap_.front();
+}
+
+std::vector<Document> TopDocuments::Extract() {
+    std::sort_heap(heap_.begin(), heap_.end(), IsRankedHigher);
+    std::vector<Document> documents = std::move(heap_);
+    heap_.clear();
+    return documents;
+}
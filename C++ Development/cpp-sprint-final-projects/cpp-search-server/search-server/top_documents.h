@@ -0,0 +1,23 @@
+#pragma once
+
+#include <vector>
+#include "document.h"
+
+// Keeps the best documents seen so far in a min-heap bounded by capacity,
+// so selecting them out of n candidates takes O(n log capacity) instead of a full sort
+class TopDocuments {
+public:
+    explicit TopDocuments(size_t capacity);
+
+    // Returns true if the document is kept
+    bool Add(const Document& document);
+    bool IsFull() const;
+    // The lowest ranked of the kept documents; the collector must not be empty
+    const Document& GetWorst() const;
+    // Returns the kept documents, best first, and leaves the collector empty
+    std::vector<Document> Extract();
+
+private:
+    size_t capacity_;
+    std::vector<Document> heap_;
+};